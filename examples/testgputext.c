@@ -4,31 +4,38 @@
 
 // Shaders
 #include "testgputext/shaders/shader.vert.spv.h"
+#include "testgputext/shaders/shader-instanced.vert.spv.h"
 #include "testgputext/shaders/shader.frag.spv.h"
 #include "testgputext/shaders/shader-solid.frag.spv.h"
 #include "testgputext/shaders/shader-sdf.frag.spv.h"
+#include "testgputext/shaders/shader-msdf.frag.spv.h"
 #include "testgputext/shaders/shader.vert.dxil.h"
 #include "testgputext/shaders/shader.frag.dxil.h"
 #include "testgputext/shaders/shader-solid.frag.dxil.h"
 #include "testgputext/shaders/shader-sdf.frag.dxil.h"
 #include "testgputext/shaders/shader.vert.msl.h"
+#include "testgputext/shaders/shader-instanced.vert.msl.h"
 #include "testgputext/shaders/shader.frag.msl.h"
 #include "testgputext/shaders/shader-solid.frag.msl.h"
 #include "testgputext/shaders/shader-sdf.frag.msl.h"
+#include "testgputext/shaders/shader-msdf.frag.msl.h"
 
 #define SDL_MATH_3D_IMPLEMENTATION
 #include "testgputext/SDL_math3d.h"
 
 #define MAX_VERTEX_COUNT 4000
 #define MAX_INDEX_COUNT  6000
+#define MAX_INSTANCE_COUNT (MAX_VERTEX_COUNT / 4)
 #define SUPPORTED_SHADER_FORMATS (SDL_GPU_SHADERFORMAT_SPIRV | SDL_GPU_SHADERFORMAT_DXIL | SDL_GPU_SHADERFORMAT_MSL)
 
 typedef enum
 {
     VertexShader,
+    VertexShader_Instanced,
     PixelShader,
     PixelShader_Solid,
     PixelShader_SDF,
+    PixelShader_MSDF,
 } Shader;
 
 typedef SDL_FPoint Vec2;
@@ -45,6 +52,13 @@ typedef struct Vertex
     Vec2 uv;
 } Vertex;
 
+typedef struct InstancedUniforms
+{
+    SDL_Mat4X4 proj_view;
+    SDL_Mat4X4 model;
+    SDL_FColor colour;
+} InstancedUniforms;
+
 typedef struct Context
 {
     SDL_GPUDevice *device;
@@ -56,6 +70,7 @@ typedef struct Context
     SDL_GPUTransferBuffer *transfer_buffer;
     SDL_GPUSampler *sampler;
     SDL_GPUCommandBuffer *cmd_buf;
+    bool instanced;
 } Context;
 
 typedef struct GeometryData
@@ -64,6 +79,8 @@ typedef struct GeometryData
     int vertex_count;
     int *indices;
     int index_count;
+    TTF_TextInstance *instances;
+    int instance_count;
 } GeometryData;
 
 void check_error_bool(const bool res)
@@ -106,6 +123,10 @@ SDL_GPUShader *load_shader(
             createinfo.code_size = shader_vert_dxil_len;
             createinfo.entrypoint = "VSMain";
             break;
+        case VertexShader_Instanced:
+            // The device is created without DXIL support when this is needed
+            SDL_SetError("The instanced vertex shader isn't available as DXIL");
+            return NULL;
         case PixelShader:
             createinfo.code = shader_frag_dxil;
             createinfo.code_size = shader_frag_dxil_len;
@@ -121,6 +142,10 @@ SDL_GPUShader *load_shader(
             createinfo.code_size = shader_sdf_frag_dxil_len;
             createinfo.entrypoint = "PSMain";
             break;
+        case PixelShader_MSDF:
+            // The device is created without DXIL support when this is needed
+            SDL_SetError("The MSDF shader isn't available as DXIL");
+            return NULL;
         }
     } else if (format & SDL_GPU_SHADERFORMAT_MSL) {
         createinfo.format = SDL_GPU_SHADERFORMAT_MSL;
@@ -130,6 +155,11 @@ SDL_GPUShader *load_shader(
             createinfo.code_size = shader_vert_msl_len;
             createinfo.entrypoint = "main0";
             break;
+        case VertexShader_Instanced:
+            createinfo.code = shader_instanced_vert_msl;
+            createinfo.code_size = shader_instanced_vert_msl_len;
+            createinfo.entrypoint = "main0";
+            break;
         case PixelShader:
             createinfo.code = shader_frag_msl;
             createinfo.code_size = shader_frag_msl_len;
@@ -145,6 +175,11 @@ SDL_GPUShader *load_shader(
             createinfo.code_size = shader_sdf_frag_msl_len;
             createinfo.entrypoint = "main0";
             break;
+        case PixelShader_MSDF:
+            createinfo.code = shader_msdf_frag_msl;
+            createinfo.code_size = shader_msdf_frag_msl_len;
+            createinfo.entrypoint = "main0";
+            break;
         }
     } else {
         createinfo.format = SDL_GPU_SHADERFORMAT_SPIRV;
@@ -154,6 +189,11 @@ SDL_GPUShader *load_shader(
             createinfo.code_size = shader_vert_spv_len;
             createinfo.entrypoint = "main";
             break;
+        case VertexShader_Instanced:
+            createinfo.code = shader_instanced_vert_spv;
+            createinfo.code_size = shader_instanced_vert_spv_len;
+            createinfo.entrypoint = "main";
+            break;
         case PixelShader:
             createinfo.code = shader_frag_spv;
             createinfo.code_size = shader_frag_spv_len;
@@ -169,10 +209,15 @@ SDL_GPUShader *load_shader(
             createinfo.code_size = shader_sdf_frag_spv_len;
             createinfo.entrypoint = "main";
             break;
+        case PixelShader_MSDF:
+            createinfo.code = shader_msdf_frag_spv;
+            createinfo.code_size = shader_msdf_frag_spv_len;
+            createinfo.entrypoint = "main";
+            break;
         }
     }
 
-    if (shader == VertexShader) {
+    if (shader == VertexShader || shader == VertexShader_Instanced) {
         createinfo.stage = SDL_GPU_SHADERSTAGE_VERTEX;
     } else {
         createinfo.stage = SDL_GPU_SHADERSTAGE_FRAGMENT;
@@ -182,6 +227,13 @@ SDL_GPUShader *load_shader(
 
 void queue_text_sequence(GeometryData *geometry_data, TTF_GPUAtlasDrawSequence *sequence, SDL_FColor *colour)
 {
+    if (sequence->instances) {
+        // The colour is passed as a uniform instead
+        SDL_memcpy(geometry_data->instances + geometry_data->instance_count, sequence->instances, sequence->num_instances * sizeof(TTF_TextInstance));
+        geometry_data->instance_count += sequence->num_instances;
+        return;
+    }
+
     for (int i = 0; i < sequence->num_vertices; i++) {
         Vertex *vert = &geometry_data->vertices[geometry_data->vertex_count + i];
         const SDL_FPoint *pos = &sequence->xy[i];
@@ -210,8 +262,12 @@ void set_geometry_data(Context *context, GeometryData *geometry_data)
 {
     Vertex *transfer_data = SDL_MapGPUTransferBuffer(context->device, context->transfer_buffer, false);
 
-    SDL_memcpy(transfer_data, geometry_data->vertices, sizeof(Vertex) * geometry_data->vertex_count);
-    SDL_memcpy(transfer_data + MAX_VERTEX_COUNT, geometry_data->indices, sizeof(int) * geometry_data->index_count);
+    if (context->instanced) {
+        SDL_memcpy(transfer_data, geometry_data->instances, sizeof(TTF_TextInstance) * geometry_data->instance_count);
+    } else {
+        SDL_memcpy(transfer_data, geometry_data->vertices, sizeof(Vertex) * geometry_data->vertex_count);
+        SDL_memcpy(transfer_data + MAX_VERTEX_COUNT, geometry_data->indices, sizeof(int) * geometry_data->index_count);
+    }
 
     SDL_UnmapGPUTransferBuffer(context->device, context->transfer_buffer);
 }
@@ -219,6 +275,21 @@ void set_geometry_data(Context *context, GeometryData *geometry_data)
 void transfer_data(Context *context, GeometryData *geometry_data)
 {
     SDL_GPUCopyPass *copy_pass = check_error_ptr(SDL_BeginGPUCopyPass(context->cmd_buf));
+    if (context->instanced) {
+        // The instances go in the vertex buffer, and no indices are needed
+        SDL_UploadToGPUBuffer(
+            copy_pass,
+            &(SDL_GPUTransferBufferLocation){
+                .transfer_buffer = context->transfer_buffer,
+                .offset = 0 },
+            &(SDL_GPUBufferRegion){
+                .buffer = context->vertex_buffer,
+                .offset = 0,
+                .size = sizeof(TTF_TextInstance) * geometry_data->instance_count },
+            false);
+        SDL_EndGPUCopyPass(copy_pass);
+        return;
+    }
     SDL_UploadToGPUBuffer(
         copy_pass,
         &(SDL_GPUTransferBufferLocation){
@@ -242,7 +313,7 @@ void transfer_data(Context *context, GeometryData *geometry_data)
     SDL_EndGPUCopyPass(copy_pass);
 }
 
-void draw(Context *context, SDL_Mat4X4 *matrices, int num_matrices, TTF_GPUAtlasDrawSequence *draw_sequence)
+void draw(Context *context, SDL_Mat4X4 *matrices, int num_matrices, SDL_FColor *colour, TTF_GPUAtlasDrawSequence *draw_sequence)
 {
     SDL_GPUTexture *swapchain_texture;
     check_error_bool(SDL_WaitAndAcquireGPUSwapchainTexture(context->cmd_buf, context->window, &swapchain_texture, NULL, NULL));
@@ -268,9 +339,17 @@ void draw(Context *context, SDL_Mat4X4 *matrices, int num_matrices, TTF_GPUAtlas
             &(SDL_GPUBufferBinding){
                 .buffer = context->index_buffer, .offset = 0 },
             SDL_GPU_INDEXELEMENTSIZE_32BIT);
-        SDL_PushGPUVertexUniformData(context->cmd_buf, 0, matrices, sizeof(SDL_Mat4X4) * num_matrices);
+        if (context->instanced) {
+            InstancedUniforms uniforms;
+            uniforms.proj_view = matrices[0];
+            uniforms.model = matrices[1];
+            uniforms.colour = *colour;
+            SDL_PushGPUVertexUniformData(context->cmd_buf, 0, &uniforms, sizeof(uniforms));
+        } else {
+            SDL_PushGPUVertexUniformData(context->cmd_buf, 0, matrices, sizeof(SDL_Mat4X4) * num_matrices);
+        }
 
-        int index_offset = 0, vertex_offset = 0;
+        int index_offset = 0, vertex_offset = 0, instance_offset = 0;
         for (TTF_GPUAtlasDrawSequence *seq = draw_sequence; seq != NULL; seq = seq->next) {
             if (seq->atlas_texture) {
                 if (solid_pipeline) {
@@ -290,6 +369,13 @@ void draw(Context *context, SDL_Mat4X4 *matrices, int num_matrices, TTF_GPUAtlas
                 }
             }
 
+            if (context->instanced) {
+                // Each instance is a quad drawn as a triangle strip
+                SDL_DrawGPUPrimitives(render_pass, 4, seq->num_instances, 0, instance_offset);
+                instance_offset += seq->num_instances;
+                continue;
+            }
+
             SDL_DrawGPUIndexedPrimitives(render_pass, seq->num_indices, 1, index_offset, vertex_offset, 0);
 
             index_offset += seq->num_indices;
@@ -316,12 +402,18 @@ int main(int argc, char *argv[])
 {
     const char *font_filename = NULL;
     bool use_SDF = false;
+    bool use_MSDF = false;
+    bool use_instanced = false;
     int style;
 
     (void)argc;
     for (int i = 1; argv[i]; ++i) {
         if (SDL_strcasecmp(argv[i], "--sdf") == 0) {
             use_SDF = true;
+        } else if (SDL_strcasecmp(argv[i], "--msdf") == 0) {
+            use_MSDF = true;
+        } else if (SDL_strcasecmp(argv[i], "--instanced") == 0) {
+            use_instanced = true;
         } else if (*argv[i] == '-') {
             break;
         } else {
@@ -330,7 +422,7 @@ int main(int argc, char *argv[])
         }
     }
     if (!font_filename) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Usage: testgputext [--sdf] FONT_FILENAME");
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Usage: testgputext [--sdf] [--msdf] [--instanced] FONT_FILENAME");
         return 2;
     }
 
@@ -341,11 +433,17 @@ int main(int argc, char *argv[])
 
     context.window = check_error_ptr(SDL_CreateWindow("GPU text test", 800, 600, 0));
 
-    context.device = check_error_ptr(SDL_CreateGPUDevice(SUPPORTED_SHADER_FORMATS, true, NULL));
+    SDL_GPUShaderFormat shader_formats = SUPPORTED_SHADER_FORMATS;
+    if (use_MSDF || use_instanced) {
+        // The MSDF and instanced shaders are only available as SPIR-V and MSL
+        shader_formats &= ~SDL_GPU_SHADERFORMAT_DXIL;
+    }
+    context.device = check_error_ptr(SDL_CreateGPUDevice(shader_formats, true, NULL));
     check_error_bool(SDL_ClaimWindowForGPUDevice(context.device, context.window));
 
-    SDL_GPUShader *vertex_shader = check_error_ptr(load_shader(context.device, VertexShader, 0, 1, 0, 0));
-    SDL_GPUShader *fragment_shader = check_error_ptr(load_shader(context.device, use_SDF ? PixelShader_SDF : PixelShader, 1, 0, 0, 0));
+    context.instanced = use_instanced;
+    SDL_GPUShader *vertex_shader = check_error_ptr(load_shader(context.device, use_instanced ? VertexShader_Instanced : VertexShader, 0, 1, 0, 0));
+    SDL_GPUShader *fragment_shader = check_error_ptr(load_shader(context.device, use_MSDF ? PixelShader_MSDF : use_SDF ? PixelShader_SDF : PixelShader, 1, 0, 0, 0));
     SDL_GPUShader *solid_shader = check_error_ptr(load_shader(context.device, PixelShader_Solid, 0, 0, 0, 0));
 
     SDL_GPUGraphicsPipelineCreateInfo pipeline_create_info = {
@@ -397,6 +495,29 @@ int main(int argc, char *argv[])
         .vertex_shader = vertex_shader,
         .fragment_shader = fragment_shader
     };
+    SDL_GPUVertexBufferDescription instance_buffer_description = {
+        .slot = 0,
+        .input_rate = SDL_GPU_VERTEXINPUTRATE_INSTANCE,
+        .instance_step_rate = 0,
+        .pitch = sizeof(TTF_TextInstance)
+    };
+    SDL_GPUVertexAttribute instance_attributes[] = {{
+        .buffer_slot = 0,
+        .format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT4,
+        .location = 0,
+        .offset = 0
+    }, {
+        .buffer_slot = 0,
+        .format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT4,
+        .location = 1,
+        .offset = sizeof(SDL_FRect)
+    }};
+    if (use_instanced) {
+        pipeline_create_info.vertex_input_state.vertex_buffer_descriptions = &instance_buffer_description;
+        pipeline_create_info.vertex_input_state.num_vertex_attributes = SDL_arraysize(instance_attributes);
+        pipeline_create_info.vertex_input_state.vertex_attributes = instance_attributes;
+        pipeline_create_info.primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLESTRIP;
+    }
     context.pipeline = check_error_ptr(SDL_CreateGPUGraphicsPipeline(context.device, &pipeline_create_info));
     pipeline_create_info.fragment_shader = solid_shader;
     context.solid_pipeline = check_error_ptr(SDL_CreateGPUGraphicsPipeline(context.device, &pipeline_create_info));
@@ -436,16 +557,26 @@ int main(int argc, char *argv[])
     GeometryData geometry_data = { 0 };
     geometry_data.vertices = SDL_calloc(MAX_VERTEX_COUNT, sizeof(Vertex));
     geometry_data.indices = SDL_calloc(MAX_INDEX_COUNT, sizeof(int));
+    geometry_data.instances = SDL_calloc(MAX_INSTANCE_COUNT, sizeof(TTF_TextInstance));
 
     check_error_bool(TTF_Init());
     TTF_Font *font = check_error_ptr(TTF_OpenFont(font_filename, 50)); /* Preferably use a Monospaced font */
     if (!font) {
         running = false;
     }
-    SDL_Log("SDF %s", use_SDF ? "enabled" : "disabled");
-    TTF_SetFontSDF(font, use_SDF);
+    if (use_MSDF) {
+        SDL_Log("MSDF enabled");
+        check_error_bool(TTF_SetFontMSDF(font, true));
+    } else {
+        SDL_Log("SDF %s", use_SDF ? "enabled" : "disabled");
+        TTF_SetFontSDF(font, use_SDF);
+    }
     TTF_SetFontWrapAlignment(font, TTF_HORIZONTAL_ALIGN_CENTER);
     TTF_TextEngine *engine = check_error_ptr(TTF_CreateGPUTextEngine(context.device));
+    if (use_instanced) {
+        SDL_Log("Instanced drawing enabled");
+        TTF_SetGPUTextEngineVertexFormat(engine, TTF_TEXT_VERTEX_FORMAT_INSTANCED);
+    }
 
     char str[] = "     \nSDL is cool";
     TTF_Text *text = check_error_ptr(TTF_CreateText(engine, font, str, 0));
@@ -527,15 +658,17 @@ int main(int argc, char *argv[])
 
         context.cmd_buf = check_error_ptr(SDL_AcquireGPUCommandBuffer(context.device));
         transfer_data(&context, &geometry_data);
-        draw(&context, matrices, 2, sequence);
+        draw(&context, matrices, 2, &colour, sequence);
         SDL_SubmitGPUCommandBuffer(context.cmd_buf);
 
         geometry_data.vertex_count = 0;
         geometry_data.index_count = 0;
+        geometry_data.instance_count = 0;
     }
 
     SDL_free(geometry_data.vertices);
     SDL_free(geometry_data.indices);
+    SDL_free(geometry_data.instances);
     TTF_DestroyText(text);
     TTF_DestroyGPUTextEngine(engine);
     TTF_CloseFont(font);
@@ -0,0 +1,40 @@
+// Vertex shader for TTF_TEXT_VERTEX_FORMAT_INSTANCED draw sequences.
+// Bind the TTF_TextInstance array as a per-instance vertex buffer and draw
+// 4 vertices (triangle strip) per instance, one instance per glyph.
+
+cbuffer uniforms : register(b0, space1)
+{
+    row_major float4x4 proj_view : packoffset(c0);
+    row_major float4x4 model : packoffset(c4);
+    float4 color : packoffset(c8);
+};
+
+struct VSInput
+{
+    float4 dst : TEXCOORD0;
+    float4 uv : TEXCOORD1;
+    uint vertex_id : SV_VertexID;
+};
+
+struct VSOutput
+{
+    float4 color : TEXCOORD0;
+    float2 tex_coord : TEXCOORD1;
+    float4 position : SV_Position;
+};
+
+VSOutput main(VSInput input)
+{
+    // Strip order: upper left, upper right, lower left, lower right
+    float2 corner = float2(input.vertex_id & 1, input.vertex_id >> 1);
+
+    // dst.xy is the upper left corner with the y-axis pointing up
+    float2 position = float2(input.dst.x + corner.x * input.dst.z,
+                             input.dst.y - corner.y * input.dst.w);
+
+    VSOutput output;
+    output.color = color;
+    output.tex_coord = input.uv.xy + corner * input.uv.zw;
+    output.position = mul(float4(position, 0.0f, 1.0f), mul(model, proj_view));
+    return output;
+}
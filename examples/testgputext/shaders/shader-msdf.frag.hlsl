@@ -0,0 +1,26 @@
+Texture2D<float4> tex : register(t0, space2);
+SamplerState samp : register(s0, space2);
+
+struct PSInput {
+    float4 color : TEXCOORD0;
+    float2 tex_coord : TEXCOORD1;
+};
+
+struct PSOutput {
+    float4 color : SV_Target;
+};
+
+float median(float r, float g, float b) {
+    return max(min(r, g), min(max(r, g), b));
+}
+
+PSOutput main(PSInput input) {
+    PSOutput output;
+    float4 msdf = tex.Sample(samp, input.tex_coord);
+    float distance = median(msdf.r, msdf.g, msdf.b);
+    // Smooth over about one screen pixel, whatever scale the glyphs are drawn at
+    float smoothing = max(fwidth(distance), 1.0 / 255.0);
+    float alpha = smoothstep(0.5 - smoothing, 0.5 + smoothing, distance);
+    output.color = float4(input.color.rgb, input.color.a * alpha);
+    return output;
+}
@@ -125,6 +125,8 @@ struct TTF_TextData
     bool needs_engine_update;   /**< True if the engine text needs to be updated */
     TTF_TextEngine *engine;     /**< The engine used to render this text, read-only. */
     void *engine_text;          /**< The implementation-specific representation of this text */
+
+    float *subpixel_offsets;    /**< The horizontal subpixel offset of the glyph in each drawing operation, in fractions of a pixel, or NULL if the text isn't positioned with subpixel precision, read-only. These can be passed to TTF_GetSubpixelGlyphImageForIndex(). */
 };
 
 /**
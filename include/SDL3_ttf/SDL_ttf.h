@@ -289,6 +289,10 @@ extern SDL_DECLSPEC SDL_PropertiesID SDLCALL TTF_GetFontProperties(TTF_Font *fon
  * The generation is incremented each time font properties change that require
  * rebuilding glyphs, such as style, size, etc.
  *
+ * When the font switches back to recently used properties whose glyphs are
+ * still cached, it returns to the generation it had with those properties,
+ * so anything built from that generation's glyphs can be reused.
+ *
  * \param font the font to query.
  * \returns the font generation or 0 on failure; call SDL_GetError() for more
  *          information.
@@ -300,6 +304,93 @@ extern SDL_DECLSPEC SDL_PropertiesID SDLCALL TTF_GetFontProperties(TTF_Font *fon
  */
 extern SDL_DECLSPEC Uint32 SDLCALL TTF_GetFontGeneration(TTF_Font *font);
 
+/**
+ * Set the memory budget for glyphs of inactive font configurations.
+ *
+ * When the size, style, outline, hinting or SDF settings of a font change,
+ * the glyphs and glyph positions of the previous settings are kept, so
+ * switching back to them doesn't need to render them again. The least
+ * recently used settings are discarded when their glyphs use more memory
+ * than this budget.
+ *
+ * The default budget is 4 MB. Setting it to 0 discards the glyphs of the
+ * previous settings each time they change.
+ *
+ * \param font the font to modify.
+ * \param bytes the number of bytes of glyph images to keep.
+ * \returns true on success or false on failure; call SDL_GetError() for more
+ *          information.
+ *
+ * \threadsafety This function should be called on the thread that created the
+ *               font.
+ *
+ * \since This function is available since SDL_ttf 3.4.0.
+ *
+ * \sa TTF_GetFontCacheBudget
+ */
+extern SDL_DECLSPEC bool SDLCALL TTF_SetFontCacheBudget(TTF_Font *font, size_t bytes);
+
+/**
+ * Get the memory budget for glyphs of inactive font configurations.
+ *
+ * \param font the font to query.
+ * \returns the number of bytes of glyph images kept, or 0 on failure; call
+ *          SDL_GetError() for more information.
+ *
+ * \threadsafety This function should be called on the thread that created the
+ *               font.
+ *
+ * \since This function is available since SDL_ttf 3.4.0.
+ *
+ * \sa TTF_SetFontCacheBudget
+ */
+extern SDL_DECLSPEC size_t SDLCALL TTF_GetFontCacheBudget(const TTF_Font *font);
+
+/**
+ * Set whether glyph images of a font are stored compressed.
+ *
+ * Grayscale and monochrome glyph images are run-length encoded once they're
+ * rendered, which typically makes them several times smaller. Only the most
+ * recently used glyph images are also kept decompressed, and the others are
+ * decompressed again when they're needed. This lets memory constrained
+ * applications keep many more glyphs cached before rendering them again.
+ * Color and LCD glyph images are always stored uncompressed.
+ *
+ * Changing whether compression is enabled clears already-generated glyphs,
+ * if any, from the cache.
+ *
+ * \param font the font to modify.
+ * \param hot_glyphs the number of glyph images to keep decompressed, or 0 to
+ *                   store glyph images uncompressed. The default is 0.
+ * \returns true on success or false on failure; call SDL_GetError() for more
+ *          information.
+ *
+ * \threadsafety This function should be called on the thread that created the
+ *               font.
+ *
+ * \since This function is available since SDL_ttf 3.4.0.
+ *
+ * \sa TTF_GetFontGlyphCompression
+ * \sa TTF_SetFontCacheBudget
+ */
+extern SDL_DECLSPEC bool SDLCALL TTF_SetFontGlyphCompression(TTF_Font *font, int hot_glyphs);
+
+/**
+ * Get the number of glyph images a font keeps decompressed.
+ *
+ * \param font the font to query.
+ * \returns the number of glyph images kept decompressed, or 0 if glyph images
+ *          are stored uncompressed.
+ *
+ * \threadsafety This function should be called on the thread that created the
+ *               font.
+ *
+ * \since This function is available since SDL_ttf 3.4.0.
+ *
+ * \sa TTF_SetFontGlyphCompression
+ */
+extern SDL_DECLSPEC int SDLCALL TTF_GetFontGlyphCompression(const TTF_Font *font);
+
 /**
  * Add a fallback font.
  *
@@ -636,6 +727,8 @@ extern SDL_DECLSPEC TTF_HintingFlags SDLCALL TTF_GetFontHinting(const TTF_Font *
  * This works with Blended APIs, and generates the raw signed distance values
  * in the alpha channel of the resulting texture.
  *
+ * This disables multi-channel SDF rendering, if it was enabled.
+ *
  * This updates any TTF_Text objects using this font, and clears
  * already-generated glyphs, if any, from the cache.
  *
@@ -667,6 +760,160 @@ extern SDL_DECLSPEC bool SDLCALL TTF_SetFontSDF(TTF_Font *font, bool enabled);
  */
 extern SDL_DECLSPEC bool SDLCALL TTF_GetFontSDF(const TTF_Font *font);
 
+/**
+ * Enable multi-channel Signed Distance Field rendering for a font.
+ *
+ * MSDF glyphs are generated from the glyph outlines and keep sharp corners
+ * when drawn at much larger sizes than they were rendered at. The median of
+ * the red, green and blue channels has the signed distance to the glyph
+ * outline, and the alpha channel has a regular signed distance field. This
+ * requires special shader support for display.
+ *
+ * Glyphs are laid out as SDF glyphs, and TTF_GetFontSDF() returns true while
+ * MSDF rendering is enabled. Glyphs without outlines and fonts with an
+ * outline set are rendered as regular SDF glyphs.
+ *
+ * This updates any TTF_Text objects using this font, and clears
+ * already-generated glyphs, if any, from the cache.
+ *
+ * \param font the font to set MSDF support on.
+ * \param enabled true to enable MSDF, false to disable.
+ * \returns true on success or false on failure; call SDL_GetError() for more
+ *          information.
+ *
+ * \threadsafety This function should be called on the thread that created the
+ *               font.
+ *
+ * \since This function is available since SDL_ttf 3.4.0.
+ *
+ * \sa TTF_GetFontMSDF
+ * \sa TTF_SetFontSDF
+ * \sa TTF_SetFontSDFReferenceSize
+ */
+extern SDL_DECLSPEC bool SDLCALL TTF_SetFontMSDF(TTF_Font *font, bool enabled);
+
+/**
+ * Query whether multi-channel Signed Distance Field rendering is enabled for
+ * a font.
+ *
+ * \param font the font to query.
+ * \returns true if enabled, false otherwise.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \since This function is available since SDL_ttf 3.4.0.
+ *
+ * \sa TTF_SetFontMSDF
+ */
+extern SDL_DECLSPEC bool SDLCALL TTF_GetFontMSDF(const TTF_Font *font);
+
+/**
+ * Set the spread of Signed Distance Field glyphs for a font.
+ *
+ * The spread is the distance, in pixels of the rendered glyph, over which
+ * the signed distance is encoded around the glyph outline. The default
+ * spread is 8.
+ *
+ * This updates any TTF_Text objects using this font, and clears
+ * already-generated glyphs, if any, from the cache.
+ *
+ * \param font the font to set the SDF spread on.
+ * \param spread the spread in pixels, between 2 and 32.
+ * \returns true on success or false on failure; call SDL_GetError() for more
+ *          information.
+ *
+ * \threadsafety This function should be called on the thread that created the
+ *               font.
+ *
+ * \since This function is available since SDL_ttf 3.4.0.
+ *
+ * \sa TTF_GetFontSDFSpread
+ * \sa TTF_SetFontSDF
+ */
+extern SDL_DECLSPEC bool SDLCALL TTF_SetFontSDFSpread(TTF_Font *font, int spread);
+
+/**
+ * Query the spread of Signed Distance Field glyphs for a font.
+ *
+ * \param font the font to query.
+ * \returns the spread in pixels, or 0 on failure; call SDL_GetError() for
+ *          more information.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \since This function is available since SDL_ttf 3.4.0.
+ *
+ * \sa TTF_SetFontSDFSpread
+ */
+extern SDL_DECLSPEC int SDLCALL TTF_GetFontSDFSpread(const TTF_Font *font);
+
+/**
+ * Set the reference size used to render Signed Distance Field glyphs.
+ *
+ * When a reference size is set, SDF glyphs are rendered once at that size,
+ * in pixels per em, and scaled to the current font size when drawn. Changing
+ * the font size then keeps the SDF glyphs in the cache, so text engines can
+ * keep using the same atlas entries at every size. Glyph images returned by
+ * TTF_GetGlyphImage() are at the reference size, and
+ * TTF_GetFontSDFScale() returns the scale to apply to them.
+ *
+ * The reference size isn't used for bitmap fonts or fonts with an outline.
+ *
+ * This updates any TTF_Text objects using this font, and clears
+ * already-generated glyphs, if any, from the cache.
+ *
+ * \param font the font to set the SDF reference size on.
+ * \param size the reference size in pixels per em, or 0 to render SDF glyphs
+ *             at the current font size.
+ * \returns true on success or false on failure; call SDL_GetError() for more
+ *          information.
+ *
+ * \threadsafety This function should be called on the thread that created the
+ *               font.
+ *
+ * \since This function is available since SDL_ttf 3.4.0.
+ *
+ * \sa TTF_GetFontSDFReferenceSize
+ * \sa TTF_GetFontSDFScale
+ * \sa TTF_SetFontSDF
+ */
+extern SDL_DECLSPEC bool SDLCALL TTF_SetFontSDFReferenceSize(TTF_Font *font, int size);
+
+/**
+ * Query the reference size used to render Signed Distance Field glyphs.
+ *
+ * \param font the font to query.
+ * \returns the reference size in pixels per em, or 0 if SDF glyphs are
+ *          rendered at the current font size.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \since This function is available since SDL_ttf 3.4.0.
+ *
+ * \sa TTF_SetFontSDFReferenceSize
+ */
+extern SDL_DECLSPEC int SDLCALL TTF_GetFontSDFReferenceSize(const TTF_Font *font);
+
+/**
+ * Get the scale from SDF glyph images to the current font size.
+ *
+ * This is 1.0 unless SDF glyphs are rendered at a reference size.
+ *
+ * \param font the font to query.
+ * \param scale_x a pointer filled in with the horizontal scale, may be NULL.
+ * \param scale_y a pointer filled in with the vertical scale, may be NULL.
+ * \returns true on success or false on failure; call SDL_GetError() for more
+ *          information.
+ *
+ * \threadsafety This function should be called on the thread that created the
+ *               font.
+ *
+ * \since This function is available since SDL_ttf 3.4.0.
+ *
+ * \sa TTF_SetFontSDFReferenceSize
+ */
+extern SDL_DECLSPEC bool SDLCALL TTF_GetFontSDFScale(TTF_Font *font, float *scale_x, float *scale_y);
+
 /**
  * Query a font's weight, in terms of the lightness/heaviness of the strokes.
  *
@@ -844,6 +1091,46 @@ extern SDL_DECLSPEC void SDLCALL TTF_SetFontKerning(TTF_Font *font, bool enabled
  */
 extern SDL_DECLSPEC bool SDLCALL TTF_GetFontKerning(const TTF_Font *font);
 
+/**
+ * Set whether shaped words are cached and reused for a font.
+ *
+ * When enabled, left to right text is split after runs of spaces, and each
+ * word is shaped once and cached, so lines of text are assembled from
+ * previously shaped words. This greatly speeds up measuring, wrapping and
+ * laying out text that repeats the same words.
+ *
+ * Shaping features that apply across spaces, such as kerning between a space
+ * and the following glyph, are lost when this is enabled, so this is off by
+ * default.
+ *
+ * This updates any TTF_Text objects using this font.
+ *
+ * \param font the font to modify.
+ * \param enabled true to enable the word cache, false to disable.
+ *
+ * \threadsafety This function should be called on the thread that created the
+ *               font.
+ *
+ * \since This function is available since SDL_ttf 3.4.0.
+ *
+ * \sa TTF_GetFontWordCache
+ */
+extern SDL_DECLSPEC void SDLCALL TTF_SetFontWordCache(TTF_Font *font, bool enabled);
+
+/**
+ * Query whether the word cache is enabled for a font.
+ *
+ * \param font the font to query.
+ * \returns true if the word cache is enabled, false otherwise.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \since This function is available since SDL_ttf 3.4.0.
+ *
+ * \sa TTF_SetFontWordCache
+ */
+extern SDL_DECLSPEC bool SDLCALL TTF_GetFontWordCache(const TTF_Font *font);
+
 /**
  * Query whether a font is fixed-width.
  *
@@ -878,6 +1165,245 @@ extern SDL_DECLSPEC bool SDLCALL TTF_FontIsFixedWidth(const TTF_Font *font);
  */
 extern SDL_DECLSPEC bool SDLCALL TTF_FontIsScalable(const TTF_Font *font);
 
+/**
+ * Set whether bitmap strikes are scaled to the font's point size.
+ *
+ * By default the point size of a non-scalable font, such as a CBDT or sbix
+ * color emoji font, is the index of the bitmap strike to use. When scaling
+ * is enabled the point size is a real point size instead: the nearest
+ * larger strike is selected and each glyph is downsampled once when it is
+ * cached. The font metrics are scaled to match, so the font lines up with
+ * scalable fonts of the same size, e.g. when used as a fallback font.
+ *
+ * This has no effect on scalable fonts.
+ *
+ * This updates any TTF_Text objects using this font.
+ *
+ * \param font the font to modify.
+ * \param enabled true to scale bitmap strikes to the point size, false to
+ *                select strikes by index.
+ * \returns true on success or false on failure; call SDL_GetError() for more
+ *          information.
+ *
+ * \threadsafety This function should be called on the thread that created the
+ *               font.
+ *
+ * \since This function is available since SDL_ttf 3.4.0.
+ *
+ * \sa TTF_GetFontBitmapScaling
+ * \sa TTF_SetFontSize
+ */
+extern SDL_DECLSPEC bool SDLCALL TTF_SetFontBitmapScaling(TTF_Font *font, bool enabled);
+
+/**
+ * Query whether bitmap strikes are scaled to the font's point size.
+ *
+ * \param font the font to query.
+ * \returns true if bitmap strikes are scaled to the point size, false
+ *          otherwise.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \since This function is available since SDL_ttf 3.4.0.
+ *
+ * \sa TTF_SetFontBitmapScaling
+ */
+extern SDL_DECLSPEC bool SDLCALL TTF_GetFontBitmapScaling(const TTF_Font *font);
+
+/**
+ * A collection of indexed fonts, used to find fonts by family or by the
+ * characters they cover without opening them.
+ *
+ * \since This struct is available since SDL_ttf 3.4.0.
+ *
+ * \sa TTF_CreateFontRegistry
+ */
+typedef struct TTF_FontRegistry TTF_FontRegistry;
+
+/**
+ * Create an empty font registry.
+ *
+ * A font registry keeps a compact index of fonts: their family and style
+ * names, weight, and the ranges of Unicode characters they cover. Fonts are
+ * only opened when they're needed, either explicitly with
+ * TTF_OpenFontFromRegistry() or automatically as fallback fonts with
+ * TTF_SetFontRegistry().
+ *
+ * \returns a new font registry or NULL on failure; call SDL_GetError() for
+ *          more information.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \since This function is available since SDL_ttf 3.4.0.
+ *
+ * \sa TTF_AddFontRegistryData
+ * \sa TTF_AddFontRegistryPath
+ * \sa TTF_DestroyFontRegistry
+ * \sa TTF_LoadFontRegistry
+ */
+extern SDL_DECLSPEC TTF_FontRegistry * SDLCALL TTF_CreateFontRegistry(void);
+
+/**
+ * Add a font file or a directory of font files to a font registry.
+ *
+ * Directories are scanned recursively for .ttf, .otf, .ttc and .otc files,
+ * and every face in each file is indexed. Files that are already in the
+ * registry with the same size and modification time, e.g. from
+ * TTF_LoadFontRegistry(), aren't parsed again.
+ *
+ * \param registry the font registry to modify.
+ * \param path the path of a font file or a directory.
+ * \returns true on success or false on failure; call SDL_GetError() for more
+ *          information.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \since This function is available since SDL_ttf 3.4.0.
+ *
+ * \sa TTF_AddFontRegistryData
+ * \sa TTF_SaveFontRegistry
+ */
+extern SDL_DECLSPEC bool SDLCALL TTF_AddFontRegistryPath(TTF_FontRegistry *registry, const char *path);
+
+/**
+ * Add a font in memory to a font registry.
+ *
+ * Every face in the font data is indexed. Fonts in memory aren't saved by
+ * TTF_SaveFontRegistry().
+ *
+ * \param registry the font registry to modify.
+ * \param data the font data, which must remain valid until the registry and
+ *             any fonts opened from it are destroyed.
+ * \param size the size of the font data, in bytes.
+ * \returns true on success or false on failure; call SDL_GetError() for more
+ *          information.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \since This function is available since SDL_ttf 3.4.0.
+ *
+ * \sa TTF_AddFontRegistryPath
+ */
+extern SDL_DECLSPEC bool SDLCALL TTF_AddFontRegistryData(TTF_FontRegistry *registry, const void *data, size_t size);
+
+/**
+ * Save the index of a font registry to a file.
+ *
+ * The index can be loaded with TTF_LoadFontRegistry() to avoid parsing the
+ * font files again.
+ *
+ * \param registry the font registry to save.
+ * \param file the index file to write.
+ * \returns true on success or false on failure; call SDL_GetError() for more
+ *          information.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \since This function is available since SDL_ttf 3.4.0.
+ *
+ * \sa TTF_LoadFontRegistry
+ */
+extern SDL_DECLSPEC bool SDLCALL TTF_SaveFontRegistry(TTF_FontRegistry *registry, const char *file);
+
+/**
+ * Load an index saved with TTF_SaveFontRegistry() into a font registry.
+ *
+ * Fonts whose files no longer exist or have changed since the index was
+ * saved are skipped; add their paths again to index them.
+ *
+ * \param registry the font registry to modify.
+ * \param file the index file to read.
+ * \returns true on success or false on failure; call SDL_GetError() for more
+ *          information.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \since This function is available since SDL_ttf 3.4.0.
+ *
+ * \sa TTF_AddFontRegistryPath
+ * \sa TTF_SaveFontRegistry
+ */
+extern SDL_DECLSPEC bool SDLCALL TTF_LoadFontRegistry(TTF_FontRegistry *registry, const char *file);
+
+/**
+ * Open the font in a registry that best matches a family and style.
+ *
+ * Family names are compared without regard to case. Among the faces of the
+ * family, the one with the closest italic style and weight is opened.
+ *
+ * \param registry the font registry to search.
+ * \param family the font family name, e.g. "Noto Sans".
+ * \param style TTF_STYLE_BOLD and TTF_STYLE_ITALIC select the face to open,
+ *              other flags are ignored.
+ * \param ptsize the point size of the font.
+ * \returns a valid TTF_Font, or NULL on failure; call SDL_GetError() for more
+ *          information.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \since This function is available since SDL_ttf 3.4.0.
+ *
+ * \sa TTF_CloseFont
+ */
+extern SDL_DECLSPEC TTF_Font * SDLCALL TTF_OpenFontFromRegistry(TTF_FontRegistry *registry, const char *family, TTF_FontStyleFlags style, float ptsize);
+
+/**
+ * Use a font registry to find fallback fonts for a font automatically.
+ *
+ * When text uses a character that isn't in the font or its fallback fonts,
+ * the first font in the registry that covers it is opened at the same size
+ * and added as a fallback font. Fonts opened this way are owned by the font
+ * and closed when the registry is changed or the font is closed.
+ *
+ * This updates any TTF_Text objects using this font.
+ *
+ * \param font the font to modify.
+ * \param registry the font registry to use, or NULL to stop using one. The
+ *                 registry must remain valid while it's set on the font.
+ * \returns true on success or false on failure; call SDL_GetError() for more
+ *          information.
+ *
+ * \threadsafety This function should be called on the thread that created the
+ *               font.
+ *
+ * \since This function is available since SDL_ttf 3.4.0.
+ *
+ * \sa TTF_AddFallbackFont
+ * \sa TTF_GetFontRegistry
+ */
+extern SDL_DECLSPEC bool SDLCALL TTF_SetFontRegistry(TTF_Font *font, TTF_FontRegistry *registry);
+
+/**
+ * Get the font registry used to find fallback fonts for a font.
+ *
+ * \param font the font to query.
+ * \returns the font registry set with TTF_SetFontRegistry(), or NULL if there
+ *          is none.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \since This function is available since SDL_ttf 3.4.0.
+ *
+ * \sa TTF_SetFontRegistry
+ */
+extern SDL_DECLSPEC TTF_FontRegistry * SDLCALL TTF_GetFontRegistry(const TTF_Font *font);
+
+/**
+ * Destroy a font registry.
+ *
+ * Fonts opened from the registry remain valid, but the registry must not be
+ * set on any font with TTF_SetFontRegistry() when it's destroyed.
+ *
+ * \param registry the font registry to destroy.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \since This function is available since SDL_ttf 3.4.0.
+ *
+ * \sa TTF_CreateFontRegistry
+ */
+extern SDL_DECLSPEC void SDLCALL TTF_DestroyFontRegistry(TTF_FontRegistry *registry);
+
 /**
  * Query a font's family name.
  *
@@ -1143,6 +1669,7 @@ typedef enum TTF_ImageType
     TTF_IMAGE_ALPHA,    /**< The color channels are white */
     TTF_IMAGE_COLOR,    /**< The color channels have image data */
     TTF_IMAGE_SDF,      /**< The alpha channel has signed distance field information */
+    TTF_IMAGE_MSDF,     /**< The color channels have multi-channel signed distance field information, and the alpha channel has signed distance field information */
 } TTF_ImageType;
 
 /**
@@ -1160,16 +1687,43 @@ typedef enum TTF_ImageType
  *
  * \since This function is available since SDL_ttf 3.0.0.
  */
-extern SDL_DECLSPEC SDL_Surface * SDLCALL TTF_GetGlyphImage(TTF_Font *font, Uint32 ch, TTF_ImageType *image_type);
+extern SDL_DECLSPEC SDL_Surface * SDLCALL TTF_GetGlyphImage(TTF_Font *font, Uint32 ch, TTF_ImageType *image_type);
+
+/**
+ * Get the pixel image for a character index.
+ *
+ * This is useful for text engine implementations, which can call this with
+ * the `glyph_index` in a TTF_CopyOperation
+ *
+ * \param font the font to query.
+ * \param glyph_index the index of the glyph to return.
+ * \param image_type a pointer filled in with the glyph image type, may be
+ *                   NULL.
+ * \returns an SDL_Surface containing the glyph, or NULL on failure; call
+ *          SDL_GetError() for more information.
+ *
+ * \threadsafety This function should be called on the thread that created the
+ *               font.
+ *
+ * \since This function is available since SDL_ttf 3.0.0.
+ */
+extern SDL_DECLSPEC SDL_Surface * SDLCALL TTF_GetGlyphImageForIndex(TTF_Font *font, Uint32 glyph_index, TTF_ImageType *image_type);
 
 /**
- * Get the pixel image for a character index.
+ * Get the pixel image for a character index, positioned at a subpixel offset.
+ *
+ * The offset is quantized to a quarter of a pixel, and each quantized offset
+ * of a glyph is cached separately. The image has the same origin as the
+ * image returned by TTF_GetGlyphImageForIndex(), so it can be drawn at the
+ * same position.
  *
  * This is useful for text engine implementations, which can call this with
- * the `glyph_index` in a TTF_CopyOperation
+ * the `glyph_index` in a TTF_CopyOperation and the matching entry in the
+ * `subpixel_offsets` of the text.
  *
  * \param font the font to query.
  * \param glyph_index the index of the glyph to return.
+ * \param offset the horizontal offset of the glyph, in fractions of a pixel.
  * \param image_type a pointer filled in with the glyph image type, may be
  *                   NULL.
  * \returns an SDL_Surface containing the glyph, or NULL on failure; call
@@ -1178,9 +1732,12 @@ extern SDL_DECLSPEC SDL_Surface * SDLCALL TTF_GetGlyphImage(TTF_Font *font, Uint
  * \threadsafety This function should be called on the thread that created the
  *               font.
  *
- * \since This function is available since SDL_ttf 3.0.0.
+ * \since This function is available since SDL_ttf 3.4.0.
+ *
+ * \sa TTF_GetGlyphImageForIndex
+ * \sa TTF_SetFontHinting
  */
-extern SDL_DECLSPEC SDL_Surface * SDLCALL TTF_GetGlyphImageForIndex(TTF_Font *font, Uint32 glyph_index, TTF_ImageType *image_type);
+extern SDL_DECLSPEC SDL_Surface * SDLCALL TTF_GetSubpixelGlyphImageForIndex(TTF_Font *font, Uint32 glyph_index, float offset, TTF_ImageType *image_type);
 
 /**
  * Query the metrics (dimensions) of a font's glyph for a UNICODE codepoint.
@@ -1309,6 +1866,52 @@ extern SDL_DECLSPEC bool SDLCALL TTF_GetStringSizeWrapped(TTF_Font *font, const
  */
 extern SDL_DECLSPEC bool SDLCALL TTF_MeasureString(TTF_Font *font, const char *text, size_t length, int max_width, int *measured_width, size_t *measured_length);
 
+/**
+ * Flags controlling how TTF_MeasureStrings() does its work.
+ *
+ * \since This datatype is available since SDL_ttf 3.4.0.
+ *
+ * \sa TTF_MeasureStrings
+ */
+typedef Uint32 TTF_MeasureFlags;
+
+#define TTF_MEASURE_DEFAULT         0x00 /**< Use worker threads when there is enough work */
+#define TTF_MEASURE_SINGLE_THREADED 0x01 /**< Measure everything on the calling thread */
+
+/**
+ * Calculate the dimensions of many rendered strings of UTF-8 text.
+ *
+ * This gives the same results as calling TTF_GetStringSize() for each string,
+ * but identical strings are only measured once, and large batches are split
+ * across worker threads, each using its own copy of the font face and shaping
+ * state.
+ *
+ * Worker threads are not used if the font has fallback fonts, or if
+ * TTF_MEASURE_SINGLE_THREADED is set in `flags`.
+ *
+ * \param font the font to query.
+ * \param strings an array of `count` strings to calculate, in UTF-8 encoding.
+ * \param lengths an array of `count` string lengths, in bytes, with 0 for
+ *                null terminated text, or NULL if all of the strings are null
+ *                terminated.
+ * \param count the number of strings to calculate.
+ * \param widths an array of `count` ints filled with the width, in pixels, of
+ *               each string, may be NULL.
+ * \param heights an array of `count` ints filled with the height, in pixels,
+ *                of each string, may be NULL.
+ * \param flags a combination of TTF_MeasureFlags values.
+ * \returns true on success or false on failure; call SDL_GetError() for more
+ *          information.
+ *
+ * \threadsafety This function should be called on the thread that created the
+ *               font.
+ *
+ * \since This function is available since SDL_ttf 3.4.0.
+ *
+ * \sa TTF_GetStringSize
+ */
+extern SDL_DECLSPEC bool SDLCALL TTF_MeasureStrings(TTF_Font *font, const char **strings, const size_t *lengths, int count, int *widths, int *heights, TTF_MeasureFlags flags);
+
 /**
  * Render UTF-8 text at fast quality to a new 8-bit surface.
  *
@@ -1858,6 +2461,10 @@ extern SDL_DECLSPEC TTF_TextEngine * SDLCALL TTF_CreateRendererTextEngine(SDL_Re
  *   creating textures and drawing text
  * - `TTF_PROP_RENDERER_TEXT_ENGINE_ATLAS_TEXTURE_SIZE_NUMBER`: the size of
  *   the texture atlas
+ * - `TTF_PROP_RENDERER_TEXT_ENGINE_COMPACT_THRESHOLD_FLOAT`: if greater than
+ *   zero, the texture atlases are automatically compacted instead of creating
+ *   a new atlas when their fragmentation reaches this value, defaults to 0.
+ *   See TTF_CompactRendererTextEngine() for details.
  *
  * \param props the properties to use.
  * \returns a TTF_TextEngine object or NULL on failure; call SDL_GetError()
@@ -1876,6 +2483,7 @@ extern SDL_DECLSPEC TTF_TextEngine * SDLCALL TTF_CreateRendererTextEngineWithPro
 
 #define TTF_PROP_RENDERER_TEXT_ENGINE_RENDERER_POINTER          "SDL_ttf.renderer_text_engine.create.renderer"
 #define TTF_PROP_RENDERER_TEXT_ENGINE_ATLAS_TEXTURE_SIZE_NUMBER "SDL_ttf.renderer_text_engine.create.atlas_texture_size"
+#define TTF_PROP_RENDERER_TEXT_ENGINE_COMPACT_THRESHOLD_FLOAT   "SDL_ttf.renderer_text_engine.create.compact_threshold"
 
 /**
  * Draw text to an SDL renderer.
@@ -1902,6 +2510,93 @@ extern SDL_DECLSPEC TTF_TextEngine * SDLCALL TTF_CreateRendererTextEngineWithPro
  */
 extern SDL_DECLSPEC bool SDLCALL TTF_DrawRendererText(TTF_Text *text, float x, float y);
 
+/**
+ * Draw multiple texts to an SDL renderer.
+ *
+ * This merges the geometry of all the texts and draws it with one call per
+ * atlas texture, which is much faster than calling TTF_DrawRendererText() for
+ * many small texts. Because of this, overlapping texts may not be drawn in
+ * the order they are passed in.
+ *
+ * All the texts must have been created using the same TTF_TextEngine from
+ * TTF_CreateRendererTextEngine(), and will draw using the renderer passed to
+ * that function.
+ *
+ * \param texts an array of texts to draw.
+ * \param positions an array of positions in pixels for each text, positive
+ *                  from the top left corner towards the bottom right.
+ * \param count the number of texts to draw.
+ * \returns true on success or false on failure; call SDL_GetError() for more
+ *          information.
+ *
+ * \threadsafety This function should be called on the thread that created the
+ *               texts.
+ *
+ * \since This function is available since SDL_ttf 3.4.0.
+ *
+ * \sa TTF_DrawRendererText
+ */
+extern SDL_DECLSPEC bool SDLCALL TTF_DrawRendererTexts(TTF_Text **texts, const SDL_FPoint *positions, int count);
+
+/**
+ * Texture atlas usage statistics for a text engine.
+ *
+ * \since This struct is available since SDL_ttf 3.4.0.
+ *
+ * \sa TTF_GetRendererTextEngineAtlasInfo
+ */
+typedef struct TTF_TextEngineAtlasInfo
+{
+    int num_atlases;            /**< The number of atlas textures */
+    int atlas_texture_size;     /**< The width and height of each atlas texture */
+    int num_glyphs;             /**< The number of glyphs in use by fonts and text */
+    Sint64 used_pixels;         /**< The area of the atlases covered by glyphs in use */
+    Sint64 allocated_pixels;    /**< The area of the atlases that has been allocated for glyphs, in use or not */
+    float occupancy;            /**< The fraction of the total atlas area covered by glyphs in use */
+    float fragmentation;        /**< The fraction of the allocated atlas area that isn't covered by glyphs in use */
+} TTF_TextEngineAtlasInfo;
+
+/**
+ * Get texture atlas usage statistics for a renderer text engine.
+ *
+ * \param engine a TTF_TextEngine object created with
+ *               TTF_CreateRendererTextEngine().
+ * \param info a pointer filled in with the atlas statistics.
+ * \returns true on success or false on failure; call SDL_GetError() for more
+ *          information.
+ *
+ * \threadsafety This function should be called on the thread that created the
+ *               engine.
+ *
+ * \since This function is available since SDL_ttf 3.4.0.
+ *
+ * \sa TTF_CompactRendererTextEngine
+ */
+extern SDL_DECLSPEC bool SDLCALL TTF_GetRendererTextEngineAtlasInfo(TTF_TextEngine *engine, TTF_TextEngineAtlasInfo *info);
+
+/**
+ * Compact the texture atlases of a renderer text engine.
+ *
+ * Glyphs that are in use are repacked into as few new atlas textures as
+ * possible and the old atlas textures are destroyed. Text created by this
+ * engine is updated automatically the next time it is drawn.
+ *
+ * The renderer must support render targets for this to succeed.
+ *
+ * \param engine a TTF_TextEngine object created with
+ *               TTF_CreateRendererTextEngine().
+ * \returns true on success or false on failure; call SDL_GetError() for more
+ *          information.
+ *
+ * \threadsafety This function should be called on the thread that created the
+ *               engine.
+ *
+ * \since This function is available since SDL_ttf 3.4.0.
+ *
+ * \sa TTF_GetRendererTextEngineAtlasInfo
+ */
+extern SDL_DECLSPEC bool SDLCALL TTF_CompactRendererTextEngine(TTF_TextEngine *engine);
+
 /**
  * Destroy a text engine created for drawing text on an SDL renderer.
  *
@@ -1968,6 +2663,64 @@ extern SDL_DECLSPEC TTF_TextEngine * SDLCALL TTF_CreateGPUTextEngineWithProperti
 #define TTF_PROP_GPU_TEXT_ENGINE_DEVICE_POINTER            "SDL_ttf.gpu_text_engine.create.device"
 #define TTF_PROP_GPU_TEXT_ENGINE_ATLAS_TEXTURE_SIZE_NUMBER "SDL_ttf.gpu_text_engine.create.atlas_texture_size"
 
+/**
+ * The format of the vertex data returned by TTF_GetGPUTextDrawData() and
+ * TTF_GetGLTextDrawData().
+ *
+ * \since This enum is available since SDL_ttf 3.4.0.
+ *
+ * \sa TTF_SetGPUTextEngineVertexFormat
+ * \sa TTF_SetGLTextEngineVertexFormat
+ */
+typedef enum TTF_TextVertexFormat
+{
+    TTF_TEXT_VERTEX_FORMAT_INVALID = -1,
+    TTF_TEXT_VERTEX_FORMAT_FLOAT,           /**< Floating point positions and texture coordinates, the default */
+    TTF_TEXT_VERTEX_FORMAT_PACKED,          /**< Interleaved TTF_PackedTextVertex vertices and 16-bit indices */
+    TTF_TEXT_VERTEX_FORMAT_INSTANCED        /**< One TTF_TextInstance per glyph, for instanced drawing, without vertices or indices */
+} TTF_TextVertexFormat;
+
+/**
+ * A compact vertex, used with TTF_TEXT_VERTEX_FORMAT_PACKED.
+ *
+ * Positions are whole pixels in the same coordinate system as the floating
+ * point format, texture coordinates are normalized to the range 0-65535, and
+ * the color is the color of the text. This is 12 bytes per vertex, and can be
+ * described to the GPU as SDL_GPU_VERTEXELEMENTFORMAT_SHORT2,
+ * SDL_GPU_VERTEXELEMENTFORMAT_USHORT2_NORM and
+ * SDL_GPU_VERTEXELEMENTFORMAT_UBYTE4_NORM.
+ *
+ * \since This struct is available since SDL_ttf 3.4.0.
+ *
+ * \sa TTF_TextVertexFormat
+ */
+typedef struct TTF_PackedTextVertex
+{
+    Sint16 x, y;            /**< Vertex position, in pixels */
+    Uint16 u, v;            /**< Normalized texture coordinate, or normalized rectangle coordinate for solid fill */
+    Uint8 r, g, b, a;       /**< The color of the text */
+} TTF_PackedTextVertex;
+
+/**
+ * A glyph or solid fill rectangle, used with TTF_TEXT_VERTEX_FORMAT_INSTANCED.
+ *
+ * Each instance is drawn as a quad, typically generated in the vertex shader
+ * from the vertex index. The rectangle is in the same coordinate system as
+ * the vertices of the other formats, with the positive Y-axis upwards, so
+ * the quad extends from `dst.y` down to `dst.y - dst.h`.
+ *
+ * \since This struct is available since SDL_ttf 3.4.0.
+ *
+ * \sa TTF_TextVertexFormat
+ */
+typedef struct TTF_TextInstance
+{
+    SDL_FRect dst;              /**< The area to draw, `x` and `y` are the upper left corner */
+    SDL_FRect uv;               /**< The area of the glyph in the atlas texture in normalized texture coordinates, or 0,0,1,1 for solid fill */
+    TTF_ImageType image_type;   /**< The image type of the glyph, or TTF_IMAGE_INVALID for solid fill */
+    int text_offset;            /**< The byte offset in the text of the cluster the glyph belongs to, which may be used to look up a color for the cluster, or -1 for solid fill */
+} TTF_TextInstance;
+
 /**
  * Draw sequence returned by TTF_GetGPUTextDrawData
  *
@@ -1986,6 +2739,11 @@ typedef struct TTF_GPUAtlasDrawSequence
     TTF_ImageType image_type;               /**< The image type of this draw sequence */
 
     struct TTF_GPUAtlasDrawSequence *next;  /**< The next sequence (will be NULL in case of the last sequence) */
+
+    TTF_PackedTextVertex *packed_vertices;  /**< An array of interleaved vertices with TTF_TEXT_VERTEX_FORMAT_PACKED, in which case 'xy', 'uv' and 'indices' are NULL */
+    Uint16 *packed_indices;                 /**< An array of 16-bit indices into the 'packed_vertices' array */
+    TTF_TextInstance *instances;            /**< An array of instances with TTF_TEXT_VERTEX_FORMAT_INSTANCED, in which case there are no vertices or indices */
+    int num_instances;                      /**< Number of instances */
 } TTF_GPUAtlasDrawSequence;
 
 /**
@@ -1994,6 +2752,11 @@ typedef struct TTF_GPUAtlasDrawSequence
  * `text` must have been created using a TTF_TextEngine from
  * TTF_CreateGPUTextEngine().
  *
+ * The format of the data depends on the vertex format of the engine, see
+ * TTF_SetGPUTextEngineVertexFormat(). With TTF_TEXT_VERTEX_FORMAT_INSTANCED
+ * each sequence contains one TTF_TextInstance per glyph instead of vertices
+ * and indices.
+ *
  * The positive X-axis is taken towards the right and the positive Y-axis is
  * taken upwards for both the vertex and the texture coordinates, i.e, it
  * follows the same convention used by the SDL_GPU API. If you want to use a
@@ -2082,6 +2845,51 @@ extern SDL_DECLSPEC void SDLCALL TTF_SetGPUTextEngineWinding(TTF_TextEngine *eng
  */
 extern SDL_DECLSPEC TTF_GPUTextEngineWinding SDLCALL TTF_GetGPUTextEngineWinding(const TTF_TextEngine *engine);
 
+/**
+ * Set the format of the vertices returned by TTF_GetGPUTextDrawData() for a
+ * particular GPU text engine.
+ *
+ * TTF_TEXT_VERTEX_FORMAT_PACKED uses 12 bytes per vertex and 16-bit indices
+ * instead of 16 bytes per vertex and 32-bit indices, about two thirds of the
+ * memory and bandwidth of the default format, which helps when streaming
+ * large amounts of text.
+ * Positions are rounded to whole pixels and must be in the range of a Sint16.
+ * TTF_TEXT_VERTEX_FORMAT_INSTANCED returns a single TTF_TextInstance per
+ * glyph, to be expanded into quads by an instanced vertex shader.
+ *
+ * The format is used by text objects that are updated after this call.
+ *
+ * \param engine a TTF_TextEngine object created with
+ *               TTF_CreateGPUTextEngine().
+ * \param format the new vertex format.
+ *
+ * \threadsafety This function should be called on the thread that created the
+ *               engine.
+ *
+ * \since This function is available since SDL_ttf 3.4.0.
+ *
+ * \sa TTF_GetGPUTextEngineVertexFormat
+ */
+extern SDL_DECLSPEC void SDLCALL TTF_SetGPUTextEngineVertexFormat(TTF_TextEngine *engine, TTF_TextVertexFormat format);
+
+/**
+ * Get the format of the vertices returned by TTF_GetGPUTextDrawData() for a
+ * particular GPU text engine.
+ *
+ * \param engine a TTF_TextEngine object created with
+ *               TTF_CreateGPUTextEngine().
+ * \returns the vertex format used by the GPU text engine or
+ *          TTF_TEXT_VERTEX_FORMAT_INVALID in case of error.
+ *
+ * \threadsafety This function should be called on the thread that created the
+ *               engine.
+ *
+ * \since This function is available since SDL_ttf 3.4.0.
+ *
+ * \sa TTF_SetGPUTextEngineVertexFormat
+ */
+extern SDL_DECLSPEC TTF_TextVertexFormat SDLCALL TTF_GetGPUTextEngineVertexFormat(const TTF_TextEngine *engine);
+
 /**
  * Create a text engine for drawing text with OpenGL.
  *
@@ -2171,6 +2979,10 @@ typedef struct TTF_GLAtlasDrawSequence
     TTF_ImageType image_type;             /**< The image type of this draw sequence */
 
     struct TTF_GLAtlasDrawSequence *next; /**< The next sequence (will be NULL in case of the last sequence) */
+
+    TTF_PackedTextVertex *packed_vertices; /**< An array of interleaved vertices with TTF_TEXT_VERTEX_FORMAT_PACKED, in which case 'vertices' is NULL */
+    TTF_TextInstance *instances;           /**< An array of instances with TTF_TEXT_VERTEX_FORMAT_INSTANCED, in which case there are no vertices or indices */
+    int num_instances;                     /**< Number of instances */
 } TTF_GLAtlasDrawSequence;
 
 /**
@@ -2179,6 +2991,11 @@ typedef struct TTF_GLAtlasDrawSequence
  * `text` must have been created using a TTF_TextEngine from
  * TTF_CreateGLTextEngine().
  *
+ * The format of the data depends on the vertex format of the engine, see
+ * TTF_SetGLTextEngineVertexFormat(). With TTF_TEXT_VERTEX_FORMAT_INSTANCED
+ * each sequence contains one TTF_TextInstance per glyph instead of vertices
+ * and indices.
+ *
  * The positive X-axis is taken towards the right and the positive Y-axis is
  * taken upwards for both the vertex and the texture coordinates, i.e, it
  * follows the same convention used by the OpenGL API. If you want to use a
@@ -2267,6 +3084,50 @@ extern SDL_DECLSPEC void SDLCALL TTF_SetGLTextEngineWinding(TTF_TextEngine *engi
  */
 extern SDL_DECLSPEC TTF_GLTextEngineWinding SDLCALL TTF_GetGLTextEngineWinding(const TTF_TextEngine *engine);
 
+/**
+ * Set the format of the vertices returned by TTF_GetGLTextDrawData() for a
+ * particular GL text engine.
+ *
+ * TTF_TEXT_VERTEX_FORMAT_PACKED uses 12 bytes per vertex, including the text
+ * color, instead of 16 bytes per vertex, which helps when streaming large
+ * amounts of text.
+ * Positions are rounded to whole pixels and must be in the range of a Sint16.
+ * TTF_TEXT_VERTEX_FORMAT_INSTANCED returns a single TTF_TextInstance per
+ * glyph, to be expanded into quads by an instanced vertex shader.
+ *
+ * The format is used by text objects that are updated after this call.
+ *
+ * \param engine a TTF_TextEngine object created with
+ *               TTF_CreateGLTextEngine().
+ * \param format the new vertex format.
+ *
+ * \threadsafety This function should be called on the thread that created the
+ *               engine.
+ *
+ * \since This function is available since SDL_ttf 3.4.0.
+ *
+ * \sa TTF_GetGLTextEngineVertexFormat
+ */
+extern SDL_DECLSPEC void SDLCALL TTF_SetGLTextEngineVertexFormat(TTF_TextEngine *engine, TTF_TextVertexFormat format);
+
+/**
+ * Get the format of the vertices returned by TTF_GetGLTextDrawData() for a
+ * particular GL text engine.
+ *
+ * \param engine a TTF_TextEngine object created with
+ *               TTF_CreateGLTextEngine().
+ * \returns the vertex format used by the GL text engine or
+ *          TTF_TEXT_VERTEX_FORMAT_INVALID in case of error.
+ *
+ * \threadsafety This function should be called on the thread that created the
+ *               engine.
+ *
+ * \since This function is available since SDL_ttf 3.4.0.
+ *
+ * \sa TTF_SetGLTextEngineVertexFormat
+ */
+extern SDL_DECLSPEC TTF_TextVertexFormat SDLCALL TTF_GetGLTextEngineVertexFormat(const TTF_TextEngine *engine);
+
 /**
  * Create a text object from UTF-8 text and a text engine.
  *
@@ -2288,6 +3149,33 @@ extern SDL_DECLSPEC TTF_GLTextEngineWinding SDLCALL TTF_GetGLTextEngineWinding(c
  */
 extern SDL_DECLSPEC TTF_Text * SDLCALL TTF_CreateText(TTF_TextEngine *engine, TTF_Font *font, const char *text, size_t length);
 
+/**
+ * Create a copy of a text object.
+ *
+ * The copy uses the same text engine, font, string, color, position,
+ * wrapping, direction, script, viewport and properties as the original.
+ *
+ * Text objects with the same content and layout settings share a single
+ * copy of their layout, so creating many text objects with the same string,
+ * like repeated labels in a list, only lays out the text once. A copy of a
+ * text object that is up to date starts out sharing its layout, and a text
+ * object gets its own layout again when it's changed. The text engine
+ * representation is still created for each text object.
+ *
+ * \param text the TTF_Text to copy.
+ * \returns a TTF_Text object or NULL on failure; call SDL_GetError() for more
+ *          information.
+ *
+ * \threadsafety This function should be called on the thread that created the
+ *               text.
+ *
+ * \since This function is available since SDL_ttf 3.4.0.
+ *
+ * \sa TTF_CreateText
+ * \sa TTF_DestroyText
+ */
+extern SDL_DECLSPEC TTF_Text * SDLCALL TTF_CloneText(TTF_Text *text);
+
 /**
  * Get the properties associated with a text object.
  *
@@ -2668,6 +3556,59 @@ extern SDL_DECLSPEC bool SDLCALL TTF_SetTextWrapWhitespaceVisible(TTF_Text *text
  */
 extern SDL_DECLSPEC bool SDLCALL TTF_TextWrapWhitespaceVisible(TTF_Text *text);
 
+/**
+ * Set the area of a text object that is visible.
+ *
+ * By default a text object creates drawing operations and text engine data
+ * for every line. When the text is much larger than the area it is shown in,
+ * like a long log in a scrolling view, you can set a viewport so only the
+ * lines intersecting it, and a viewport height worth of lines above and
+ * below, are laid out and given to the text engine. Scrolling within those
+ * lines doesn't cause the text to be laid out again.
+ *
+ * The size of the text and the line breaks are still available for the whole
+ * text, but lines that aren't laid out are returned as a single substring
+ * spanning the width of the text by TTF_GetTextSubString() and related
+ * functions.
+ *
+ * The viewport is in the same coordinates as the text drawing operations,
+ * which include the position set with TTF_SetTextPosition().
+ *
+ * This function may cause the internal text representation to be rebuilt.
+ *
+ * \param text the TTF_Text to modify.
+ * \param rect the visible area of the text, or NULL to lay out all of the
+ *             text.
+ * \returns true on success or false on failure; call SDL_GetError() for more
+ *          information.
+ *
+ * \threadsafety This function should be called on the thread that created the
+ *               text.
+ *
+ * \since This function is available since SDL_ttf 3.4.0.
+ *
+ * \sa TTF_GetTextViewport
+ */
+extern SDL_DECLSPEC bool SDLCALL TTF_SetTextViewport(TTF_Text *text, const SDL_Rect *rect);
+
+/**
+ * Get the area of a text object that is visible.
+ *
+ * \param text the TTF_Text to query.
+ * \param rect a pointer filled in with the visible area of the text, or an
+ *             empty rectangle if all of the text is laid out.
+ * \returns true on success or false on failure; call SDL_GetError() for more
+ *          information.
+ *
+ * \threadsafety This function should be called on the thread that created the
+ *               text.
+ *
+ * \since This function is available since SDL_ttf 3.4.0.
+ *
+ * \sa TTF_SetTextViewport
+ */
+extern SDL_DECLSPEC bool SDLCALL TTF_GetTextViewport(TTF_Text *text, SDL_Rect *rect);
+
 /**
  * Set the UTF-8 text used by a text object.
  *
@@ -2971,6 +3912,98 @@ extern SDL_DECLSPEC bool SDLCALL TTF_GetNextTextSubString(TTF_Text *text, const
  */
 extern SDL_DECLSPEC bool SDLCALL TTF_UpdateText(TTF_Text *text);
 
+/**
+ * Update the layout of multiple text objects.
+ *
+ * This is equivalent to calling TTF_UpdateText() on each text object, but
+ * is faster when updating many text objects at once, like when a new screen
+ * is shown.
+ *
+ * Text objects that use the same font and need to be laid out are laid out
+ * in parallel on worker threads, each using a private copy of the font. Text
+ * objects using fonts with fallback fonts are laid out on the calling thread.
+ * All the glyphs needed by the text objects are then rendered in a single
+ * pass, and the text engine representations are created one at a time on
+ * the calling thread.
+ *
+ * \param texts an array of TTF_Text objects to update, a text object may
+ *              appear more than once and is only laid out once.
+ * \param count the number of text objects in `texts`.
+ * \returns true on success or false on failure; call SDL_GetError() for more
+ *          information.
+ *
+ * \threadsafety This function should be called on the thread that created the
+ *               texts and their fonts.
+ *
+ * \since This function is available since SDL_ttf 3.4.0.
+ *
+ * \sa TTF_UpdateText
+ */
+extern SDL_DECLSPEC bool SDLCALL TTF_UpdateTexts(TTF_Text **texts, int count);
+
+/**
+ * Set the number of glyphs rendered each time a text object is updated.
+ *
+ * By default updating a text object renders all the glyphs it needs before
+ * the text engine representation is created, which can stall a frame when a
+ * large amount of new text is shown. With an incremental update each call to
+ * TTF_UpdateText(), which happens automatically when the text is drawn,
+ * renders at most `max_glyphs` missing glyphs. Until all the glyphs are
+ * available the text engine draws the text without the glyphs that are still
+ * missing. The layout of the text is always complete.
+ *
+ * You can check whether all the glyphs of the text are drawn with
+ * TTF_IsTextResolved().
+ *
+ * \param text the TTF_Text to modify.
+ * \param max_glyphs the maximum number of glyphs to render per update, or 0
+ *                   to render all of them at once.
+ * \returns true on success or false on failure; call SDL_GetError() for more
+ *          information.
+ *
+ * \threadsafety This function should be called on the thread that created the
+ *               text.
+ *
+ * \since This function is available since SDL_ttf 3.4.0.
+ *
+ * \sa TTF_GetTextIncrementalUpdate
+ * \sa TTF_IsTextResolved
+ * \sa TTF_UpdateText
+ */
+extern SDL_DECLSPEC bool SDLCALL TTF_SetTextIncrementalUpdate(TTF_Text *text, int max_glyphs);
+
+/**
+ * Get the number of glyphs rendered each time a text object is updated.
+ *
+ * \param text the TTF_Text to query.
+ * \returns the maximum number of glyphs rendered per update, or 0 if all the
+ *          glyphs are rendered at once.
+ *
+ * \threadsafety This function should be called on the thread that created the
+ *               text.
+ *
+ * \since This function is available since SDL_ttf 3.4.0.
+ *
+ * \sa TTF_SetTextIncrementalUpdate
+ */
+extern SDL_DECLSPEC int SDLCALL TTF_GetTextIncrementalUpdate(TTF_Text *text);
+
+/**
+ * Check whether the text engine representation of a text object is complete.
+ *
+ * \param text the TTF_Text to query.
+ * \returns true if the text is up to date and all of its glyphs are
+ *          rendered, false otherwise.
+ *
+ * \threadsafety This function should be called on the thread that created the
+ *               text.
+ *
+ * \since This function is available since SDL_ttf 3.4.0.
+ *
+ * \sa TTF_SetTextIncrementalUpdate
+ */
+extern SDL_DECLSPEC bool SDLCALL TTF_IsTextResolved(TTF_Text *text);
+
 /**
  * Destroy a text object created by a text engine.
  *
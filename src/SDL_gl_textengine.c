@@ -26,6 +26,7 @@
 
 #include "SDL_hashtable.h"
 #include "SDL_hashtable_ttf.h"
+#include "SDL_ttf_internal.h"
 
 #define STB_RECT_PACK_IMPLEMENTATION
 #define STBRP_STATIC
@@ -34,6 +35,18 @@
 #define STBRP__CDECL SDLCALL
 #include "stb_rect_pack.h"
 
+// Extra padding between glyphs, to avoid bleeding when sampling
+#define GLYPH_PADDING 1
+
+// Free areas are binned by power of two size class
+#define NUM_FREE_GLYPH_BINS 16
+
+// Free areas smaller than this in either dimension aren't worth keeping
+#define MIN_FREE_GLYPH_SIZE 4
+
+// Draw sequences use 16-bit indices, so they can't have more than 65536 vertices
+#define MAX_SEQUENCE_GLYPHS (65536 / 4)
+
 typedef struct AtlasGlyph AtlasGlyph;
 typedef struct AtlasTexture AtlasTexture;
 typedef struct TTF_GLAtlasDrawSequence AtlasDrawSequence;
@@ -44,6 +57,13 @@ typedef struct GlyphSurface
     TTF_ImageType image_type;
 } GlyphSurface;
 
+typedef struct GlyphUpload
+{
+    AtlasGlyph *glyph;
+    SDL_Surface *surface;
+    bool clear_padding;
+} GlyphUpload;
+
 struct AtlasGlyph
 {
     int refcount;
@@ -59,7 +79,7 @@ struct AtlasTexture
     GLuint texture;
     stbrp_context packer;
     stbrp_node *packing_nodes;
-    AtlasGlyph *free_glyphs;
+    AtlasGlyph *free_glyphs[NUM_FREE_GLYPH_BINS];
     AtlasTexture *next;
 };
 
@@ -67,6 +87,8 @@ typedef struct TTF_GLTextEngineTextData
 {
     int num_glyphs;
     AtlasGlyph **glyphs;
+    TTF_TextVertexFormat format;
+    SDL_FColor color;
     AtlasDrawSequence *draw_sequence;
 } TTF_GLTextEngineTextData;
 
@@ -75,6 +97,7 @@ typedef struct TTF_GLTextEngineFontData
     TTF_Font *font;
     Uint32 generation;
     SDL_HashTable *glyphs;
+    SDL_GlyphHashTableGenerations previous_glyphs;
 } TTF_GLTextEngineFontData;
 
 typedef struct TTF_GLTextEngineData
@@ -92,8 +115,13 @@ typedef struct TTF_GLTextEngineData
     AtlasTexture *atlas;
     int atlas_texture_size;
     TTF_GLTextEngineWinding winding;
+    TTF_TextVertexFormat format;
     bool has_bgra;
     bool has_unpack_row_length;
+    SDL_PixelFormat upload_format;
+    GLenum upload_gl_format;
+    Uint8 *staging;
+    size_t staging_size;
 } TTF_GLTextEngineData;
 
 static int SDLCALL SortMissing(void *userdata, const void *a, const void *b)
@@ -180,10 +208,12 @@ static void DestroyAtlas(TTF_GLTextEngineData *enginedata, AtlasTexture *atlas)
         return;
     }
 
-    AtlasGlyph *next;
-    for (AtlasGlyph *glyph = atlas->free_glyphs; glyph; glyph = next) {
-        next = glyph->next;
-        DestroyGlyph(glyph);
+    for (int i = 0; i < NUM_FREE_GLYPH_BINS; ++i) {
+        AtlasGlyph *next;
+        for (AtlasGlyph *glyph = atlas->free_glyphs[i]; glyph; glyph = next) {
+            next = glyph->next;
+            DestroyGlyph(glyph);
+        }
     }
 
     if (atlas->texture) {
@@ -240,6 +270,58 @@ static AtlasTexture *CreateAtlas(TTF_GLTextEngineData *enginedata, int atlas_tex
     return atlas;
 }
 
+static int GetFreeGlyphBin(int width, int height)
+{
+    int size = SDL_max(width, height);
+    int bin = 0;
+    while (bin < (NUM_FREE_GLYPH_BINS - 1) && (1 << bin) < size) {
+        ++bin;
+    }
+    return bin;
+}
+
+static void AddFreeGlyph(AtlasTexture *atlas, AtlasGlyph *glyph)
+{
+    // Insert into the free list for this size class, sorted smallest first
+    AtlasGlyph **bin = &atlas->free_glyphs[GetFreeGlyphBin(glyph->rect.w, glyph->rect.h)];
+    AtlasGlyph *entry, *prev = NULL;
+    int size = (glyph->rect.w * glyph->rect.h);
+    for (entry = *bin; entry; entry = entry->next) {
+        if (size <= (entry->rect.w * entry->rect.h)) {
+            break;
+        }
+
+        prev = entry;
+    }
+
+    if (prev) {
+        prev->next = glyph;
+    } else {
+        *bin = glyph;
+    }
+    glyph->next = entry;
+}
+
+static void AddFreeArea(AtlasTexture *atlas, int x, int y, int w, int h)
+{
+    if (w < MIN_FREE_GLYPH_SIZE || h < MIN_FREE_GLYPH_SIZE) {
+        return;
+    }
+
+    AtlasGlyph *glyph = (AtlasGlyph *)SDL_calloc(1, sizeof(*glyph));
+    if (!glyph) {
+        // Not fatal, we just won't be able to reuse this area
+        return;
+    }
+
+    glyph->atlas = atlas;
+    glyph->rect.x = x;
+    glyph->rect.y = y;
+    glyph->rect.w = w;
+    glyph->rect.h = h;
+    AddFreeGlyph(atlas, glyph);
+}
+
 static void ReleaseGlyph(AtlasGlyph *glyph)
 {
     if (!glyph) {
@@ -249,43 +331,23 @@ static void ReleaseGlyph(AtlasGlyph *glyph)
     --glyph->refcount;
     if (glyph->refcount == 0) {
         if (glyph->atlas) {
-            // Insert into free list sorted smallest first
-            AtlasGlyph *entry, *prev = NULL;
-            int size = (glyph->rect.w * glyph->rect.h);
-            for (entry = glyph->atlas->free_glyphs; entry; entry = entry->next) {
-                if (size <= (entry->rect.w * entry->rect.h)) {
-                    break;
-                }
-
-                prev = entry;
-            }
-
-            if (prev) {
-                prev->next = glyph;
-            } else {
-                glyph->atlas->free_glyphs = glyph;
-            }
-            glyph->next = entry;
+            // Free areas include the padding between glyphs
+            glyph->rect.w += GLYPH_PADDING;
+            glyph->rect.h += GLYPH_PADDING;
+            AddFreeGlyph(glyph->atlas, glyph);
         } else {
             DestroyGlyph(glyph);
         }
     }
 }
 
-static AtlasGlyph *CreateGlyph(AtlasTexture *atlas, int atlas_texture_size, const stbrp_rect *area)
+static void SetGlyphArea(AtlasGlyph *glyph, int atlas_texture_size, int x, int y, int w, int h)
 {
-    AtlasGlyph *glyph = (AtlasGlyph *)SDL_calloc(1, sizeof(*glyph));
-    if (!glyph) {
-        return NULL;
-    }
-
-    glyph->refcount = 1;
-    glyph->atlas = atlas;
-    glyph->rect.x = area->x;
-    glyph->rect.y = area->y;
+    glyph->rect.x = x;
+    glyph->rect.y = y;
     // Remove the one pixel extra padding between glyphs
-    glyph->rect.w = area->w - 1;
-    glyph->rect.h = area->h - 1;
+    glyph->rect.w = w - GLYPH_PADDING;
+    glyph->rect.h = h - GLYPH_PADDING;
 
     const float minu = (float)glyph->rect.x / atlas_texture_size;
     const float minv = (float)glyph->rect.y / atlas_texture_size;
@@ -299,110 +361,187 @@ static AtlasGlyph *CreateGlyph(AtlasTexture *atlas, int atlas_texture_size, cons
     glyph->texcoords[5] = maxv;
     glyph->texcoords[6] = minu;
     glyph->texcoords[7] = maxv;
+}
+
+static AtlasGlyph *CreateGlyph(AtlasTexture *atlas, int atlas_texture_size, const stbrp_rect *area)
+{
+    AtlasGlyph *glyph = (AtlasGlyph *)SDL_calloc(1, sizeof(*glyph));
+    if (!glyph) {
+        return NULL;
+    }
+
+    glyph->refcount = 1;
+    glyph->atlas = atlas;
+    SetGlyphArea(glyph, atlas_texture_size, area->x, area->y, area->w, area->h);
 
     return glyph;
 }
 
-static AtlasGlyph *FindUnusedGlyph(AtlasTexture *atlas, int width, int height)
+static bool HasFreeGlyphs(AtlasTexture *atlas)
 {
-    AtlasGlyph *glyph, *prev = NULL;
-
-    int size = (width * height);
-    for (glyph = atlas->free_glyphs; glyph; glyph = glyph->next) {
-        if (width == glyph->rect.w && height == glyph->rect.h) {
-            if (prev) {
-                prev->next = glyph->next;
-            } else {
-                atlas->free_glyphs = glyph->next;
+    for (; atlas; atlas = atlas->next) {
+        for (int i = 0; i < NUM_FREE_GLYPH_BINS; ++i) {
+            if (atlas->free_glyphs[i]) {
+                return true;
             }
-            ++glyph->refcount;
-            return glyph;
         }
+    }
+    return false;
+}
 
-        if (size < (glyph->rect.w * glyph->rect.h)) {
-            // We didn't find any entries our size, everything else is larger than we want
-            break;
+static AtlasGlyph *FindUnusedGlyph(AtlasTexture *atlas, int atlas_texture_size, int width, int height)
+{
+    for (; atlas; atlas = atlas->next) {
+        // Areas in smaller size classes can't fit this glyph
+        for (int bin = GetFreeGlyphBin(width, height); bin < NUM_FREE_GLYPH_BINS; ++bin) {
+            AtlasGlyph *glyph, *prev = NULL;
+            for (glyph = atlas->free_glyphs[bin]; glyph; prev = glyph, glyph = glyph->next) {
+                if (width > glyph->rect.w || height > glyph->rect.h) {
+                    continue;
+                }
+
+                // This is the smallest area in this size class that fits
+                if (prev) {
+                    prev->next = glyph->next;
+                } else {
+                    atlas->free_glyphs[bin] = glyph->next;
+                }
+                glyph->next = NULL;
+
+                // Split off the rest of the area, leaving the larger piece in one rectangle
+                int x = glyph->rect.x;
+                int y = glyph->rect.y;
+                int w = glyph->rect.w;
+                int h = glyph->rect.h;
+                int right = (w - width);
+                int bottom = (h - height);
+                if (right < bottom) {
+                    AddFreeArea(atlas, x + width, y, right, height);
+                    AddFreeArea(atlas, x, y + height, w, bottom);
+                } else {
+                    AddFreeArea(atlas, x + width, y, right, h);
+                    AddFreeArea(atlas, x, y + height, width, bottom);
+                }
+
+                SetGlyphArea(glyph, atlas_texture_size, x, y, width, height);
+                ++glyph->refcount;
+                return glyph;
+            }
         }
+    }
+    return NULL;
+}
 
-        prev = glyph;
+static bool ReserveStagingBuffer(TTF_GLTextEngineData *enginedata, size_t size)
+{
+    if (size <= enginedata->staging_size) {
+        return true;
     }
 
-    if (atlas->next) {
-        return FindUnusedGlyph(atlas->next, width, height);
+    Uint8 *staging = (Uint8 *)SDL_realloc(enginedata->staging, size);
+    if (!staging) {
+        return false;
     }
-    return NULL;
+    enginedata->staging = staging;
+    enginedata->staging_size = size;
+    return true;
 }
 
-static bool UpdateGLTexture(TTF_GLTextEngineData *enginedata, unsigned int texture,
-                            const SDL_Rect *rect, const void *pixels, int pitch)
+static void QueueGlyphUpload(GlyphUpload *uploads, int *num_uploads, AtlasGlyph *glyph, GlyphSurface *surface, bool clear_padding)
 {
-    const Uint32 texturebpp = 4;
+    SDL_assert(glyph->rect.w > 0 && glyph->rect.h > 0);
 
-    enginedata->glBindTexture(GL_TEXTURE_2D, texture);
+    GlyphUpload *upload = &uploads[(*num_uploads)++];
+    upload->glyph = glyph;
+    upload->surface = surface->surface;
+    upload->clear_padding = clear_padding;
+    glyph->image_type = surface->image_type;
+}
 
-    if (enginedata->has_bgra) {
-        if (enginedata->has_unpack_row_length) {
-            enginedata->glPixelStorei(GL_UNPACK_ROW_LENGTH, pitch / (int)texturebpp);
-            enginedata->glTexSubImage2D(GL_TEXTURE_2D, 0,
-                                        rect->x, rect->y, rect->w, rect->h,
-                                        GL_BGRA, GL_UNSIGNED_BYTE, pixels);
-            enginedata->glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
-        } else {
-            /* No UNPACK_ROW_LENGTH: copy to tightly-packed buffer */
-            size_t row_size = (size_t)rect->w * texturebpp;
-            size_t data_size = (size_t)rect->h * row_size;
-            Uint8 *packed = (Uint8 *)SDL_malloc(data_size);
-            if (!packed) {
-                return false;
-            }
-            const Uint8 *src = (const Uint8 *)pixels;
-            Uint8 *dst = packed;
-            for (int i = 0; i < rect->h; ++i) {
-                SDL_memcpy(dst, src, row_size);
-                dst += row_size;
-                src += pitch;
+static int SDLCALL SortUploads(const void *a, const void *b)
+{
+    const AtlasGlyph *A = ((const GlyphUpload *)a)->glyph;
+    const AtlasGlyph *B = ((const GlyphUpload *)b)->glyph;
+
+    if (A->atlas != B->atlas) {
+        return ((uintptr_t)A->atlas < (uintptr_t)B->atlas) ? -1 : 1;
+    }
+    if (A->rect.y != B->rect.y) {
+        return (A->rect.y - B->rect.y);
+    }
+    return (A->rect.x - B->rect.x);
+}
+
+static bool UploadGlyphs(TTF_GLTextEngineData *enginedata, GlyphUpload *uploads, int num_uploads)
+{
+    GLuint bound_texture = 0;
+
+    // Group the uploads by atlas, and by row within each atlas
+    SDL_qsort(uploads, num_uploads, sizeof(*uploads), SortUploads);
+
+    for (int i = 0, end; i < num_uploads; i = end) {
+        const AtlasGlyph *first = uploads[i].glyph;
+
+        /* Merge the following glyphs on the same row into one upload.
+         * The texture contents around the glyphs aren't known, so glyph areas,
+         * including their padding, are only merged when they exactly tile a rectangle. */
+        int right = first->rect.x + first->rect.w + GLYPH_PADDING;
+        for (end = i + 1; end < num_uploads; ++end) {
+            const AtlasGlyph *glyph = uploads[end].glyph;
+            if (glyph->atlas != first->atlas ||
+                glyph->rect.y != first->rect.y ||
+                glyph->rect.h != first->rect.h ||
+                glyph->rect.x != right) {
+                break;
             }
+            right += glyph->rect.w + GLYPH_PADDING;
+        }
+
+        if (first->atlas->texture != bound_texture) {
+            bound_texture = first->atlas->texture;
+            enginedata->glBindTexture(GL_TEXTURE_2D, bound_texture);
+        }
+
+        SDL_Surface *surface = uploads[i].surface;
+        if (end == i + 1 && !uploads[i].clear_padding &&
+            enginedata->has_unpack_row_length && surface->format == enginedata->upload_format) {
+            // The glyph is already in the texture byte order, upload it in place
+            enginedata->glPixelStorei(GL_UNPACK_ROW_LENGTH, surface->pitch / 4);
             enginedata->glTexSubImage2D(GL_TEXTURE_2D, 0,
-                                        rect->x, rect->y, rect->w, rect->h,
-                                        GL_BGRA, GL_UNSIGNED_BYTE, packed);
-            SDL_free(packed);
+                                        first->rect.x, first->rect.y, first->rect.w, first->rect.h,
+                                        enginedata->upload_gl_format, GL_UNSIGNED_BYTE, surface->pixels);
+            enginedata->glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+            continue;
         }
-    } else {
-        /* No BGRA support: convert to RGBA */
-        size_t row_size = (size_t)rect->w * texturebpp;
-        size_t data_size = (size_t)rect->h * row_size;
-        Uint8 *converted = (Uint8 *)SDL_malloc(data_size);
-        if (!converted) {
+
+        // Copy the glyphs into the tightly packed staging buffer, swizzling to the texture byte order on the way
+        SDL_Rect region;
+        region.x = first->rect.x;
+        region.y = first->rect.y;
+        region.w = right - first->rect.x;
+        region.h = first->rect.h + GLYPH_PADDING;
+
+        const int pitch = region.w * 4;
+        if (!ReserveStagingBuffer(enginedata, (size_t)region.h * pitch)) {
             return false;
         }
-        const Uint8 *src = (const Uint8 *)pixels;
-        Uint8 *dst_row = converted;
-        for (int y = 0; y < rect->h; ++y) {
-            const Uint32 *src_pixels = (const Uint32 *)src;
-            Uint32 *dst_pixels = (Uint32 *)dst_row;
-            for (int x = 0; x < rect->w; ++x) {
-                Uint32 p = src_pixels[x];
-                /* BGRA byte order -> RGBA byte order: swap B and R */
-                dst_pixels[x] = (p & 0xFF00FF00u) | ((p >> 16) & 0xFFu) | ((p & 0xFFu) << 16);
+        // Areas that were used before may have stale pixels in their padding
+        SDL_memset(enginedata->staging, 0, (size_t)region.h * pitch);
+
+        for (int j = i; j < end; ++j) {
+            const AtlasGlyph *glyph = uploads[j].glyph;
+            surface = uploads[j].surface;
+            if (!SDL_ConvertPixels(glyph->rect.w, glyph->rect.h,
+                                   surface->format, surface->pixels, surface->pitch,
+                                   enginedata->upload_format, enginedata->staging + (glyph->rect.x - region.x) * 4, pitch)) {
+                return false;
             }
-            src += pitch;
-            dst_row += row_size;
         }
+
         enginedata->glTexSubImage2D(GL_TEXTURE_2D, 0,
-                                    rect->x, rect->y, rect->w, rect->h,
-                                    GL_RGBA, GL_UNSIGNED_BYTE, converted);
-        SDL_free(converted);
+                                    region.x, region.y, region.w, region.h,
+                                    enginedata->upload_gl_format, GL_UNSIGNED_BYTE, enginedata->staging);
     }
-
-    return true;
-}
-
-static bool UpdateGlyph(TTF_GLTextEngineData *enginedata, AtlasGlyph *glyph, SDL_Surface *surface, TTF_ImageType image_type)
-{
-    SDL_assert(glyph->rect.w > 0 && glyph->rect.h > 0);
-
-    UpdateGLTexture(enginedata, glyph->atlas->texture, &glyph->rect, surface->pixels, surface->pitch);
-    glyph->image_type = image_type;
     return true;
 }
 
@@ -414,28 +553,26 @@ static bool AddGlyphToFont(TTF_GLTextEngineFontData *fontdata, TTF_Font *glyph_f
     return true;
 }
 
-static bool ResolveMissingGlyphs(TTF_GLTextEngineData *enginedata, AtlasTexture *atlas, TTF_GLTextEngineFontData *fontdata, GlyphSurface *surfaces, TTF_DrawOperation *ops, int num_ops, stbrp_rect *missing, int num_missing)
+static bool ResolveMissingGlyphs(TTF_GLTextEngineData *enginedata, AtlasTexture *atlas, TTF_GLTextEngineFontData *fontdata, GlyphSurface *surfaces, GlyphUpload *uploads, TTF_DrawOperation *ops, int num_ops, stbrp_rect *missing, int num_missing)
 {
+    int num_uploads = 0;
+    bool result = false;
+
     // See if we can reuse any existing entries
-    if (atlas->free_glyphs) {
+    if (HasFreeGlyphs(atlas)) {
         // Search from the smallest to the largest to minimize time spent searching the free list and shortening the missing entries
         for (int i = num_missing; i--;) {
-            AtlasGlyph *glyph = FindUnusedGlyph(atlas, missing[i].w, missing[i].h);
+            AtlasGlyph *glyph = FindUnusedGlyph(atlas, enginedata->atlas_texture_size, missing[i].w, missing[i].h);
             if (!glyph) {
                 continue;
             }
 
-            GlyphSurface *surface = &surfaces[missing[i].id];
-            if (!UpdateGlyph(enginedata, glyph, surface->surface, surface->image_type)) {
-                ReleaseGlyph(glyph);
-                return false;
-            }
-
             TTF_DrawOperation *op = &ops[missing[i].id];
             if (!AddGlyphToFont(fontdata, op->copy.glyph_font, op->copy.glyph_index, glyph)) {
                 ReleaseGlyph(glyph);
-                return false;
+                goto done;
             }
+            QueueGlyphUpload(uploads, &num_uploads, glyph, &surfaces[missing[i].id], true);
 
             op->copy.reserved = glyph;
 
@@ -446,7 +583,8 @@ static bool ResolveMissingGlyphs(TTF_GLTextEngineData *enginedata, AtlasTexture
             }
         }
         if (num_missing == 0) {
-            return true;
+            result = true;
+            goto done;
         }
     }
 
@@ -460,26 +598,22 @@ static bool ResolveMissingGlyphs(TTF_GLTextEngineData *enginedata, AtlasTexture
 
         AtlasGlyph *glyph = CreateGlyph(atlas, enginedata->atlas_texture_size, &missing[i]);
         if (!glyph) {
-            return false;
-        }
-
-        GlyphSurface *surface = &surfaces[missing[i].id];
-        if (!UpdateGlyph(enginedata, glyph, surface->surface, surface->image_type)) {
-            ReleaseGlyph(glyph);
-            return false;
+            goto done;
         }
 
         TTF_DrawOperation *op = &ops[missing[i].id];
         if (!AddGlyphToFont(fontdata, op->copy.glyph_font, op->copy.glyph_index, glyph)) {
             ReleaseGlyph(glyph);
-            return false;
+            goto done;
         }
+        QueueGlyphUpload(uploads, &num_uploads, glyph, &surfaces[missing[i].id], false);
 
         op->copy.reserved = glyph;
     }
 
     if (all_packed) {
-        return true;
+        result = true;
+        goto done;
     }
 
     // Sort the remaining missing glyphs and try in the next atlas
@@ -492,19 +626,32 @@ static bool ResolveMissingGlyphs(TTF_GLTextEngineData *enginedata, AtlasTexture
         }
     }
 
+    // Upload everything placed so far before moving on to the next atlas
+    if (!UploadGlyphs(enginedata, uploads, num_uploads)) {
+        return false;
+    }
+    num_uploads = 0;
+
     if (!atlas->next) {
         atlas->next = CreateAtlas(enginedata, enginedata->atlas_texture_size);
         if (!atlas->next) {
             return false;
         }
     }
-    return ResolveMissingGlyphs(enginedata, atlas->next, fontdata, surfaces, ops, num_ops, missing, num_missing);
+    return ResolveMissingGlyphs(enginedata, atlas->next, fontdata, surfaces, uploads, ops, num_ops, missing, num_missing);
+
+done:
+    if (!UploadGlyphs(enginedata, uploads, num_uploads)) {
+        result = false;
+    }
+    return result;
 }
 
 static bool CreateMissingGlyphs(TTF_GLTextEngineData *enginedata, TTF_GLTextEngineFontData *fontdata, TTF_DrawOperation *ops, int num_ops, int num_missing)
 {
     stbrp_rect *missing = NULL;
     GlyphSurface *surfaces = NULL;
+    GlyphUpload *uploads = NULL;
     SDL_HashTable *checked = NULL;
     bool result = false;
     int atlas_texture_size = enginedata->atlas_texture_size;
@@ -520,6 +667,11 @@ static bool CreateMissingGlyphs(TTF_GLTextEngineData *enginedata, TTF_GLTextEngi
         goto done;
     }
 
+    uploads = (GlyphUpload *)SDL_malloc(num_missing * sizeof(*uploads));
+    if (!uploads) {
+        goto done;
+    }
+
     checked = SDL_CreateGlyphHashTable(NULL);
     if (!checked) {
         goto done;
@@ -539,7 +691,7 @@ static bool CreateMissingGlyphs(TTF_GLTextEngineData *enginedata, TTF_GLTextEngi
             }
 
             TTF_ImageType image_type = TTF_IMAGE_INVALID;
-            SDL_Surface *surface = TTF_GetGlyphImageForIndex(glyph_font, glyph_index, &image_type);
+            SDL_Surface *surface = TTF_GetGlyphImageForKey(glyph_font, glyph_index, &image_type);
             if (!surface) {
                 goto done;
             }
@@ -555,8 +707,8 @@ static bool CreateMissingGlyphs(TTF_GLTextEngineData *enginedata, TTF_GLTextEngi
 
             missing[missing_index].id = i;
             // Add one pixel extra padding between glyphs
-            missing[missing_index].w = surface->w + 1;
-            missing[missing_index].h = surface->h + 1;
+            missing[missing_index].w = surface->w + GLYPH_PADDING;
+            missing[missing_index].h = surface->h + GLYPH_PADDING;
             ++missing_index;
         }
     }
@@ -573,7 +725,7 @@ static bool CreateMissingGlyphs(TTF_GLTextEngineData *enginedata, TTF_GLTextEngi
         }
     }
 
-    if (!ResolveMissingGlyphs(enginedata, enginedata->atlas, fontdata, surfaces, ops, num_ops, missing, num_missing)) {
+    if (!ResolveMissingGlyphs(enginedata, enginedata->atlas, fontdata, surfaces, uploads, ops, num_ops, missing, num_missing)) {
         goto done;
     }
 
@@ -598,6 +750,7 @@ done:
         }
         SDL_free(surfaces);
     }
+    SDL_free(uploads);
     SDL_free(missing);
     return result;
 }
@@ -612,6 +765,8 @@ static void DestroyDrawSequence(AtlasDrawSequence *data)
         DestroyDrawSequence(data->next);
     }
     SDL_free(data->vertices);
+    SDL_free(data->packed_vertices);
+    SDL_free(data->instances);
     SDL_free(data->indices);
     SDL_free(data);
 }
@@ -634,37 +789,11 @@ static TTF_ImageType GetOperationImageType(TTF_DrawOperation *op)
     return TTF_IMAGE_INVALID;
 }
 
-static AtlasDrawSequence *CreateDrawSequence(TTF_DrawOperation *ops, int num_ops, TTF_GLTextEngineWinding winding)
+static bool CreateFloatVertices(AtlasDrawSequence *sequence, TTF_DrawOperation *ops, int count, unsigned int texture)
 {
-    AtlasDrawSequence *sequence = (AtlasDrawSequence *)SDL_calloc(1, sizeof(*sequence));
-    if (!sequence) {
-        return NULL;
-    }
-
-    SDL_assert(num_ops > 0);
-    SDL_COMPILE_TIME_ASSERT(sizeof_SDL_FPoint, sizeof(SDL_FPoint) == 2 * sizeof(float));
-
-    unsigned int texture = GetOperationTexture(&ops[0]);
-    TTF_ImageType image_type = GetOperationImageType(&ops[0]);
-    TTF_DrawOperation *end = NULL;
-    for (int i = 1; i < num_ops; ++i) {
-        if (GetOperationTexture(&ops[i]) != texture ||
-            GetOperationImageType(&ops[i]) != image_type) {
-            end = &ops[i];
-            break;
-        }
-    }
-
-    int count = (end ? (int)(end - ops) : num_ops);
-    sequence->atlas_texture = texture;
-    sequence->image_type = image_type;
-    sequence->num_vertices = count * 4;
-    sequence->num_indices = count * 6;
-
     sequence->vertices = (TTF_GLAtlasDrawVertex *)SDL_malloc(count * 4 * sizeof(*sequence->vertices));
     if (!sequence->vertices) {
-        DestroyDrawSequence(sequence);
-        return NULL;
+        return false;
     }
 
     TTF_GLAtlasDrawVertex *vtx = sequence->vertices;
@@ -738,11 +867,143 @@ static AtlasDrawSequence *CreateDrawSequence(TTF_DrawOperation *ops, int num_ops
         vtx->texcoord.y = v3;
         vtx++;
     }
+    return true;
+}
+
+static Uint16 PackTexcoord(float value)
+{
+    return (Uint16)(SDL_clamp(value, 0.0f, 1.0f) * 65535.0f + 0.5f);
+}
+
+static Sint16 PackPosition(float value)
+{
+    return (Sint16)SDL_clamp(value, (float)SDL_MIN_SINT16, (float)SDL_MAX_SINT16);
+}
+
+static Uint8 PackColor(float value)
+{
+    return (Uint8)(SDL_clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+static void SetPackedColor(AtlasDrawSequence *sequence, const SDL_FColor *color)
+{
+    const Uint8 r = PackColor(color->r);
+    const Uint8 g = PackColor(color->g);
+    const Uint8 b = PackColor(color->b);
+    const Uint8 a = PackColor(color->a);
+
+    for ( ; sequence; sequence = sequence->next) {
+        TTF_PackedTextVertex *vtx = sequence->packed_vertices;
+        for (int i = 0; i < sequence->num_vertices; ++i, ++vtx) {
+            vtx->r = r;
+            vtx->g = g;
+            vtx->b = b;
+            vtx->a = a;
+        }
+    }
+}
+
+static bool CreatePackedVertices(AtlasDrawSequence *sequence, TTF_DrawOperation *ops, int count)
+{
+    static const float fill_texcoords[] = { 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f, 0.0f, 1.0f };
+
+    sequence->packed_vertices = (TTF_PackedTextVertex *)SDL_calloc(count * 4, sizeof(*sequence->packed_vertices));
+    if (!sequence->packed_vertices) {
+        return false;
+    }
+
+    TTF_PackedTextVertex *vtx = sequence->packed_vertices;
+    for (int i = 0; i < count; ++i) {
+        TTF_DrawOperation *op = &ops[i];
+        const SDL_Rect *dst;
+        const float *texcoords;
+        if (op->cmd == TTF_DRAW_COMMAND_COPY) {
+            dst = &op->copy.dst;
+            texcoords = ((AtlasGlyph *)op->copy.reserved)->texcoords;
+        } else {
+            dst = &op->fill.rect;
+            texcoords = fill_texcoords;
+        }
 
+        float minx = (float)dst->x;
+        float maxx = (float)(dst->x + dst->w);
+        float miny = (float)dst->y;
+        float maxy = (float)(dst->y + dst->h);
+
+        /* Ensure fill rects are at least 3px tall for shader-based edge AA,
+         * rounded outwards since packed positions are whole pixels */
+        if (op->cmd == TTF_DRAW_COMMAND_FILL && dst->h < 3) {
+            float pad = (3.0f - dst->h) / 2.0f;
+            miny = SDL_floorf(miny - pad);
+            maxy = SDL_ceilf(maxy + pad);
+        }
+
+        // In OpenGL positive y-axis is upwards so the signs of the y-coords are reversed
+        const float positions[] = { minx, -miny, maxx, -miny, maxx, -maxy, minx, -maxy };
+        for (int j = 0; j < 4; ++j, ++vtx) {
+            vtx->x = PackPosition(positions[j * 2 + 0]);
+            vtx->y = PackPosition(positions[j * 2 + 1]);
+            vtx->u = PackTexcoord(texcoords[j * 2 + 0]);
+            vtx->v = PackTexcoord(texcoords[j * 2 + 1]);
+        }
+    }
+    return true;
+}
+
+static bool CreateInstances(AtlasDrawSequence *sequence, TTF_DrawOperation *ops, int count)
+{
+    sequence->instances = (TTF_TextInstance *)SDL_malloc(count * sizeof(*sequence->instances));
+    if (!sequence->instances) {
+        return false;
+    }
+    sequence->num_instances = count;
+
+    TTF_TextInstance *instance = sequence->instances;
+    for (int i = 0; i < count; ++i, ++instance) {
+        TTF_DrawOperation *op = &ops[i];
+        const SDL_Rect *dst;
+        if (op->cmd == TTF_DRAW_COMMAND_COPY) {
+            AtlasGlyph *glyph = (AtlasGlyph *)op->copy.reserved;
+            dst = &op->copy.dst;
+            instance->uv.x = glyph->texcoords[0];
+            instance->uv.y = glyph->texcoords[1];
+            instance->uv.w = glyph->texcoords[4] - glyph->texcoords[0];
+            instance->uv.h = glyph->texcoords[5] - glyph->texcoords[1];
+            instance->image_type = glyph->image_type;
+            instance->text_offset = op->copy.text_offset;
+        } else {
+            dst = &op->fill.rect;
+            instance->uv.x = 0.0f;
+            instance->uv.y = 0.0f;
+            instance->uv.w = 1.0f;
+            instance->uv.h = 1.0f;
+            instance->image_type = TTF_IMAGE_INVALID;
+            instance->text_offset = -1;
+        }
+
+        float miny = (float)dst->y;
+        float h = (float)dst->h;
+
+        /* Ensure fill rects are at least 3px tall for shader-based edge AA */
+        if (op->cmd == TTF_DRAW_COMMAND_FILL && dst->h < 3) {
+            miny -= (3.0f - dst->h) / 2.0f;
+            h = 3.0f;
+        }
+
+        // In OpenGL positive y-axis is upwards so the signs of the y-coords are reversed
+        instance->dst.x = (float)dst->x;
+        instance->dst.y = -miny;
+        instance->dst.w = (float)dst->w;
+        instance->dst.h = h;
+    }
+    return true;
+}
+
+static bool CreateIndices(AtlasDrawSequence *sequence, int count, TTF_GLTextEngineWinding winding)
+{
     sequence->indices = (Uint16 *)SDL_malloc(count * 6 * sizeof(*sequence->indices));
     if (!sequence->indices) {
-        DestroyDrawSequence(sequence);
-        return NULL;
+        return false;
     }
 
     static const Uint8 rect_index_order_cw[] = { 0, 1, 2, 0, 2, 3 };
@@ -766,9 +1027,58 @@ static AtlasDrawSequence *CreateDrawSequence(TTF_DrawOperation *ops, int num_ops
         *indices++ = vertex_index + rect_index_order[5];
         vertex_index += 4;
     }
+    return true;
+}
+
+static AtlasDrawSequence *CreateDrawSequence(TTF_DrawOperation *ops, int num_ops, TTF_GLTextEngineWinding winding, TTF_TextVertexFormat format)
+{
+    AtlasDrawSequence *sequence = (AtlasDrawSequence *)SDL_calloc(1, sizeof(*sequence));
+    if (!sequence) {
+        return NULL;
+    }
+
+    SDL_assert(num_ops > 0);
+    SDL_COMPILE_TIME_ASSERT(sizeof_SDL_FPoint, sizeof(SDL_FPoint) == 2 * sizeof(float));
+
+    unsigned int texture = GetOperationTexture(&ops[0]);
+    TTF_ImageType image_type = GetOperationImageType(&ops[0]);
+    TTF_DrawOperation *end = NULL;
+    for (int i = 1; i < num_ops; ++i) {
+        if (GetOperationTexture(&ops[i]) != texture ||
+            GetOperationImageType(&ops[i]) != image_type) {
+            end = &ops[i];
+            break;
+        }
+    }
+
+    int count = (end ? (int)(end - ops) : num_ops);
+    sequence->atlas_texture = texture;
+    sequence->image_type = image_type;
+
+    if (format == TTF_TEXT_VERTEX_FORMAT_INSTANCED) {
+        if (!CreateInstances(sequence, ops, count)) {
+            DestroyDrawSequence(sequence);
+            return NULL;
+        }
+    } else {
+        count = SDL_min(count, MAX_SEQUENCE_GLYPHS);
+        sequence->num_vertices = count * 4;
+        sequence->num_indices = count * 6;
+
+        bool result;
+        if (format == TTF_TEXT_VERTEX_FORMAT_PACKED) {
+            result = CreatePackedVertices(sequence, ops, count);
+        } else {
+            result = CreateFloatVertices(sequence, ops, count, texture);
+        }
+        if (!result || !CreateIndices(sequence, count, winding)) {
+            DestroyDrawSequence(sequence);
+            return NULL;
+        }
+    }
 
     if (count < num_ops) {
-        sequence->next = CreateDrawSequence(ops + count, num_ops - count, winding);
+        sequence->next = CreateDrawSequence(ops + count, num_ops - count, winding, format);
         if (!sequence->next) {
             DestroyDrawSequence(sequence);
             return NULL;
@@ -792,7 +1102,7 @@ static void DestroyTextData(TTF_GLTextEngineTextData *data)
     SDL_free(data);
 }
 
-static TTF_GLTextEngineTextData *CreateTextData(TTF_GLTextEngineData *enginedata, TTF_GLTextEngineFontData *fontdata, TTF_DrawOperation *ops, int num_ops)
+static TTF_GLTextEngineTextData *CreateTextData(TTF_GLTextEngineData *enginedata, TTF_GLTextEngineFontData *fontdata, TTF_DrawOperation *ops, int num_ops, const SDL_FColor *color)
 {
     TTF_GLTextEngineTextData *data = (TTF_GLTextEngineTextData *)SDL_calloc(1, sizeof(*data));
     if (!data) {
@@ -842,11 +1152,16 @@ static TTF_GLTextEngineTextData *CreateTextData(TTF_GLTextEngineData *enginedata
     SDL_qsort(ops, num_ops, sizeof(*ops), SortOperations);
 
     // Create batched draw sequences
-    data->draw_sequence = CreateDrawSequence(ops, num_ops, enginedata->winding);
+    data->format = enginedata->format;
+    data->draw_sequence = CreateDrawSequence(ops, num_ops, enginedata->winding, data->format);
     if (!data->draw_sequence) {
         DestroyTextData(data);
         return NULL;
     }
+    if (data->format == TTF_TEXT_VERTEX_FORMAT_PACKED) {
+        SetPackedColor(data->draw_sequence, color);
+        SDL_copyp(&data->color, color);
+    }
 
     return data;
 }
@@ -857,6 +1172,7 @@ static void DestroyFontData(TTF_GLTextEngineFontData *data)
         if (data->glyphs) {
             SDL_DestroyGlyphHashTable(data->glyphs);
         }
+        SDL_DestroyGlyphHashTableGenerations(&data->previous_glyphs);
         SDL_free(data);
     }
 }
@@ -904,6 +1220,7 @@ static void DestroyEngineData(TTF_GLTextEngineData *data)
         next = atlas->next;
         DestroyAtlas(data, atlas);
     }
+    SDL_free(data->staging);
     SDL_free(data);
 }
 
@@ -949,6 +1266,15 @@ static bool ProbeGLCapabilities(TTF_GLTextEngineData *data)
         data->has_unpack_row_length = true;
     }
 
+    /* Glyphs are converted to the upload byte order while staging them */
+    if (data->has_bgra) {
+        data->upload_format = SDL_PIXELFORMAT_BGRA32;
+        data->upload_gl_format = GL_BGRA;
+    } else {
+        data->upload_format = SDL_PIXELFORMAT_RGBA32;
+        data->upload_gl_format = GL_RGBA;
+    }
+
     return true;
 }
 
@@ -960,6 +1286,7 @@ static TTF_GLTextEngineData *CreateEngineData(int atlas_texture_size)
     }
     data->atlas_texture_size = atlas_texture_size;
     data->winding = TTF_GL_TEXTENGINE_WINDING_CLOCKWISE;
+    data->format = TTF_TEXT_VERTEX_FORMAT_FLOAT;
 
     if (!LoadGLFunctions(data)) {
         DestroyEngineData(data);
@@ -995,8 +1322,10 @@ static bool SDLCALL CreateText(void *userdata, TTF_Text *text)
             return false;
         }
     } else if (font_generation != fontdata->generation) {
-        SDL_ClearHashTable(fontdata->glyphs);
-        fontdata->generation = font_generation;
+        // Keep the glyphs of recent generations, the font may switch back to them
+        if (!SDL_SwitchGlyphHashTable(&fontdata->previous_glyphs, &fontdata->glyphs, &fontdata->generation, font_generation, NukeGlyph)) {
+            return false;
+        }
     }
 
     // Make a sortable copy of the draw operations
@@ -1005,8 +1334,9 @@ static bool SDLCALL CreateText(void *userdata, TTF_Text *text)
         return false;
     }
     SDL_memcpy(ops, text->internal->ops, num_ops * sizeof(*ops));
+    TTF_SetGlyphKeys(text->internal, ops);
 
-    data = CreateTextData(enginedata, fontdata, ops, num_ops);
+    data = CreateTextData(enginedata, fontdata, ops, num_ops, &text->internal->color);
     SDL_free(ops);
     if (!data) {
         return false;
@@ -1089,6 +1419,11 @@ AtlasDrawSequence *TTF_GetGLTextDrawData(TTF_Text *text)
         return NULL;
     }
 
+    if (data->format == TTF_TEXT_VERTEX_FORMAT_PACKED &&
+        SDL_memcmp(&data->color, &text->internal->color, sizeof(data->color)) != 0) {
+        SetPackedColor(data->draw_sequence, &text->internal->color);
+        SDL_copyp(&data->color, &text->internal->color);
+    }
     return data->draw_sequence;
 }
 
@@ -1116,3 +1451,30 @@ TTF_GLTextEngineWinding TTF_GetGLTextEngineWinding(const TTF_TextEngine *engine)
 
     return ((TTF_GLTextEngineData *)engine->userdata)->winding;
 }
+
+void TTF_SetGLTextEngineVertexFormat(TTF_TextEngine *engine, TTF_TextVertexFormat format)
+{
+    if (!engine || engine->CreateText != CreateText) {
+        SDL_InvalidParamError("engine");
+        return;
+    }
+
+    if (format != TTF_TEXT_VERTEX_FORMAT_FLOAT &&
+        format != TTF_TEXT_VERTEX_FORMAT_PACKED &&
+        format != TTF_TEXT_VERTEX_FORMAT_INSTANCED) {
+        SDL_InvalidParamError("format");
+        return;
+    }
+
+    ((TTF_GLTextEngineData *)engine->userdata)->format = format;
+}
+
+TTF_TextVertexFormat TTF_GetGLTextEngineVertexFormat(const TTF_TextEngine *engine)
+{
+    if (!engine || engine->CreateText != CreateText) {
+        SDL_InvalidParamError("engine");
+        return TTF_TEXT_VERTEX_FORMAT_INVALID;
+    }
+
+    return ((TTF_GLTextEngineData *)engine->userdata)->format;
+}
@@ -24,6 +24,7 @@
 
 #include "SDL_hashtable.h"
 #include "SDL_hashtable_ttf.h"
+#include "SDL_ttf_internal.h"
 
 #define STB_RECT_PACK_IMPLEMENTATION
 #define STBRP_STATIC
@@ -32,6 +33,18 @@
 #define STBRP__CDECL SDLCALL
 #include "stb_rect_pack.h"
 
+// Extra padding between glyphs, to avoid bleeding when sampling
+#define GLYPH_PADDING 1
+
+// Free areas are binned by power of two size class
+#define NUM_FREE_GLYPH_BINS 16
+
+// Free areas smaller than this in either dimension aren't worth keeping
+#define MIN_FREE_GLYPH_SIZE 4
+
+// Packed draw sequences use 16-bit indices, so they can't have more than 65536 vertices
+#define MAX_PACKED_GLYPHS   (65536 / 4)
+
 typedef struct AtlasGlyph AtlasGlyph;
 typedef struct AtlasTexture AtlasTexture;
 typedef struct TTF_GPUAtlasDrawSequence AtlasDrawSequence;
@@ -57,7 +70,7 @@ struct AtlasTexture
     SDL_GPUTexture *texture;
     stbrp_context packer;
     stbrp_node *packing_nodes;
-    AtlasGlyph *free_glyphs;
+    AtlasGlyph *free_glyphs[NUM_FREE_GLYPH_BINS];
     AtlasTexture *next;
 };
 
@@ -65,6 +78,8 @@ typedef struct TTF_GPUTextEngineTextData
 {
     int num_glyphs;
     AtlasGlyph **glyphs;
+    TTF_TextVertexFormat format;
+    SDL_FColor color;
     AtlasDrawSequence *draw_sequence;
 } TTF_GPUTextEngineTextData;
 
@@ -73,6 +88,7 @@ typedef struct TTF_GPUTextEngineFontData
     TTF_Font *font;
     Uint32 generation;
     SDL_HashTable *glyphs;
+    SDL_GlyphHashTableGenerations previous_glyphs;
 } TTF_GPUTextEngineFontData;
 
 typedef struct TTF_GPUTextEngineData
@@ -82,6 +98,7 @@ typedef struct TTF_GPUTextEngineData
     AtlasTexture *atlas;
     int atlas_texture_size;
     TTF_GPUTextEngineWinding winding;
+    TTF_TextVertexFormat format;
 } TTF_GPUTextEngineData;
 
 static int SDLCALL SortMissing(void *userdata, const void *a, const void *b)
@@ -168,10 +185,12 @@ static void DestroyAtlas(SDL_GPUDevice *device, AtlasTexture *atlas)
         return;
     }
 
-    AtlasGlyph *next;
-    for (AtlasGlyph *glyph = atlas->free_glyphs; glyph; glyph = next) {
-        next = glyph->next;
-        DestroyGlyph(glyph);
+    for (int i = 0; i < NUM_FREE_GLYPH_BINS; ++i) {
+        AtlasGlyph *next;
+        for (AtlasGlyph *glyph = atlas->free_glyphs[i]; glyph; glyph = next) {
+            next = glyph->next;
+            DestroyGlyph(glyph);
+        }
     }
 
     SDL_ReleaseGPUTexture(device, atlas->texture);
@@ -225,6 +244,58 @@ static AtlasTexture *CreateAtlas(SDL_GPUDevice *device, int atlas_texture_size)
     return atlas;
 }
 
+static int GetFreeGlyphBin(int width, int height)
+{
+    int size = SDL_max(width, height);
+    int bin = 0;
+    while (bin < (NUM_FREE_GLYPH_BINS - 1) && (1 << bin) < size) {
+        ++bin;
+    }
+    return bin;
+}
+
+static void AddFreeGlyph(AtlasTexture *atlas, AtlasGlyph *glyph)
+{
+    // Insert into the free list for this size class, sorted smallest first
+    AtlasGlyph **bin = &atlas->free_glyphs[GetFreeGlyphBin(glyph->rect.w, glyph->rect.h)];
+    AtlasGlyph *entry, *prev = NULL;
+    int size = (glyph->rect.w * glyph->rect.h);
+    for (entry = *bin; entry; entry = entry->next) {
+        if (size <= (entry->rect.w * entry->rect.h)) {
+            break;
+        }
+
+        prev = entry;
+    }
+
+    if (prev) {
+        prev->next = glyph;
+    } else {
+        *bin = glyph;
+    }
+    glyph->next = entry;
+}
+
+static void AddFreeArea(AtlasTexture *atlas, int x, int y, int w, int h)
+{
+    if (w < MIN_FREE_GLYPH_SIZE || h < MIN_FREE_GLYPH_SIZE) {
+        return;
+    }
+
+    AtlasGlyph *glyph = (AtlasGlyph *)SDL_calloc(1, sizeof(*glyph));
+    if (!glyph) {
+        // Not fatal, we just won't be able to reuse this area
+        return;
+    }
+
+    glyph->atlas = atlas;
+    glyph->rect.x = x;
+    glyph->rect.y = y;
+    glyph->rect.w = w;
+    glyph->rect.h = h;
+    AddFreeGlyph(atlas, glyph);
+}
+
 static void ReleaseGlyph(AtlasGlyph *glyph)
 {
     if (!glyph) {
@@ -234,43 +305,23 @@ static void ReleaseGlyph(AtlasGlyph *glyph)
     --glyph->refcount;
     if (glyph->refcount == 0) {
         if (glyph->atlas) {
-            // Insert into free list sorted smallest first
-            AtlasGlyph *entry, *prev = NULL;
-            int size = (glyph->rect.w * glyph->rect.h);
-            for (entry = glyph->atlas->free_glyphs; entry; entry = entry->next) {
-                if (size <= (entry->rect.w * entry->rect.h)) {
-                    break;
-                }
-
-                prev = entry;
-            }
-
-            if (prev) {
-                prev->next = glyph;
-            } else {
-                glyph->atlas->free_glyphs = glyph;
-            }
-            glyph->next = entry;
+            // Free areas include the padding between glyphs
+            glyph->rect.w += GLYPH_PADDING;
+            glyph->rect.h += GLYPH_PADDING;
+            AddFreeGlyph(glyph->atlas, glyph);
         } else {
             DestroyGlyph(glyph);
         }
     }
 }
 
-static AtlasGlyph *CreateGlyph(AtlasTexture *atlas, int atlas_texture_size, const stbrp_rect *area)
+static void SetGlyphArea(AtlasGlyph *glyph, int atlas_texture_size, int x, int y, int w, int h)
 {
-    AtlasGlyph *glyph = (AtlasGlyph *)SDL_calloc(1, sizeof(*glyph));
-    if (!glyph) {
-        return NULL;
-    }
-
-    glyph->refcount = 1;
-    glyph->atlas = atlas;
-    glyph->rect.x = area->x;
-    glyph->rect.y = area->y;
+    glyph->rect.x = x;
+    glyph->rect.y = y;
     // Remove the one pixel extra padding between glyphs
-    glyph->rect.w = area->w - 1;
-    glyph->rect.h = area->h - 1;
+    glyph->rect.w = w - GLYPH_PADDING;
+    glyph->rect.h = h - GLYPH_PADDING;
 
     const float minu = (float)glyph->rect.x / atlas_texture_size;
     const float minv = (float)glyph->rect.y / atlas_texture_size;
@@ -284,36 +335,73 @@ static AtlasGlyph *CreateGlyph(AtlasTexture *atlas, int atlas_texture_size, cons
     glyph->texcoords[5] = maxv;
     glyph->texcoords[6] = minu;
     glyph->texcoords[7] = maxv;
+}
+
+static AtlasGlyph *CreateGlyph(AtlasTexture *atlas, int atlas_texture_size, const stbrp_rect *area)
+{
+    AtlasGlyph *glyph = (AtlasGlyph *)SDL_calloc(1, sizeof(*glyph));
+    if (!glyph) {
+        return NULL;
+    }
+
+    glyph->refcount = 1;
+    glyph->atlas = atlas;
+    SetGlyphArea(glyph, atlas_texture_size, area->x, area->y, area->w, area->h);
 
     return glyph;
 }
 
-static AtlasGlyph *FindUnusedGlyph(AtlasTexture *atlas, int width, int height)
+static bool HasFreeGlyphs(AtlasTexture *atlas)
 {
-    AtlasGlyph *glyph, *prev = NULL;
-
-    int size = (width * height);
-    for (glyph = atlas->free_glyphs; glyph; glyph = glyph->next) {
-        if (width == glyph->rect.w && height == glyph->rect.h) {
-            if (prev) {
-                prev->next = glyph->next;
-            } else {
-                atlas->free_glyphs = glyph->next;
+    for (; atlas; atlas = atlas->next) {
+        for (int i = 0; i < NUM_FREE_GLYPH_BINS; ++i) {
+            if (atlas->free_glyphs[i]) {
+                return true;
             }
-            ++glyph->refcount;
-            return glyph;
         }
+    }
+    return false;
+}
 
-        if (size < (glyph->rect.w * glyph->rect.h)) {
-            // We didn't find any entries our size, everything else is larger than we want
-            break;
-        }
+static AtlasGlyph *FindUnusedGlyph(AtlasTexture *atlas, int atlas_texture_size, int width, int height)
+{
+    for (; atlas; atlas = atlas->next) {
+        // Areas in smaller size classes can't fit this glyph
+        for (int bin = GetFreeGlyphBin(width, height); bin < NUM_FREE_GLYPH_BINS; ++bin) {
+            AtlasGlyph *glyph, *prev = NULL;
+            for (glyph = atlas->free_glyphs[bin]; glyph; prev = glyph, glyph = glyph->next) {
+                if (width > glyph->rect.w || height > glyph->rect.h) {
+                    continue;
+                }
 
-        prev = glyph;
-    }
+                // This is the smallest area in this size class that fits
+                if (prev) {
+                    prev->next = glyph->next;
+                } else {
+                    atlas->free_glyphs[bin] = glyph->next;
+                }
+                glyph->next = NULL;
+
+                // Split off the rest of the area, leaving the larger piece in one rectangle
+                int x = glyph->rect.x;
+                int y = glyph->rect.y;
+                int w = glyph->rect.w;
+                int h = glyph->rect.h;
+                int right = (w - width);
+                int bottom = (h - height);
+                if (right < bottom) {
+                    AddFreeArea(atlas, x + width, y, right, height);
+                    AddFreeArea(atlas, x, y + height, w, bottom);
+                } else {
+                    AddFreeArea(atlas, x + width, y, right, h);
+                    AddFreeArea(atlas, x, y + height, width, bottom);
+                }
 
-    if (atlas->next) {
-        return FindUnusedGlyph(atlas->next, width, height);
+                SetGlyphArea(glyph, atlas_texture_size, x, y, width, height);
+                ++glyph->refcount;
+                return glyph;
+            }
+        }
     }
     return NULL;
 }
@@ -385,12 +473,38 @@ static bool UpdateGPUTexture(SDL_GPUDevice *device, SDL_GPUTexture *texture,
     return true;
 }
 
-static bool UpdateGlyph(SDL_GPUDevice *device, AtlasGlyph *glyph, SDL_Surface *surface, TTF_ImageType image_type)
+static bool UpdateGlyph(SDL_GPUDevice *device, AtlasGlyph *glyph, SDL_Surface *surface, TTF_ImageType image_type, bool clear_padding)
 {
     SDL_assert(glyph->rect.w > 0 && glyph->rect.h > 0);
 
     /* FIXME: We should update the whole texture at once or at least cache the transfer buffers */
-    UpdateGPUTexture(device, glyph->atlas->texture, &glyph->rect, surface->pixels, surface->pitch);
+    if (clear_padding) {
+        // This area was used before, so the padding around the glyph may have stale pixels
+        SDL_Rect rect = glyph->rect;
+        rect.w += GLYPH_PADDING;
+        rect.h += GLYPH_PADDING;
+
+        const int pitch = rect.w * 4;
+        Uint8 *pixels = (Uint8 *)SDL_calloc(rect.h, pitch);
+        if (!pixels) {
+            return false;
+        }
+
+        const Uint8 *src = (const Uint8 *)surface->pixels;
+        Uint8 *dst = pixels;
+        for (int y = 0; y < glyph->rect.h; ++y) {
+            SDL_memcpy(dst, src, glyph->rect.w * 4);
+            src += surface->pitch;
+            dst += pitch;
+        }
+        bool result = UpdateGPUTexture(device, glyph->atlas->texture, &rect, pixels, pitch);
+        SDL_free(pixels);
+        if (!result) {
+            return false;
+        }
+    } else {
+        UpdateGPUTexture(device, glyph->atlas->texture, &glyph->rect, surface->pixels, surface->pitch);
+    }
     glyph->image_type = image_type;
     return true;
 }
@@ -406,16 +520,16 @@ static bool AddGlyphToFont(TTF_GPUTextEngineFontData *fontdata, TTF_Font *glyph_
 static bool ResolveMissingGlyphs(TTF_GPUTextEngineData *enginedata, AtlasTexture *atlas, TTF_GPUTextEngineFontData *fontdata, GlyphSurface *surfaces, TTF_DrawOperation *ops, int num_ops, stbrp_rect *missing, int num_missing)
 {
     // See if we can reuse any existing entries
-    if (atlas->free_glyphs) {
+    if (HasFreeGlyphs(atlas)) {
         // Search from the smallest to the largest to minimize time spent searching the free list and shortening the missing entries
         for (int i = num_missing; i--;) {
-            AtlasGlyph *glyph = FindUnusedGlyph(atlas, missing[i].w, missing[i].h);
+            AtlasGlyph *glyph = FindUnusedGlyph(atlas, enginedata->atlas_texture_size, missing[i].w, missing[i].h);
             if (!glyph) {
                 continue;
             }
 
             GlyphSurface *surface = &surfaces[missing[i].id];
-            if (!UpdateGlyph(enginedata->device, glyph, surface->surface, surface->image_type)) {
+            if (!UpdateGlyph(enginedata->device, glyph, surface->surface, surface->image_type, true)) {
                 ReleaseGlyph(glyph);
                 return false;
             }
@@ -453,7 +567,7 @@ static bool ResolveMissingGlyphs(TTF_GPUTextEngineData *enginedata, AtlasTexture
         }
 
         GlyphSurface *surface = &surfaces[missing[i].id];
-        if (!UpdateGlyph(enginedata->device, glyph, surface->surface, surface->image_type)) {
+        if (!UpdateGlyph(enginedata->device, glyph, surface->surface, surface->image_type, false)) {
             ReleaseGlyph(glyph);
             return false;
         }
@@ -528,7 +642,7 @@ static bool CreateMissingGlyphs(TTF_GPUTextEngineData *enginedata, TTF_GPUTextEn
             }
 
             TTF_ImageType image_type = TTF_IMAGE_INVALID;
-            SDL_Surface *surface = TTF_GetGlyphImageForIndex(glyph_font, glyph_index, &image_type);
+            SDL_Surface *surface = TTF_GetGlyphImageForKey(glyph_font, glyph_index, &image_type);
             if (!surface) {
                 goto done;
             }
@@ -544,8 +658,8 @@ static bool CreateMissingGlyphs(TTF_GPUTextEngineData *enginedata, TTF_GPUTextEn
 
             missing[missing_index].id = i;
             // Add one pixel extra padding between glyphs
-            missing[missing_index].w = surface->w + 1;
-            missing[missing_index].h = surface->h + 1;
+            missing[missing_index].w = surface->w + GLYPH_PADDING;
+            missing[missing_index].h = surface->h + GLYPH_PADDING;
             ++missing_index;
         }
     }
@@ -603,6 +717,9 @@ static void DestroyDrawSequence(AtlasDrawSequence *data)
     SDL_free(data->xy);
     SDL_free(data->uv);
     SDL_free(data->indices);
+    SDL_free(data->packed_vertices);
+    SDL_free(data->instances);
+    SDL_free(data->packed_indices);
     SDL_free(data);
 }
 
@@ -624,37 +741,101 @@ static TTF_ImageType GetOperationImageType(TTF_DrawOperation *op)
     return TTF_IMAGE_INVALID;
 }
 
-static AtlasDrawSequence *CreateDrawSequence(TTF_DrawOperation *ops, int num_ops, TTF_GPUTextEngineWinding winding)
+static Uint16 PackTexcoord(float value)
 {
-    AtlasDrawSequence *sequence = (AtlasDrawSequence *)SDL_calloc(1, sizeof(*sequence));
-    if (!sequence) {
-        return NULL;
+    return (Uint16)(SDL_clamp(value, 0.0f, 1.0f) * 65535.0f + 0.5f);
+}
+
+static Sint16 PackPosition(float value)
+{
+    return (Sint16)SDL_clamp(value, (float)SDL_MIN_SINT16, (float)SDL_MAX_SINT16);
+}
+
+static Uint8 PackColor(float value)
+{
+    return (Uint8)(SDL_clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+static void SetPackedColor(AtlasDrawSequence *sequence, const SDL_FColor *color)
+{
+    const Uint8 r = PackColor(color->r);
+    const Uint8 g = PackColor(color->g);
+    const Uint8 b = PackColor(color->b);
+    const Uint8 a = PackColor(color->a);
+
+    for ( ; sequence; sequence = sequence->next) {
+        TTF_PackedTextVertex *vtx = sequence->packed_vertices;
+        for (int i = 0; i < sequence->num_vertices; ++i, ++vtx) {
+            vtx->r = r;
+            vtx->g = g;
+            vtx->b = b;
+            vtx->a = a;
+        }
     }
+}
 
-    SDL_assert(num_ops > 0);
-    SDL_COMPILE_TIME_ASSERT(sizeof_SDL_FPoint, sizeof(SDL_FPoint) == 2 * sizeof(float));
+static bool CreatePackedVertices(AtlasDrawSequence *sequence, TTF_DrawOperation *ops, int count, const Uint8 *rect_index_order)
+{
+    static const float fill_texcoords[] = { 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f, 0.0f, 1.0f };
 
-    SDL_GPUTexture *texture = GetOperationTexture(&ops[0]);
-    TTF_ImageType image_type = GetOperationImageType(&ops[0]);
-    TTF_DrawOperation *end = NULL;
-    for (int i = 1; i < num_ops; ++i) {
-        if (GetOperationTexture(&ops[i]) != texture ||
-            GetOperationImageType(&ops[i]) != image_type) {
-            end = &ops[i];
-            break;
+    sequence->packed_vertices = (TTF_PackedTextVertex *)SDL_calloc(count * 4, sizeof(*sequence->packed_vertices));
+    sequence->packed_indices = (Uint16 *)SDL_malloc(count * 6 * sizeof(*sequence->packed_indices));
+    if (!sequence->packed_vertices || !sequence->packed_indices) {
+        return false;
+    }
+
+    TTF_PackedTextVertex *vtx = sequence->packed_vertices;
+    for (int i = 0; i < count; ++i) {
+        TTF_DrawOperation *op = &ops[i];
+        const SDL_Rect *dst;
+        const float *texcoords;
+        if (op->cmd == TTF_DRAW_COMMAND_COPY) {
+            dst = &op->copy.dst;
+            texcoords = ((AtlasGlyph *)op->copy.reserved)->texcoords;
+        } else {
+            dst = &op->fill.rect;
+            texcoords = fill_texcoords;
+        }
+
+        float minx = (float)dst->x;
+        float maxx = (float)(dst->x + dst->w);
+        float miny = (float)dst->y;
+        float maxy = (float)(dst->y + dst->h);
+
+        /* Ensure fill rects are at least 3px tall for shader-based edge AA,
+         * rounded outwards since packed positions are whole pixels */
+        if (op->cmd == TTF_DRAW_COMMAND_FILL && dst->h < 3) {
+            float pad = (3.0f - dst->h) / 2.0f;
+            miny = SDL_floorf(miny - pad);
+            maxy = SDL_ceilf(maxy + pad);
+        }
+
+        // In the GPU API postive y-axis is upwards so the signs of the y-coords is reversed
+        const float positions[] = { minx, -miny, maxx, -miny, maxx, -maxy, minx, -maxy };
+        for (int j = 0; j < 4; ++j, ++vtx) {
+            vtx->x = PackPosition(positions[j * 2 + 0]);
+            vtx->y = PackPosition(positions[j * 2 + 1]);
+            vtx->u = PackTexcoord(texcoords[j * 2 + 0]);
+            vtx->v = PackTexcoord(texcoords[j * 2 + 1]);
         }
     }
 
-    int count = (end ? (int)(end - ops) : num_ops);
-    sequence->atlas_texture = texture;
-    sequence->image_type = image_type;
-    sequence->num_vertices = count * 4;
-    sequence->num_indices = count * 6;
+    Uint16 vertex_index = 0;
+    Uint16 *indices = sequence->packed_indices;
+    for (int i = 0; i < count; ++i) {
+        for (int j = 0; j < 6; ++j) {
+            *indices++ = (Uint16)(vertex_index + rect_index_order[j]);
+        }
+        vertex_index += 4;
+    }
+    return true;
+}
 
+static bool CreateFloatVertices(AtlasDrawSequence *sequence, TTF_DrawOperation *ops, int count, SDL_GPUTexture *texture, const Uint8 *rect_index_order)
+{
     sequence->uv = (SDL_FPoint *)SDL_malloc(count * 4 * sizeof(*sequence->uv));
     if (!sequence->uv) {
-        DestroyDrawSequence(sequence);
-        return NULL;
+        return false;
     }
 
     float *uv = (float *)sequence->uv;
@@ -676,8 +857,7 @@ static AtlasDrawSequence *CreateDrawSequence(TTF_DrawOperation *ops, int num_ops
 
     sequence->xy = (SDL_FPoint *)SDL_malloc(count * 4 * sizeof(*sequence->xy));
     if (!sequence->xy) {
-        DestroyDrawSequence(sequence);
-        return NULL;
+        return false;
     }
     float *xy = (float *)sequence->xy;
     for (int i = 0; i < count; ++i) {
@@ -719,10 +899,102 @@ static AtlasDrawSequence *CreateDrawSequence(TTF_DrawOperation *ops, int num_ops
 
     sequence->indices = (int *)SDL_malloc(count * 12 * sizeof(*sequence->indices));
     if (!sequence->indices) {
-        DestroyDrawSequence(sequence);
+        return false;
+    }
+
+    int vertex_index = 0;
+    int *indices = sequence->indices;
+    for (int i = 0; i < count; ++i) {
+        *indices++ = vertex_index + rect_index_order[0];
+        *indices++ = vertex_index + rect_index_order[1];
+        *indices++ = vertex_index + rect_index_order[2];
+        *indices++ = vertex_index + rect_index_order[3];
+        *indices++ = vertex_index + rect_index_order[4];
+        *indices++ = vertex_index + rect_index_order[5];
+        vertex_index += 4;
+    }
+    return true;
+}
+
+static bool CreateInstances(AtlasDrawSequence *sequence, TTF_DrawOperation *ops, int count)
+{
+    sequence->instances = (TTF_TextInstance *)SDL_malloc(count * sizeof(*sequence->instances));
+    if (!sequence->instances) {
+        return false;
+    }
+    sequence->num_instances = count;
+
+    TTF_TextInstance *instance = sequence->instances;
+    for (int i = 0; i < count; ++i, ++instance) {
+        TTF_DrawOperation *op = &ops[i];
+        const SDL_Rect *dst;
+        if (op->cmd == TTF_DRAW_COMMAND_COPY) {
+            AtlasGlyph *glyph = (AtlasGlyph *)op->copy.reserved;
+            dst = &op->copy.dst;
+            instance->uv.x = glyph->texcoords[0];
+            instance->uv.y = glyph->texcoords[1];
+            instance->uv.w = glyph->texcoords[4] - glyph->texcoords[0];
+            instance->uv.h = glyph->texcoords[5] - glyph->texcoords[1];
+            instance->image_type = glyph->image_type;
+            instance->text_offset = op->copy.text_offset;
+        } else {
+            dst = &op->fill.rect;
+            instance->uv.x = 0.0f;
+            instance->uv.y = 0.0f;
+            instance->uv.w = 1.0f;
+            instance->uv.h = 1.0f;
+            instance->image_type = TTF_IMAGE_INVALID;
+            instance->text_offset = -1;
+        }
+
+        float miny = (float)dst->y;
+        float h = (float)dst->h;
+
+        /* Ensure fill rects are at least 3px tall for shader-based edge AA */
+        if (op->cmd == TTF_DRAW_COMMAND_FILL && dst->h < 3) {
+            miny -= (3.0f - dst->h) / 2.0f;
+            h = 3.0f;
+        }
+
+        // In the GPU API postive y-axis is upwards so the signs of the y-coords is reversed
+        instance->dst.x = (float)dst->x;
+        instance->dst.y = -miny;
+        instance->dst.w = (float)dst->w;
+        instance->dst.h = h;
+    }
+    return true;
+}
+
+static AtlasDrawSequence *CreateDrawSequence(TTF_DrawOperation *ops, int num_ops, TTF_GPUTextEngineWinding winding, TTF_TextVertexFormat format)
+{
+    AtlasDrawSequence *sequence = (AtlasDrawSequence *)SDL_calloc(1, sizeof(*sequence));
+    if (!sequence) {
         return NULL;
     }
 
+    SDL_assert(num_ops > 0);
+    SDL_COMPILE_TIME_ASSERT(sizeof_SDL_FPoint, sizeof(SDL_FPoint) == 2 * sizeof(float));
+
+    SDL_GPUTexture *texture = GetOperationTexture(&ops[0]);
+    TTF_ImageType image_type = GetOperationImageType(&ops[0]);
+    TTF_DrawOperation *end = NULL;
+    for (int i = 1; i < num_ops; ++i) {
+        if (GetOperationTexture(&ops[i]) != texture ||
+            GetOperationImageType(&ops[i]) != image_type) {
+            end = &ops[i];
+            break;
+        }
+    }
+
+    int count = (end ? (int)(end - ops) : num_ops);
+    if (format == TTF_TEXT_VERTEX_FORMAT_PACKED) {
+        count = SDL_min(count, MAX_PACKED_GLYPHS);
+    }
+    sequence->atlas_texture = texture;
+    sequence->image_type = image_type;
+    sequence->num_vertices = count * 4;
+    sequence->num_indices = count * 6;
+
     static const Uint8 rect_index_order_cw[] = { 0, 1, 2, 0, 2, 3 };
     static const Uint8 rect_index_order_ccw[] = { 0, 2, 1, 0, 3, 2 };
 
@@ -733,20 +1005,27 @@ static AtlasDrawSequence *CreateDrawSequence(TTF_DrawOperation *ops, int num_ops
         rect_index_order = rect_index_order_ccw;
     }
 
-    int vertex_index = 0;
-    int *indices = sequence->indices;
-    for (int i = 0; i < count; ++i) {
-        *indices++ = vertex_index + rect_index_order[0];
-        *indices++ = vertex_index + rect_index_order[1];
-        *indices++ = vertex_index + rect_index_order[2];
-        *indices++ = vertex_index + rect_index_order[3];
-        *indices++ = vertex_index + rect_index_order[4];
-        *indices++ = vertex_index + rect_index_order[5];
-        vertex_index += 4;
+    if (format == TTF_TEXT_VERTEX_FORMAT_INSTANCED) {
+        sequence->num_vertices = 0;
+        sequence->num_indices = 0;
+        if (!CreateInstances(sequence, ops, count)) {
+            DestroyDrawSequence(sequence);
+            return NULL;
+        }
+    } else if (format == TTF_TEXT_VERTEX_FORMAT_PACKED) {
+        if (!CreatePackedVertices(sequence, ops, count, rect_index_order)) {
+            DestroyDrawSequence(sequence);
+            return NULL;
+        }
+    } else {
+        if (!CreateFloatVertices(sequence, ops, count, texture, rect_index_order)) {
+            DestroyDrawSequence(sequence);
+            return NULL;
+        }
     }
 
     if (count < num_ops) {
-        sequence->next = CreateDrawSequence(ops + count, num_ops - count, winding);
+        sequence->next = CreateDrawSequence(ops + count, num_ops - count, winding, format);
         if (!sequence->next) {
             DestroyDrawSequence(sequence);
             return NULL;
@@ -770,7 +1049,7 @@ static void DestroyTextData(TTF_GPUTextEngineTextData *data)
     SDL_free(data);
 }
 
-static TTF_GPUTextEngineTextData *CreateTextData(TTF_GPUTextEngineData *enginedata, TTF_GPUTextEngineFontData *fontdata, TTF_DrawOperation *ops, int num_ops)
+static TTF_GPUTextEngineTextData *CreateTextData(TTF_GPUTextEngineData *enginedata, TTF_GPUTextEngineFontData *fontdata, TTF_DrawOperation *ops, int num_ops, const SDL_FColor *color)
 {
     TTF_GPUTextEngineTextData *data = (TTF_GPUTextEngineTextData *)SDL_calloc(1, sizeof(*data));
     if (!data) {
@@ -820,11 +1099,16 @@ static TTF_GPUTextEngineTextData *CreateTextData(TTF_GPUTextEngineData *engineda
     SDL_qsort(ops, num_ops, sizeof(*ops), SortOperations);
 
     // Create batched draw sequences
-    data->draw_sequence = CreateDrawSequence(ops, num_ops, enginedata->winding);
+    data->format = enginedata->format;
+    data->draw_sequence = CreateDrawSequence(ops, num_ops, enginedata->winding, data->format);
     if (!data->draw_sequence) {
         DestroyTextData(data);
         return NULL;
     }
+    if (data->format == TTF_TEXT_VERTEX_FORMAT_PACKED) {
+        SetPackedColor(data->draw_sequence, color);
+        SDL_copyp(&data->color, color);
+    }
 
     return data;
 }
@@ -835,6 +1119,7 @@ static void DestroyFontData(TTF_GPUTextEngineFontData *data)
         if (data->glyphs) {
             SDL_DestroyGlyphHashTable(data->glyphs);
         }
+        SDL_DestroyGlyphHashTableGenerations(&data->previous_glyphs);
         SDL_free(data);
     }
 }
@@ -900,6 +1185,7 @@ static TTF_GPUTextEngineData *CreateEngineData(SDL_GPUDevice *device, int atlas_
     data->device = device;
     data->atlas_texture_size = atlas_texture_size;
     data->winding = TTF_GPU_TEXTENGINE_WINDING_CLOCKWISE;
+    data->format = TTF_TEXT_VERTEX_FORMAT_FLOAT;
 
     data->fonts = SDL_CreateHashTable(0, false, SDL_HashPointer, SDL_KeyMatchPointer, NukeFontData, NULL);
     if (!data->fonts) {
@@ -925,8 +1211,10 @@ static bool SDLCALL CreateText(void *userdata, TTF_Text *text)
             return false;
         }
     } else if (font_generation != fontdata->generation) {
-        SDL_ClearHashTable(fontdata->glyphs);
-        fontdata->generation = font_generation;
+        // Keep the glyphs of recent generations, the font may switch back to them
+        if (!SDL_SwitchGlyphHashTable(&fontdata->previous_glyphs, &fontdata->glyphs, &fontdata->generation, font_generation, NukeGlyph)) {
+            return false;
+        }
     }
 
     // Make a sortable copy of the draw operations
@@ -935,8 +1223,9 @@ static bool SDLCALL CreateText(void *userdata, TTF_Text *text)
         return false;
     }
     SDL_memcpy(ops, text->internal->ops, num_ops * sizeof(*ops));
+    TTF_SetGlyphKeys(text->internal, ops);
 
-    data = CreateTextData(enginedata, fontdata, ops, num_ops);
+    data = CreateTextData(enginedata, fontdata, ops, num_ops, &text->internal->color);
     SDL_free(ops);
     if (!data) {
         return false;
@@ -1024,6 +1313,11 @@ AtlasDrawSequence *TTF_GetGPUTextDrawData(TTF_Text *text)
         return NULL;
     }
 
+    if (data->format == TTF_TEXT_VERTEX_FORMAT_PACKED &&
+        SDL_memcmp(&data->color, &text->internal->color, sizeof(data->color)) != 0) {
+        SetPackedColor(data->draw_sequence, &text->internal->color);
+        SDL_copyp(&data->color, &text->internal->color);
+    }
     return data->draw_sequence;
 }
 
@@ -1051,3 +1345,30 @@ TTF_GPUTextEngineWinding TTF_GetGPUTextEngineWinding(const TTF_TextEngine *engin
 
     return ((TTF_GPUTextEngineData *)engine->userdata)->winding;
 }
+
+void TTF_SetGPUTextEngineVertexFormat(TTF_TextEngine *engine, TTF_TextVertexFormat format)
+{
+    if (!engine || engine->CreateText != CreateText) {
+        SDL_InvalidParamError("engine");
+        return;
+    }
+
+    if (format != TTF_TEXT_VERTEX_FORMAT_FLOAT &&
+        format != TTF_TEXT_VERTEX_FORMAT_PACKED &&
+        format != TTF_TEXT_VERTEX_FORMAT_INSTANCED) {
+        SDL_InvalidParamError("format");
+        return;
+    }
+
+    ((TTF_GPUTextEngineData *)engine->userdata)->format = format;
+}
+
+TTF_TextVertexFormat TTF_GetGPUTextEngineVertexFormat(const TTF_TextEngine *engine)
+{
+    if (!engine || engine->CreateText != CreateText) {
+        SDL_InvalidParamError("engine");
+        return TTF_TEXT_VERTEX_FORMAT_INVALID;
+    }
+
+    return ((TTF_GPUTextEngineData *)engine->userdata)->format;
+}
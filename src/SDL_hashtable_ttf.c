@@ -77,3 +77,47 @@ void SDL_DestroyGlyphHashTable(SDL_HashTable *table)
     SDL_DestroyHashTable(table);
 }
 
+bool SDL_SwitchGlyphHashTable(SDL_GlyphHashTableGenerations *saved, SDL_HashTable **table, Uint32 *generation, Uint32 new_generation, SDL_GlyphHashTable_NukeFn nukefn)
+{
+    SDL_HashTable *new_table = NULL;
+    int i;
+
+    for (i = 0; i < SDL_GLYPH_HASHTABLE_GENERATIONS; ++i) {
+        if (saved->table[i] && saved->generation[i] == new_generation) {
+            new_table = saved->table[i];
+            break;
+        }
+    }
+    if (!new_table) {
+        new_table = SDL_CreateGlyphHashTable(nukefn);
+        if (!new_table) {
+            return false;
+        }
+
+        // Drop the least recently used table
+        i = SDL_GLYPH_HASHTABLE_GENERATIONS - 1;
+        if (saved->table[i]) {
+            SDL_DestroyGlyphHashTable(saved->table[i]);
+        }
+    }
+
+    // Save the current table as the most recently used one
+    SDL_memmove(&saved->table[1], &saved->table[0], i * sizeof(saved->table[0]));
+    SDL_memmove(&saved->generation[1], &saved->generation[0], i * sizeof(saved->generation[0]));
+    saved->table[0] = *table;
+    saved->generation[0] = *generation;
+
+    *table = new_table;
+    *generation = new_generation;
+    return true;
+}
+
+void SDL_DestroyGlyphHashTableGenerations(SDL_GlyphHashTableGenerations *saved)
+{
+    for (int i = 0; i < SDL_GLYPH_HASHTABLE_GENERATIONS; ++i) {
+        if (saved->table[i]) {
+            SDL_DestroyGlyphHashTable(saved->table[i]);
+            saved->table[i] = NULL;
+        }
+    }
+}
@@ -26,3 +26,14 @@ extern bool SDL_InsertIntoGlyphHashTable(SDL_HashTable *table, TTF_Font *font, U
 extern  bool SDL_FindInGlyphHashTable(SDL_HashTable *table, TTF_Font *font, Uint32 glyph_index, const void **value);
 extern void SDL_DestroyGlyphHashTable(SDL_HashTable *table);
 
+// Glyph tables kept for recently used font generations, most recently used first
+#define SDL_GLYPH_HASHTABLE_GENERATIONS 4
+
+typedef struct SDL_GlyphHashTableGenerations
+{
+    Uint32 generation[SDL_GLYPH_HASHTABLE_GENERATIONS];
+    SDL_HashTable *table[SDL_GLYPH_HASHTABLE_GENERATIONS];
+} SDL_GlyphHashTableGenerations;
+
+extern bool SDL_SwitchGlyphHashTable(SDL_GlyphHashTableGenerations *saved, SDL_HashTable **table, Uint32 *generation, Uint32 new_generation, SDL_GlyphHashTable_NukeFn nukefn);
+extern void SDL_DestroyGlyphHashTableGenerations(SDL_GlyphHashTableGenerations *saved);
@@ -22,6 +22,7 @@
 
 #include "SDL_hashtable.h"
 #include "SDL_hashtable_ttf.h"
+#include "SDL_ttf_internal.h"
 
 #define STB_RECT_PACK_IMPLEMENTATION
 #define STBRP_STATIC
@@ -30,6 +31,12 @@
 #define STBRP__CDECL SDLCALL
 #include "stb_rect_pack.h"
 
+// Free areas are binned by power of two size class
+#define NUM_FREE_GLYPH_BINS 16
+
+// Free areas smaller than this in either dimension aren't worth keeping
+#define MIN_FREE_GLYPH_SIZE 4
+
 typedef struct AtlasGlyph AtlasGlyph;
 typedef struct AtlasTexture AtlasTexture;
 typedef struct AtlasDrawSequence AtlasDrawSequence;
@@ -47,6 +54,7 @@ struct AtlasGlyph
     TTF_ImageType image_type;
     SDL_Rect rect;
     float texcoords[8];
+    AtlasGlyph *prev;
     AtlasGlyph *next;
 };
 
@@ -55,7 +63,9 @@ struct AtlasTexture
     SDL_Texture *texture;
     stbrp_context packer;
     stbrp_node *packing_nodes;
-    AtlasGlyph *free_glyphs;
+    AtlasGlyph *used_glyphs;
+    AtlasGlyph *free_glyphs[NUM_FREE_GLYPH_BINS];
+    Sint64 allocated_pixels;
     AtlasTexture *next;
 };
 
@@ -67,15 +77,28 @@ struct AtlasDrawSequence
     SDL_Rect *rects;
     float *texcoords;
     float *positions;
-    int *indices;
     AtlasDrawSequence *next;
 };
 
+typedef struct DrawBatch
+{
+    SDL_Texture *texture;
+    TTF_ImageType image_type;
+    int first_rect;
+    int num_rects;
+} DrawBatch;
+
 typedef struct TTF_RendererTextEngineTextData
 {
     int num_glyphs;
     AtlasGlyph **glyphs;
+    int num_ops;
+    TTF_DrawOperation *ops;
+    Uint32 atlas_generation;
     AtlasDrawSequence *draw_sequence;
+    bool has_origin;
+    float origin_x;
+    float origin_y;
 } TTF_RendererTextEngineTextData;
 
 typedef struct TTF_RendererTextEngineFontData
@@ -83,6 +106,7 @@ typedef struct TTF_RendererTextEngineFontData
     TTF_Font *font;
     Uint32 generation;
     SDL_HashTable *glyphs;
+    SDL_GlyphHashTableGenerations previous_glyphs;
 } TTF_RendererTextEngineFontData;
 
 typedef struct TTF_RendererTextEngineData
@@ -91,6 +115,21 @@ typedef struct TTF_RendererTextEngineData
     SDL_HashTable *fonts;
     AtlasTexture *atlas;
     int atlas_texture_size;
+    float compact_threshold;
+    Uint32 atlas_generation;
+
+    // Quad indices shared by all draw sequences
+    int max_quads;
+    int *quad_indices;
+
+    // Pooled geometry for drawing multiple texts at once
+    int num_batches;
+    int max_batches;
+    DrawBatch *batches;
+    int max_batch_rects;
+    float *batch_positions;
+    float *batch_texcoords;
+    SDL_FColor *batch_colors;
 } TTF_RendererTextEngineData;
 
 
@@ -178,10 +217,12 @@ static void DestroyAtlas(AtlasTexture *atlas)
         return;
     }
 
-    AtlasGlyph *next;
-    for (AtlasGlyph *glyph = atlas->free_glyphs; glyph; glyph = next) {
-        next = glyph->next;
-        DestroyGlyph(glyph);
+    for (int i = 0; i < NUM_FREE_GLYPH_BINS; ++i) {
+        AtlasGlyph *next;
+        for (AtlasGlyph *glyph = atlas->free_glyphs[i]; glyph; glyph = next) {
+            next = glyph->next;
+            DestroyGlyph(glyph);
+        }
     }
 
     SDL_DestroyTexture(atlas->texture);
@@ -189,14 +230,14 @@ static void DestroyAtlas(AtlasTexture *atlas)
     SDL_free(atlas);
 }
 
-static AtlasTexture *CreateAtlas(SDL_Renderer *renderer, int atlas_texture_size)
+static AtlasTexture *CreateAtlas(SDL_Renderer *renderer, int atlas_texture_size, SDL_TextureAccess access)
 {
     AtlasTexture *atlas = (AtlasTexture *)SDL_calloc(1, sizeof(*atlas));
     if (!atlas) {
         return NULL;
     }
 
-    atlas->texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, atlas_texture_size, atlas_texture_size);
+    atlas->texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, access, atlas_texture_size, atlas_texture_size);
     if (!atlas->texture) {
         DestroyAtlas(atlas);
         return NULL;
@@ -215,6 +256,83 @@ static AtlasTexture *CreateAtlas(SDL_Renderer *renderer, int atlas_texture_size)
     return atlas;
 }
 
+static int GetFreeGlyphBin(int width, int height)
+{
+    int size = SDL_max(width, height);
+    int bin = 0;
+    while (bin < (NUM_FREE_GLYPH_BINS - 1) && (1 << bin) < size) {
+        ++bin;
+    }
+    return bin;
+}
+
+static void AddFreeGlyph(AtlasTexture *atlas, AtlasGlyph *glyph)
+{
+    // Insert into the free list for this size class, sorted smallest first
+    AtlasGlyph **bin = &atlas->free_glyphs[GetFreeGlyphBin(glyph->rect.w, glyph->rect.h)];
+    AtlasGlyph *entry, *prev = NULL;
+    int size = (glyph->rect.w * glyph->rect.h);
+    for (entry = *bin; entry; entry = entry->next) {
+        if (size <= (entry->rect.w * entry->rect.h)) {
+            break;
+        }
+
+        prev = entry;
+    }
+
+    if (prev) {
+        prev->next = glyph;
+    } else {
+        *bin = glyph;
+    }
+    glyph->next = entry;
+}
+
+static void AddUsedGlyph(AtlasTexture *atlas, AtlasGlyph *glyph)
+{
+    glyph->atlas = atlas;
+    glyph->prev = NULL;
+    glyph->next = atlas->used_glyphs;
+    if (atlas->used_glyphs) {
+        atlas->used_glyphs->prev = glyph;
+    }
+    atlas->used_glyphs = glyph;
+}
+
+static void RemoveUsedGlyph(AtlasTexture *atlas, AtlasGlyph *glyph)
+{
+    if (glyph->prev) {
+        glyph->prev->next = glyph->next;
+    } else {
+        atlas->used_glyphs = glyph->next;
+    }
+    if (glyph->next) {
+        glyph->next->prev = glyph->prev;
+    }
+    glyph->prev = NULL;
+    glyph->next = NULL;
+}
+
+static void AddFreeArea(AtlasTexture *atlas, int x, int y, int w, int h)
+{
+    if (w < MIN_FREE_GLYPH_SIZE || h < MIN_FREE_GLYPH_SIZE) {
+        return;
+    }
+
+    AtlasGlyph *glyph = (AtlasGlyph *)SDL_calloc(1, sizeof(*glyph));
+    if (!glyph) {
+        // Not fatal, we just won't be able to reuse this area
+        return;
+    }
+
+    glyph->atlas = atlas;
+    glyph->rect.x = x;
+    glyph->rect.y = y;
+    glyph->rect.w = w;
+    glyph->rect.h = h;
+    AddFreeGlyph(atlas, glyph);
+}
+
 static void ReleaseGlyph(AtlasGlyph *glyph)
 {
     if (!glyph) {
@@ -224,47 +342,25 @@ static void ReleaseGlyph(AtlasGlyph *glyph)
     --glyph->refcount;
     if (glyph->refcount == 0) {
         if (glyph->atlas) {
-            // Insert into free list sorted smallest first
-            AtlasGlyph *entry, *prev = NULL;
-            int size = (glyph->rect.w * glyph->rect.h);
-            for (entry = glyph->atlas->free_glyphs; entry; entry = entry->next) {
-                if (size <= (entry->rect.w * entry->rect.h)) {
-                    break;
-                }
-
-                prev = entry;
-            }
-
-            if (prev) {
-                prev->next = glyph;
-            } else {
-                glyph->atlas->free_glyphs = glyph;
-            }
-            glyph->next = entry;
+            RemoveUsedGlyph(glyph->atlas, glyph);
+            AddFreeGlyph(glyph->atlas, glyph);
         } else {
             DestroyGlyph(glyph);
         }
     }
 }
 
-static AtlasGlyph *CreateGlyph(AtlasTexture *atlas, int atlas_texture_size, const stbrp_rect *area)
+static void SetGlyphArea(AtlasGlyph *glyph, int atlas_texture_size, int x, int y, int w, int h)
 {
-    AtlasGlyph *glyph = (AtlasGlyph *)SDL_calloc(1, sizeof(*glyph));
-    if (!glyph) {
-        return NULL;
-    }
-
-    glyph->refcount = 1;
-    glyph->atlas = atlas;
-    glyph->rect.x = area->x;
-    glyph->rect.y = area->y;
-    glyph->rect.w = area->w;
-    glyph->rect.h = area->h;
-
-    const float minu = (float)area->x / atlas_texture_size;
-    const float minv = (float)area->y / atlas_texture_size;
-    const float maxu = (float)(area->x + area->w) / atlas_texture_size;
-    const float maxv = (float)(area->y + area->h) / atlas_texture_size;
+    glyph->rect.x = x;
+    glyph->rect.y = y;
+    glyph->rect.w = w;
+    glyph->rect.h = h;
+
+    const float minu = (float)x / atlas_texture_size;
+    const float minv = (float)y / atlas_texture_size;
+    const float maxu = (float)(x + w) / atlas_texture_size;
+    const float maxv = (float)(y + h) / atlas_texture_size;
     glyph->texcoords[0] = minu;
     glyph->texcoords[1] = minv;
     glyph->texcoords[2] = maxu;
@@ -273,60 +369,85 @@ static AtlasGlyph *CreateGlyph(AtlasTexture *atlas, int atlas_texture_size, cons
     glyph->texcoords[5] = maxv;
     glyph->texcoords[6] = minu;
     glyph->texcoords[7] = maxv;
+}
+
+static AtlasGlyph *CreateGlyph(AtlasTexture *atlas, int atlas_texture_size, const stbrp_rect *area)
+{
+    AtlasGlyph *glyph = (AtlasGlyph *)SDL_calloc(1, sizeof(*glyph));
+    if (!glyph) {
+        return NULL;
+    }
+
+    glyph->refcount = 1;
+    AddUsedGlyph(atlas, glyph);
+    SetGlyphArea(glyph, atlas_texture_size, area->x, area->y, area->w, area->h);
+    atlas->allocated_pixels += (area->w * area->h);
 
     return glyph;
 }
 
-static AtlasGlyph *FindUnusedGlyph(AtlasTexture *atlas, int width, int height)
+static bool HasFreeGlyphs(AtlasTexture *atlas)
 {
-    AtlasGlyph *glyph, *prev = NULL;
-
-    int size = (width * height);
-    for (glyph = atlas->free_glyphs; glyph; glyph = glyph->next) {
-        if (width == glyph->rect.w && height == glyph->rect.h) {
-            if (prev) {
-                prev->next = glyph->next;
-            } else {
-                atlas->free_glyphs = glyph->next;
+    for (; atlas; atlas = atlas->next) {
+        for (int i = 0; i < NUM_FREE_GLYPH_BINS; ++i) {
+            if (atlas->free_glyphs[i]) {
+                return true;
             }
-            ++glyph->refcount;
-            return glyph;
         }
+    }
+    return false;
+}
 
-        if (size < (glyph->rect.w * glyph->rect.h)) {
-            // We didn't find any entries our size, everything else is larger than we want
-            break;
-        }
+static AtlasGlyph *FindUnusedGlyph(AtlasTexture *atlas, int atlas_texture_size, int width, int height)
+{
+    for (; atlas; atlas = atlas->next) {
+        // Areas in smaller size classes can't fit this glyph
+        for (int bin = GetFreeGlyphBin(width, height); bin < NUM_FREE_GLYPH_BINS; ++bin) {
+            AtlasGlyph *glyph, *prev = NULL;
+            for (glyph = atlas->free_glyphs[bin]; glyph; prev = glyph, glyph = glyph->next) {
+                if (width > glyph->rect.w || height > glyph->rect.h) {
+                    continue;
+                }
 
-        prev = glyph;
-    }
+                // This is the smallest area in this size class that fits
+                if (prev) {
+                    prev->next = glyph->next;
+                } else {
+                    atlas->free_glyphs[bin] = glyph->next;
+                }
+                AddUsedGlyph(atlas, glyph);
+
+                // Split off the rest of the area, leaving the larger piece in one rectangle
+                int x = glyph->rect.x;
+                int y = glyph->rect.y;
+                int w = glyph->rect.w;
+                int h = glyph->rect.h;
+                int right = (w - width);
+                int bottom = (h - height);
+                if (right < bottom) {
+                    AddFreeArea(atlas, x + width, y, right, height);
+                    AddFreeArea(atlas, x, y + height, w, bottom);
+                } else {
+                    AddFreeArea(atlas, x + width, y, right, h);
+                    AddFreeArea(atlas, x, y + height, width, bottom);
+                }
 
-    if (atlas->next) {
-        return FindUnusedGlyph(atlas->next, width, height);
+                SetGlyphArea(glyph, atlas_texture_size, x, y, width, height);
+                ++glyph->refcount;
+                return glyph;
+            }
+        }
     }
     return NULL;
 }
 
 static bool UpdateGlyph(AtlasGlyph *glyph, SDL_Surface *surface, TTF_ImageType image_type)
 {
-    SDL_Texture *texture = glyph->atlas->texture;
-    void *pixels;
-    int pitch;
-    if (!SDL_LockTexture(texture, &glyph->rect, &pixels, &pitch)) {
+    // Compacted atlases are render targets, which can't be locked
+    if (!SDL_UpdateTexture(glyph->atlas->texture, &glyph->rect, surface->pixels, surface->pitch)) {
         return false;
     }
 
-    const Uint8 *src = (const Uint8 *)surface->pixels;
-    const int src_pitch = surface->pitch;
-    Uint8 *dst = (Uint8 *)pixels;
-    const int dst_pitch = pitch;
-    for (int i = 0; i < glyph->rect.h; ++i) {
-        SDL_memcpy(dst, src, glyph->rect.w * 4);
-        src += src_pitch;
-        dst += dst_pitch;
-    }
-    SDL_UnlockTexture(texture);
-
     glyph->image_type = image_type;
     return true;
 }
@@ -339,13 +460,190 @@ static bool AddGlyphToFont(TTF_RendererTextEngineFontData *fontdata, TTF_Font *g
     return true;
 }
 
+static void GetAtlasInfo(TTF_RendererTextEngineData *enginedata, TTF_TextEngineAtlasInfo *info)
+{
+    SDL_zerop(info);
+    info->atlas_texture_size = enginedata->atlas_texture_size;
+    for (AtlasTexture *atlas = enginedata->atlas; atlas; atlas = atlas->next) {
+        ++info->num_atlases;
+        for (AtlasGlyph *glyph = atlas->used_glyphs; glyph; glyph = glyph->next) {
+            ++info->num_glyphs;
+            info->used_pixels += (glyph->rect.w * glyph->rect.h);
+        }
+        info->allocated_pixels += atlas->allocated_pixels;
+    }
+
+    Sint64 total_pixels = (Sint64)info->num_atlases * info->atlas_texture_size * info->atlas_texture_size;
+    if (total_pixels > 0) {
+        info->occupancy = (float)((double)info->used_pixels / total_pixels);
+    }
+    if (info->allocated_pixels > 0) {
+        info->fragmentation = (float)((double)(info->allocated_pixels - info->used_pixels) / info->allocated_pixels);
+    }
+}
+
+static bool CompactAtlases(TTF_RendererTextEngineData *enginedata)
+{
+    SDL_Renderer *renderer = enginedata->renderer;
+    int atlas_texture_size = enginedata->atlas_texture_size;
+    SDL_Texture *target = SDL_GetRenderTarget(renderer);
+    bool changed_target = false;
+    AtlasGlyph **glyphs = NULL;
+    AtlasTexture **destinations = NULL;
+    stbrp_rect *areas = NULL;
+    AtlasTexture *atlases = NULL;
+    AtlasTexture **tail = &atlases;
+    float r, g, b, a;
+    bool result = false;
+
+    int num_glyphs = 0;
+    for (AtlasTexture *atlas = enginedata->atlas; atlas; atlas = atlas->next) {
+        for (AtlasGlyph *glyph = atlas->used_glyphs; glyph; glyph = glyph->next) {
+            ++num_glyphs;
+        }
+    }
+
+    if (num_glyphs > 0) {
+        glyphs = (AtlasGlyph **)SDL_malloc(num_glyphs * sizeof(*glyphs));
+        destinations = (AtlasTexture **)SDL_calloc(num_glyphs, sizeof(*destinations));
+        areas = (stbrp_rect *)SDL_calloc(num_glyphs, sizeof(*areas));
+        if (!glyphs || !destinations || !areas) {
+            goto done;
+        }
+    }
+
+    int index = 0;
+    for (AtlasTexture *atlas = enginedata->atlas; atlas; atlas = atlas->next) {
+        // The glyphs are copied as-is into the new atlases
+        SDL_SetTextureBlendMode(atlas->texture, SDL_BLENDMODE_NONE);
+
+        for (AtlasGlyph *glyph = atlas->used_glyphs; glyph; glyph = glyph->next) {
+            glyphs[index] = glyph;
+            areas[index].id = index;
+            areas[index].w = glyph->rect.w;
+            areas[index].h = glyph->rect.h;
+            ++index;
+        }
+    }
+
+    SDL_GetRenderDrawColorFloat(renderer, &r, &g, &b, &a);
+
+    stbrp_rect *remaining = areas;
+    int num_remaining = num_glyphs;
+    while (num_remaining > 0) {
+        AtlasTexture *atlas = CreateAtlas(renderer, atlas_texture_size, SDL_TEXTUREACCESS_TARGET);
+        if (!atlas) {
+            goto done;
+        }
+        *tail = atlas;
+        tail = &atlas->next;
+
+        if (!SDL_SetRenderTarget(renderer, atlas->texture)) {
+            goto done;
+        }
+        changed_target = true;
+
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+        SDL_RenderClear(renderer);
+
+        stbrp_pack_rects(&atlas->packer, remaining, num_remaining);
+
+        // Copy the packed glyphs and move them to the front, leaving the rest for the next atlas
+        int num_packed = 0;
+        for (int i = 0; i < num_remaining; ++i) {
+            if (!remaining[i].was_packed) {
+                continue;
+            }
+
+            AtlasGlyph *glyph = glyphs[remaining[i].id];
+            SDL_FRect src, dst;
+            SDL_RectToFRect(&glyph->rect, &src);
+            dst.x = (float)remaining[i].x;
+            dst.y = (float)remaining[i].y;
+            dst.w = (float)remaining[i].w;
+            dst.h = (float)remaining[i].h;
+            if (!SDL_RenderTexture(renderer, glyph->atlas->texture, &src, &dst)) {
+                goto done;
+            }
+            destinations[remaining[i].id] = atlas;
+
+            if (i != num_packed) {
+                stbrp_rect area = remaining[num_packed];
+                remaining[num_packed] = remaining[i];
+                remaining[i] = area;
+            }
+            ++num_packed;
+        }
+        if (num_packed == 0) {
+            SDL_SetError("Couldn't pack glyphs into a new atlas");
+            goto done;
+        }
+        remaining += num_packed;
+        num_remaining -= num_packed;
+    }
+
+    // Everything was copied, move the glyphs into their new atlases
+    for (int i = 0; i < num_glyphs; ++i) {
+        const stbrp_rect *area = &areas[i];
+        AtlasTexture *atlas = destinations[area->id];
+        AtlasGlyph *glyph = glyphs[area->id];
+        AddUsedGlyph(atlas, glyph);
+        SetGlyphArea(glyph, atlas_texture_size, area->x, area->y, area->w, area->h);
+        atlas->allocated_pixels += (area->w * area->h);
+    }
+
+    AtlasTexture *next;
+    for (AtlasTexture *atlas = enginedata->atlas; atlas; atlas = next) {
+        next = atlas->next;
+        DestroyAtlas(atlas);
+    }
+    enginedata->atlas = atlases;
+    atlases = NULL;
+
+    // Text will rebuild its draw sequences the next time it's drawn
+    ++enginedata->atlas_generation;
+
+    result = true;
+
+done:
+    if (changed_target) {
+        SDL_SetRenderTarget(renderer, target);
+        SDL_SetRenderDrawColorFloat(renderer, r, g, b, a);
+    }
+    if (!result) {
+        for (AtlasTexture *atlas = enginedata->atlas; atlas; atlas = atlas->next) {
+            SDL_SetTextureBlendMode(atlas->texture, SDL_BLENDMODE_BLEND);
+        }
+    }
+    while (atlases) {
+        AtlasTexture *atlas = atlases;
+        atlases = atlas->next;
+        DestroyAtlas(atlas);
+    }
+    SDL_free(areas);
+    SDL_free(destinations);
+    SDL_free(glyphs);
+    return result;
+}
+
+static bool ShouldCompactAtlases(TTF_RendererTextEngineData *enginedata)
+{
+    if (enginedata->compact_threshold <= 0.0f) {
+        return false;
+    }
+
+    TTF_TextEngineAtlasInfo info;
+    GetAtlasInfo(enginedata, &info);
+    return (info.fragmentation >= enginedata->compact_threshold);
+}
+
 static bool ResolveMissingGlyphs(TTF_RendererTextEngineData *enginedata, AtlasTexture *atlas, TTF_RendererTextEngineFontData *fontdata, GlyphSurface *surfaces, TTF_DrawOperation *ops, int num_ops, stbrp_rect *missing, int num_missing)
 {
     // See if we can reuse any existing entries
-    if (atlas->free_glyphs) {
+    if (HasFreeGlyphs(atlas)) {
         // Search from the smallest to the largest to minimize time spent searching the free list and shortening the missing entries
         for (int i = num_missing; i--; ) {
-            AtlasGlyph *glyph = FindUnusedGlyph(atlas, missing[i].w, missing[i].h);
+            AtlasGlyph *glyph = FindUnusedGlyph(atlas, enginedata->atlas_texture_size, missing[i].w, missing[i].h);
             if (!glyph) {
                 continue;
             }
@@ -417,8 +715,19 @@ static bool ResolveMissingGlyphs(TTF_RendererTextEngineData *enginedata, AtlasTe
         }
     }
 
+    if (!atlas->next && ShouldCompactAtlases(enginedata) && CompactAtlases(enginedata)) {
+        // Try again with the compacted atlases
+        if (!enginedata->atlas) {
+            enginedata->atlas = CreateAtlas(enginedata->renderer, enginedata->atlas_texture_size, SDL_TEXTUREACCESS_STREAMING);
+            if (!enginedata->atlas) {
+                return false;
+            }
+        }
+        return ResolveMissingGlyphs(enginedata, enginedata->atlas, fontdata, surfaces, ops, num_ops, missing, num_missing);
+    }
+
     if (!atlas->next) {
-        atlas->next = CreateAtlas(enginedata->renderer, enginedata->atlas_texture_size);
+        atlas->next = CreateAtlas(enginedata->renderer, enginedata->atlas_texture_size, SDL_TEXTUREACCESS_STREAMING);
         if (!atlas->next) {
             return false;
         }
@@ -464,7 +773,7 @@ static bool CreateMissingGlyphs(TTF_RendererTextEngineData *enginedata, TTF_Rend
             }
 
             TTF_ImageType image_type = TTF_IMAGE_INVALID;
-            SDL_Surface *surface = TTF_GetGlyphImageForIndex(glyph_font, glyph_index, &image_type);
+            SDL_Surface *surface = TTF_GetGlyphImageForKey(glyph_font, glyph_index, &image_type);
             if (!surface) {
                 goto done;
             }
@@ -491,7 +800,7 @@ static bool CreateMissingGlyphs(TTF_RendererTextEngineData *enginedata, TTF_Rend
 
     // Create the texture atlas if necessary
     if (!enginedata->atlas) {
-        enginedata->atlas = CreateAtlas(enginedata->renderer, atlas_texture_size);
+        enginedata->atlas = CreateAtlas(enginedata->renderer, atlas_texture_size, SDL_TEXTUREACCESS_STREAMING);
         if (!enginedata->atlas) {
             goto done;
         }
@@ -538,7 +847,6 @@ static void DestroyDrawSequence(AtlasDrawSequence *data)
     SDL_free(data->rects);
     SDL_free(data->texcoords);
     SDL_free(data->positions);
-    SDL_free(data->indices);
     SDL_free(data);
 }
 
@@ -627,25 +935,6 @@ static AtlasDrawSequence *CreateDrawSequence(TTF_DrawOperation *ops, int num_ops
         return NULL;
     }
 
-    sequence->indices = (int *)SDL_malloc(count * 12 * sizeof(*sequence->indices));
-    if (!sequence->indices) {
-        DestroyDrawSequence(sequence);
-        return NULL;
-    }
-
-    static const Uint8 rect_index_order[] = { 0, 1, 2, 0, 2, 3 };
-    int vertex_index = 0;
-    int *indices = sequence->indices;
-    for (int i = 0; i < count; ++i) {
-        *indices++ = vertex_index + rect_index_order[0];
-        *indices++ = vertex_index + rect_index_order[1];
-        *indices++ = vertex_index + rect_index_order[2];
-        *indices++ = vertex_index + rect_index_order[3];
-        *indices++ = vertex_index + rect_index_order[4];
-        *indices++ = vertex_index + rect_index_order[5];
-        vertex_index += 4;
-    }
-
     if (count < num_ops) {
         sequence->next = CreateDrawSequence(ops + count, num_ops - count);
         if (!sequence->next) {
@@ -668,16 +957,82 @@ static void DestroyTextData(TTF_RendererTextEngineTextData *data)
         ReleaseGlyph(data->glyphs[i]);
     }
     SDL_free(data->glyphs);
+    SDL_free(data->ops);
     SDL_free(data);
 }
 
-static TTF_RendererTextEngineTextData *CreateTextData(TTF_RendererTextEngineData *enginedata, TTF_RendererTextEngineFontData *fontdata, TTF_DrawOperation *ops, int num_ops)
+static bool ReserveQuadIndices(TTF_RendererTextEngineData *enginedata, int num_quads)
+{
+    if (num_quads <= enginedata->max_quads) {
+        return true;
+    }
+
+    int max_quads = SDL_max(num_quads, 2 * enginedata->max_quads);
+    int *quad_indices = (int *)SDL_realloc(enginedata->quad_indices, max_quads * 6 * sizeof(*quad_indices));
+    if (!quad_indices) {
+        return false;
+    }
+
+    static const Uint8 rect_index_order[] = { 0, 1, 2, 0, 2, 3 };
+    int *indices = &quad_indices[enginedata->max_quads * 6];
+    for (int i = enginedata->max_quads; i < max_quads; ++i) {
+        int vertex_index = i * 4;
+        *indices++ = vertex_index + rect_index_order[0];
+        *indices++ = vertex_index + rect_index_order[1];
+        *indices++ = vertex_index + rect_index_order[2];
+        *indices++ = vertex_index + rect_index_order[3];
+        *indices++ = vertex_index + rect_index_order[4];
+        *indices++ = vertex_index + rect_index_order[5];
+    }
+    enginedata->quad_indices = quad_indices;
+    enginedata->max_quads = max_quads;
+    return true;
+}
+
+static bool UpdateDrawSequence(TTF_RendererTextEngineData *enginedata, TTF_RendererTextEngineTextData *data)
+{
+    // Sort the operations to batch by texture
+    SDL_qsort(data->ops, data->num_ops, sizeof(*data->ops), SortOperations);
+
+    // Create batched draw sequences
+    AtlasDrawSequence *sequence = CreateDrawSequence(data->ops, data->num_ops);
+    if (!sequence) {
+        return false;
+    }
+
+    for (AtlasDrawSequence *seq = sequence; seq; seq = seq->next) {
+        if (!ReserveQuadIndices(enginedata, seq->num_rects)) {
+            DestroyDrawSequence(sequence);
+            return false;
+        }
+    }
+
+    DestroyDrawSequence(data->draw_sequence);
+    data->draw_sequence = sequence;
+    data->atlas_generation = enginedata->atlas_generation;
+    data->has_origin = false;
+    return true;
+}
+
+static TTF_RendererTextEngineTextData *CreateTextData(TTF_RendererTextEngineData *enginedata, TTF_RendererTextEngineFontData *fontdata, const TTF_TextData *text)
 {
+    int num_ops = text->num_ops;
     TTF_RendererTextEngineTextData *data = (TTF_RendererTextEngineTextData *)SDL_calloc(1, sizeof(*data));
     if (!data) {
         return NULL;
     }
 
+    // Make a sortable copy of the draw operations, kept so they can be rebuilt after atlas compaction
+    TTF_DrawOperation *ops = (TTF_DrawOperation *)SDL_malloc(num_ops * sizeof(*ops));
+    if (!ops) {
+        DestroyTextData(data);
+        return NULL;
+    }
+    SDL_memcpy(ops, text->ops, num_ops * sizeof(*ops));
+    TTF_SetGlyphKeys(text, ops);
+    data->ops = ops;
+    data->num_ops = num_ops;
+
     // First, match draw operations to existing glyphs
     int num_glyphs = 0;
     int num_missing = 0;
@@ -717,12 +1072,7 @@ static TTF_RendererTextEngineTextData *CreateTextData(TTF_RendererTextEngineData
         data->glyphs[data->num_glyphs++] = glyph;
     }
 
-    // Sort the operations to batch by texture
-    SDL_qsort(ops, num_ops, sizeof(*ops), SortOperations);
-
-    // Create batched draw sequences
-    data->draw_sequence = CreateDrawSequence(ops, num_ops);
-    if (!data->draw_sequence) {
+    if (!UpdateDrawSequence(enginedata, data)) {
         DestroyTextData(data);
         return NULL;
     }
@@ -736,6 +1086,7 @@ static void DestroyFontData(TTF_RendererTextEngineFontData *data)
         if (data->glyphs) {
             SDL_DestroyGlyphHashTable(data->glyphs);
         }
+        SDL_DestroyGlyphHashTableGenerations(&data->previous_glyphs);
         SDL_free(data);
     }
 }
@@ -783,6 +1134,12 @@ static void DestroyEngineData(TTF_RendererTextEngineData *data)
         next = atlas->next;
         DestroyAtlas(atlas);
     }
+
+    SDL_free(data->batches);
+    SDL_free(data->batch_positions);
+    SDL_free(data->batch_texcoords);
+    SDL_free(data->batch_colors);
+    SDL_free(data->quad_indices);
     SDL_free(data);
 }
 
@@ -792,7 +1149,7 @@ static void SDLCALL NukeFontData(void *userdata, const void *key, const void *va
     DestroyFontData(data);
 }
 
-static TTF_RendererTextEngineData *CreateEngineData(SDL_Renderer *renderer, int atlas_texture_size)
+static TTF_RendererTextEngineData *CreateEngineData(SDL_Renderer *renderer, int atlas_texture_size, float compact_threshold)
 {
     TTF_RendererTextEngineData *data = (TTF_RendererTextEngineData *)SDL_calloc(1, sizeof(*data));
     if (!data) {
@@ -800,6 +1157,7 @@ static TTF_RendererTextEngineData *CreateEngineData(SDL_Renderer *renderer, int
     }
     data->renderer = renderer;
     data->atlas_texture_size = atlas_texture_size;
+    data->compact_threshold = compact_threshold;
 
     data->fonts = SDL_CreateHashTable(0, false, SDL_HashPointer, SDL_KeyMatchPointer, NukeFontData, NULL);
     if (!data->fonts) {
@@ -813,8 +1171,6 @@ static bool SDLCALL CreateText(void *userdata, TTF_Text *text)
 {
     TTF_Font *font = text->internal->font;
     Uint32 font_generation = TTF_GetFontGeneration(font);
-    int num_ops = text->internal->num_ops;
-    TTF_DrawOperation *ops;
     TTF_RendererTextEngineData *enginedata = (TTF_RendererTextEngineData *)userdata;
     TTF_RendererTextEngineFontData *fontdata;
     TTF_RendererTextEngineTextData *data;
@@ -825,19 +1181,13 @@ static bool SDLCALL CreateText(void *userdata, TTF_Text *text)
             return false;
         }
     } else if (font_generation != fontdata->generation) {
-        SDL_ClearHashTable(fontdata->glyphs);
-        fontdata->generation = font_generation;
-    }
-
-    // Make a sortable copy of the draw operations
-    ops = (TTF_DrawOperation *)SDL_malloc(num_ops * sizeof(*ops));
-    if (!ops) {
-        return false;
+        // Keep the glyphs of recent generations, the font may switch back to them
+        if (!SDL_SwitchGlyphHashTable(&fontdata->previous_glyphs, &fontdata->glyphs, &fontdata->generation, font_generation, NukeGlyph)) {
+            return false;
+        }
     }
-    SDL_memcpy(ops, text->internal->ops, num_ops * sizeof(*ops));
 
-    data = CreateTextData(enginedata, fontdata, ops, num_ops);
-    SDL_free(ops);
+    data = CreateTextData(enginedata, fontdata, text->internal);
     if (!data) {
         return false;
     }
@@ -888,10 +1238,12 @@ TTF_TextEngine *TTF_CreateRendererTextEngineWithProperties(SDL_PropertiesID prop
         return NULL;
     }
 
+    float compact_threshold = SDL_GetFloatProperty(props, TTF_PROP_RENDERER_TEXT_ENGINE_COMPACT_THRESHOLD_FLOAT, 0.0f);
+
     SDL_INIT_INTERFACE(engine);
     engine->CreateText = CreateText;
     engine->DestroyText = DestroyText;
-    engine->userdata = CreateEngineData(renderer, atlas_texture_size);
+    engine->userdata = CreateEngineData(renderer, atlas_texture_size, compact_threshold);
     if (!engine->userdata) {
         TTF_DestroyRendererTextEngine(engine);
         return NULL;
@@ -899,6 +1251,19 @@ TTF_TextEngine *TTF_CreateRendererTextEngineWithProperties(SDL_PropertiesID prop
     return engine;
 }
 
+static void GetSequenceColor(TTF_Text *text, TTF_ImageType image_type, SDL_FColor *color)
+{
+    if (image_type == TTF_IMAGE_ALPHA) {
+        SDL_copyp(color, &text->internal->color);
+    } else {
+        // Don't alter the color data in the image
+        color->r = 1.0f;
+        color->g = 1.0f;
+        color->b = 1.0f;
+        color->a = text->internal->color.a;
+    }
+}
+
 bool TTF_DrawRendererText(TTF_Text *text, float x, float y)
 {
     if (!text || !text->internal || text->internal->engine->CreateText != CreateText) {
@@ -916,11 +1281,27 @@ bool TTF_DrawRendererText(TTF_Text *text, float x, float y)
         return true;
     }
 
-    SDL_Renderer *renderer = ((TTF_RendererTextEngineData *)text->internal->engine->userdata)->renderer;
+    TTF_RendererTextEngineData *enginedata = (TTF_RendererTextEngineData *)text->internal->engine->userdata;
+    if (data->atlas_generation != enginedata->atlas_generation) {
+        // The atlases have been compacted since this text was created
+        if (!UpdateDrawSequence(enginedata, data)) {
+            return false;
+        }
+    }
+
+    // Only regenerate the vertex positions if the text has moved
+    bool update_positions = (!data->has_origin || x != data->origin_x || y != data->origin_y);
+    if (update_positions) {
+        data->has_origin = true;
+        data->origin_x = x;
+        data->origin_y = y;
+    }
+
+    SDL_Renderer *renderer = enginedata->renderer;
     AtlasDrawSequence *sequence = data->draw_sequence;
     while (sequence) {
         float *position = sequence->positions;
-        for (int i = 0; i < sequence->num_rects; ++i) {
+        for (int i = 0; update_positions && i < sequence->num_rects; ++i) {
             const SDL_Rect *dst = &sequence->rects[i];
             float minx = x + dst->x;
             float maxx = x + dst->x + dst->w;
@@ -938,15 +1319,7 @@ bool TTF_DrawRendererText(TTF_Text *text, float x, float y)
         }
 
         SDL_FColor color;
-        if (sequence->image_type == TTF_IMAGE_ALPHA) {
-            SDL_copyp(&color, &text->internal->color);
-        } else {
-            // Don't alter the color data in the image
-            color.r = 1.0f;
-            color.g = 1.0f;
-            color.b = 1.0f;
-            color.a = text->internal->color.a;
-        }
+        GetSequenceColor(text, sequence->image_type, &color);
 
         SDL_RenderGeometryRaw(renderer,
                               sequence->texture,
@@ -954,13 +1327,234 @@ bool TTF_DrawRendererText(TTF_Text *text, float x, float y)
                               &color, 0,
                               sequence->texcoords, 2 * sizeof(float),
                               sequence->num_rects * 4,
-                              sequence->indices, sequence->num_rects * 6, sizeof(*sequence->indices));
+                              enginedata->quad_indices, sequence->num_rects * 6, sizeof(*enginedata->quad_indices));
 
         sequence = sequence->next;
     }
     return true;
 }
 
+static DrawBatch *GetDrawBatch(TTF_RendererTextEngineData *enginedata, SDL_Texture *texture, TTF_ImageType image_type)
+{
+    for (int i = 0; i < enginedata->num_batches; ++i) {
+        DrawBatch *batch = &enginedata->batches[i];
+        if (batch->texture == texture && batch->image_type == image_type) {
+            return batch;
+        }
+    }
+
+    if (enginedata->num_batches == enginedata->max_batches) {
+        int max_batches = SDL_max(2 * enginedata->max_batches, 8);
+        DrawBatch *batches = (DrawBatch *)SDL_realloc(enginedata->batches, max_batches * sizeof(*batches));
+        if (!batches) {
+            return NULL;
+        }
+        enginedata->batches = batches;
+        enginedata->max_batches = max_batches;
+    }
+
+    DrawBatch *batch = &enginedata->batches[enginedata->num_batches++];
+    batch->texture = texture;
+    batch->image_type = image_type;
+    batch->first_rect = 0;
+    batch->num_rects = 0;
+    return batch;
+}
+
+static bool ReserveBatchRects(TTF_RendererTextEngineData *enginedata, int num_rects)
+{
+    if (num_rects <= enginedata->max_batch_rects) {
+        return true;
+    }
+
+    int max_rects = SDL_max(num_rects, 2 * enginedata->max_batch_rects);
+    float *positions = (float *)SDL_realloc(enginedata->batch_positions, max_rects * 8 * sizeof(*positions));
+    if (!positions) {
+        return false;
+    }
+    enginedata->batch_positions = positions;
+
+    float *texcoords = (float *)SDL_realloc(enginedata->batch_texcoords, max_rects * 8 * sizeof(*texcoords));
+    if (!texcoords) {
+        return false;
+    }
+    enginedata->batch_texcoords = texcoords;
+
+    SDL_FColor *colors = (SDL_FColor *)SDL_realloc(enginedata->batch_colors, max_rects * 4 * sizeof(*colors));
+    if (!colors) {
+        return false;
+    }
+    enginedata->batch_colors = colors;
+
+    // Every batch starts at vertex 0, so they can all use the shared quad indices
+    if (!ReserveQuadIndices(enginedata, max_rects)) {
+        return false;
+    }
+    enginedata->max_batch_rects = max_rects;
+
+    return true;
+}
+
+bool TTF_DrawRendererTexts(TTF_Text **texts, const SDL_FPoint *positions, int count)
+{
+    if (count < 0 || (count > 0 && (!texts || !positions))) {
+        return SDL_InvalidParamError("texts");
+    }
+    if (count == 0) {
+        return true;
+    }
+
+    TTF_TextEngine *engine = NULL;
+    for (int i = 0; i < count; ++i) {
+        TTF_Text *text = texts[i];
+        if (!text || !text->internal || text->internal->engine->CreateText != CreateText) {
+            return SDL_InvalidParamError("texts");
+        }
+        if (!engine) {
+            engine = text->internal->engine;
+        } else if (text->internal->engine != engine) {
+            return SDL_SetError("All texts must be created with the same text engine");
+        }
+    }
+
+    TTF_RendererTextEngineData *enginedata = (TTF_RendererTextEngineData *)engine->userdata;
+
+    // Make sure the texts are up to date, this may compact the atlases
+    for (int i = 0; i < count; ++i) {
+        if (!TTF_UpdateText(texts[i])) {
+            return false;
+        }
+    }
+
+    // Rebuild the draw sequences of texts created before the atlases were last compacted
+    for (int i = 0; i < count; ++i) {
+        TTF_RendererTextEngineTextData *data = (TTF_RendererTextEngineTextData *)texts[i]->internal->engine_text;
+        if (data && data->atlas_generation != enginedata->atlas_generation) {
+            if (!UpdateDrawSequence(enginedata, data)) {
+                return false;
+            }
+        }
+    }
+
+    // Count the rects in each batch
+    int total_rects = 0;
+    enginedata->num_batches = 0;
+    for (int i = 0; i < count; ++i) {
+        TTF_RendererTextEngineTextData *data = (TTF_RendererTextEngineTextData *)texts[i]->internal->engine_text;
+        if (!data) {
+            // Empty string, nothing to do
+            continue;
+        }
+
+        for (AtlasDrawSequence *sequence = data->draw_sequence; sequence; sequence = sequence->next) {
+            DrawBatch *batch = GetDrawBatch(enginedata, sequence->texture, sequence->image_type);
+            if (!batch) {
+                return false;
+            }
+            batch->num_rects += sequence->num_rects;
+            total_rects += sequence->num_rects;
+        }
+    }
+
+    if (!ReserveBatchRects(enginedata, total_rects)) {
+        return false;
+    }
+
+    int first_rect = 0;
+    for (int i = 0; i < enginedata->num_batches; ++i) {
+        DrawBatch *batch = &enginedata->batches[i];
+        batch->first_rect = first_rect;
+        first_rect += batch->num_rects;
+        batch->num_rects = 0;
+    }
+
+    // Fill in the geometry for each batch
+    for (int i = 0; i < count; ++i) {
+        TTF_Text *text = texts[i];
+        TTF_RendererTextEngineTextData *data = (TTF_RendererTextEngineTextData *)text->internal->engine_text;
+        if (!data) {
+            continue;
+        }
+
+        float x = positions[i].x;
+        float y = positions[i].y;
+        for (AtlasDrawSequence *sequence = data->draw_sequence; sequence; sequence = sequence->next) {
+            DrawBatch *batch = GetDrawBatch(enginedata, sequence->texture, sequence->image_type);
+            int rect_index = batch->first_rect + batch->num_rects;
+            float *position = &enginedata->batch_positions[rect_index * 8];
+            SDL_FColor *color = &enginedata->batch_colors[rect_index * 4];
+
+            SDL_FColor sequence_color;
+            GetSequenceColor(text, sequence->image_type, &sequence_color);
+
+            for (int j = 0; j < sequence->num_rects; ++j) {
+                const SDL_Rect *dst = &sequence->rects[j];
+                float minx = x + dst->x;
+                float maxx = x + dst->x + dst->w;
+                float miny = y + dst->y;
+                float maxy = y + dst->y + dst->h;
+
+                *position++ = minx;
+                *position++ = miny;
+                *position++ = maxx;
+                *position++ = miny;
+                *position++ = maxx;
+                *position++ = maxy;
+                *position++ = minx;
+                *position++ = maxy;
+
+                *color++ = sequence_color;
+                *color++ = sequence_color;
+                *color++ = sequence_color;
+                *color++ = sequence_color;
+            }
+
+            if (sequence->texcoords) {
+                SDL_memcpy(&enginedata->batch_texcoords[rect_index * 8], sequence->texcoords, sequence->num_rects * 8 * sizeof(*sequence->texcoords));
+            }
+            batch->num_rects += sequence->num_rects;
+        }
+    }
+
+    for (int i = 0; i < enginedata->num_batches; ++i) {
+        const DrawBatch *batch = &enginedata->batches[i];
+        if (batch->num_rects == 0) {
+            continue;
+        }
+
+        SDL_RenderGeometryRaw(enginedata->renderer,
+                              batch->texture,
+                              &enginedata->batch_positions[batch->first_rect * 8], 2 * sizeof(float),
+                              &enginedata->batch_colors[batch->first_rect * 4], sizeof(SDL_FColor),
+                              batch->texture ? &enginedata->batch_texcoords[batch->first_rect * 8] : NULL, 2 * sizeof(float),
+                              batch->num_rects * 4,
+                              enginedata->quad_indices, batch->num_rects * 6, sizeof(*enginedata->quad_indices));
+    }
+    return true;
+}
+
+bool TTF_GetRendererTextEngineAtlasInfo(TTF_TextEngine *engine, TTF_TextEngineAtlasInfo *info)
+{
+    if (!engine || engine->CreateText != CreateText) {
+        return SDL_InvalidParamError("engine");
+    }
+    if (!info) {
+        return SDL_InvalidParamError("info");
+    }
+
+    GetAtlasInfo((TTF_RendererTextEngineData *)engine->userdata, info);
+    return true;
+}
+
+bool TTF_CompactRendererTextEngine(TTF_TextEngine *engine)
+{
+    if (!engine || engine->CreateText != CreateText) {
+        return SDL_InvalidParamError("engine");
+    }
+
+    return CompactAtlases((TTF_RendererTextEngineData *)engine->userdata);
+}
+
 void TTF_DestroyRendererTextEngine(TTF_TextEngine *engine)
 {
     if (!engine || engine->CreateText != CreateText) {
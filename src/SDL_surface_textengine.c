@@ -22,14 +22,29 @@
 
 #include "SDL_hashtable.h"
 #include "SDL_hashtable_ttf.h"
+#include "SDL_ttf_internal.h"
 
+#if defined(__SSE2__)
+#  define HAVE_SSE2_INTRINSICS 1
+#include <emmintrin.h>
+#endif
+
+#if defined(__ARM_NEON) && (SDL_BYTEORDER == SDL_LIL_ENDIAN)
+#  define HAVE_NEON_INTRINSICS 1
+#include <arm_neon.h>
+#endif
+
+#define DIVIDE_BY_255(x)    (((x) + 1 + ((x) >> 8)) >> 8)
+
+typedef void (*BlendAlphaRowFunc)(const Uint8 *src, Uint32 *dst, int width, Uint32 color, Uint8 fg_alpha);
+typedef void (*BlendColorRowFunc)(const Uint8 *src, Uint32 *dst, int width, Uint8 fg_alpha);
 
 typedef struct TTF_SurfaceTextEngineGlyphData
 {
     int refcount;
     SDL_Color color;
-    SDL_Surface *surface;
-    TTF_ImageType image_type;
+    TTF_GlyphImage *image;
+    SDL_Surface *surface;   // Only created if the glyph needs to be blitted
 } TTF_SurfaceTextEngineGlyphData;
 
 typedef struct TTF_SurfaceTextEngineTextData
@@ -38,6 +53,7 @@ typedef struct TTF_SurfaceTextEngineTextData
     SDL_Color color;
     TTF_DrawOperation *ops;
     int num_ops;
+    SDL_Rect bounds;
 } TTF_SurfaceTextEngineTextData;
 
 typedef struct TTF_SurfaceTextEngineFontData
@@ -45,6 +61,7 @@ typedef struct TTF_SurfaceTextEngineFontData
     TTF_Font *font;
     Uint32 generation;
     SDL_HashTable *glyphs;
+    SDL_GlyphHashTableGenerations previous_glyphs;
 } TTF_SurfaceTextEngineFontData;
 
 typedef struct TTF_SurfaceTextEngineData
@@ -64,11 +81,12 @@ static void DestroyGlyphData(TTF_SurfaceTextEngineGlyphData *data)
         if (data->surface) {
             SDL_DestroySurface(data->surface);
         }
+        TTF_ReleaseGlyphImage(data->image);
         SDL_free(data);
     }
 }
 
-static TTF_SurfaceTextEngineGlyphData *CreateGlyphData(SDL_Surface *surface, TTF_ImageType image_type)
+static TTF_SurfaceTextEngineGlyphData *CreateGlyphData(TTF_GlyphImage *image)
 {
     TTF_SurfaceTextEngineGlyphData *data = (TTF_SurfaceTextEngineGlyphData *)SDL_malloc(sizeof(*data));
     if (data) {
@@ -77,25 +95,57 @@ static TTF_SurfaceTextEngineGlyphData *CreateGlyphData(SDL_Surface *surface, TTF
         data->color.g = 0xFF;
         data->color.b = 0xFF;
         data->color.a = 0xFF;
-        data->surface = surface;
-        data->image_type = image_type;
+        data->image = image;
+        data->surface = NULL;
     }
     return data;
 }
 
+static SDL_Surface *GetGlyphSurface(TTF_SurfaceTextEngineGlyphData *glyph)
+{
+    if (glyph->surface) {
+        return glyph->surface;
+    }
+
+    const TTF_GlyphImage *image = glyph->image;
+    if (image->is_color) {
+        // The image is already in the right format
+        glyph->surface = SDL_CreateSurfaceFrom(image->width, image->rows, SDL_PIXELFORMAT_ARGB8888, (void *)image->pixels, image->pitch);
+        return glyph->surface;
+    }
+
+    glyph->surface = SDL_CreateSurface(image->width, image->rows, SDL_PIXELFORMAT_ARGB8888);
+    if (!glyph->surface) {
+        return NULL;
+    }
+
+    const Uint8 *src = image->pixels;
+    Uint8 *dst = (Uint8 *)glyph->surface->pixels;
+    for (int row = 0; row < image->rows; ++row) {
+        Uint32 *pixels = (Uint32 *)dst;
+        for (int col = 0; col < image->width; ++col) {
+            pixels[col] = (0x00FFFFFF | (Uint32)src[col] << 24);
+        }
+        src += image->pitch;
+        dst += glyph->surface->pitch;
+    }
+    return glyph->surface;
+}
+
 static TTF_SurfaceTextEngineGlyphData *GetGlyphData(TTF_SurfaceTextEngineFontData *fontdata, TTF_Font *glyph_font, Uint32 glyph_index)
 {
     TTF_SurfaceTextEngineGlyphData *data;
 
     if (!SDL_FindInGlyphHashTable(fontdata->glyphs, glyph_font, glyph_index, (const void **)&data)) {
-        TTF_ImageType image_type = TTF_IMAGE_INVALID;
-        SDL_Surface *surface = TTF_GetGlyphImageForIndex(glyph_font, glyph_index, &image_type);
-        if (!surface) {
+        // Draw straight from the font's glyph cache
+        TTF_GlyphImage *image = TTF_AcquireGlyphImage(glyph_font, glyph_index);
+        if (!image) {
             return NULL;
         }
 
-        data = CreateGlyphData(surface, image_type);
+        data = CreateGlyphData(image);
         if (!data) {
+            TTF_ReleaseGlyphImage(image);
             return NULL;
         }
 
@@ -126,8 +176,9 @@ static void DestroyTextData(TTF_SurfaceTextEngineTextData *data)
     SDL_free(data);
 }
 
-static TTF_SurfaceTextEngineTextData *CreateTextData(TTF_SurfaceTextEngineFontData *fontdata, const TTF_DrawOperation *ops, int num_ops)
+static TTF_SurfaceTextEngineTextData *CreateTextData(TTF_SurfaceTextEngineFontData *fontdata, const TTF_TextData *text)
 {
+    int num_ops = text->num_ops;
     TTF_SurfaceTextEngineTextData *data = (TTF_SurfaceTextEngineTextData *)SDL_calloc(1, sizeof(*data));
     if (!data) {
         return NULL;
@@ -138,12 +189,16 @@ static TTF_SurfaceTextEngineTextData *CreateTextData(TTF_SurfaceTextEngineFontDa
         DestroyTextData(data);
         return NULL;
     }
-    SDL_memcpy(data->ops, ops, num_ops * sizeof(*data->ops));
+    SDL_memcpy(data->ops, text->ops, num_ops * sizeof(*data->ops));
     data->num_ops = num_ops;
+    TTF_SetGlyphKeys(text, data->ops);
 
     for (int i = 0; i < data->num_ops; ++i) {
         TTF_DrawOperation *op = &data->ops[i];
-        if (op->cmd == TTF_DRAW_COMMAND_COPY) {
+        const SDL_Rect *rect = NULL;
+        if (op->cmd == TTF_DRAW_COMMAND_FILL) {
+            rect = &op->fill.rect;
+        } else if (op->cmd == TTF_DRAW_COMMAND_COPY) {
             TTF_SurfaceTextEngineGlyphData *glyph = GetGlyphData(fontdata, op->copy.glyph_font, op->copy.glyph_index);
             if (!glyph) {
                 DestroyTextData(data);
@@ -151,6 +206,15 @@ static TTF_SurfaceTextEngineTextData *CreateTextData(TTF_SurfaceTextEngineFontDa
             }
             ++glyph->refcount;
             op->copy.reserved = glyph;
+            rect = &op->copy.dst;
+        }
+
+        if (rect) {
+            if (SDL_RectEmpty(&data->bounds)) {
+                SDL_copyp(&data->bounds, rect);
+            } else {
+                SDL_GetRectUnion(&data->bounds, rect, &data->bounds);
+            }
         }
     }
     return data;
@@ -165,6 +229,7 @@ static void DestroyFontData(TTF_SurfaceTextEngineFontData *data)
     if (data->glyphs) {
         SDL_DestroyGlyphHashTable(data->glyphs);
     }
+    SDL_DestroyGlyphHashTableGenerations(&data->previous_glyphs);
     SDL_free(data);
 }
 
@@ -234,8 +299,6 @@ static bool SDLCALL CreateText(void *userdata, TTF_Text *text)
 {
     TTF_Font *font = text->internal->font;
     Uint32 font_generation = TTF_GetFontGeneration(font);
-    int num_ops = text->internal->num_ops;
-    const TTF_DrawOperation *ops = text->internal->ops;
     TTF_SurfaceTextEngineData *enginedata = (TTF_SurfaceTextEngineData *)userdata;
     TTF_SurfaceTextEngineFontData *fontdata;
     TTF_SurfaceTextEngineTextData *data;
@@ -246,11 +309,13 @@ static bool SDLCALL CreateText(void *userdata, TTF_Text *text)
             return false;
         }
     } else if (font_generation != fontdata->generation) {
-        SDL_ClearHashTable(fontdata->glyphs);
-        fontdata->generation = font_generation;
+        // Keep the glyphs of recent generations, the font may switch back to them
+        if (!SDL_SwitchGlyphHashTable(&fontdata->previous_glyphs, &fontdata->glyphs, &fontdata->generation, font_generation, NukeGlyphData)) {
+            return false;
+        }
     }
 
-    data = CreateTextData(fontdata, ops, num_ops);
+    data = CreateTextData(fontdata, text->internal);
     if (!data) {
         return false;
     }
@@ -306,17 +371,25 @@ static void DrawFill(TTF_SurfaceTextEngineTextData *data, const TTF_FillOperatio
 static void DrawCopy(TTF_SurfaceTextEngineTextData *data, const TTF_CopyOperation *op, int x, int y, SDL_Surface *surface)
 {
     TTF_SurfaceTextEngineGlyphData *glyph = (TTF_SurfaceTextEngineGlyphData *)op->reserved;
+    if (glyph->image->width == 0 || glyph->image->rows == 0) {
+        return;
+    }
+
+    SDL_Surface *glyph_surface = GetGlyphSurface(glyph);
+    if (!glyph_surface) {
+        return;
+    }
 
     if (data->color.r != glyph->color.r ||
         data->color.g != glyph->color.g ||
         data->color.b != glyph->color.b ||
         data->color.a != glyph->color.a) {
-        if (glyph->image_type == TTF_IMAGE_ALPHA) {
-            SDL_SetSurfaceColorMod(glyph->surface, data->color.r, data->color.g, data->color.b);
+        if (glyph->image->image_type == TTF_IMAGE_ALPHA) {
+            SDL_SetSurfaceColorMod(glyph_surface, data->color.r, data->color.g, data->color.b);
         } else {
             // Don't alter the color data in the image
         }
-        SDL_SetSurfaceAlphaMod(glyph->surface, data->color.a);
+        SDL_SetSurfaceAlphaMod(glyph_surface, data->color.a);
         SDL_copyp(&glyph->color, &data->color);
     }
 
@@ -324,7 +397,292 @@ static void DrawCopy(TTF_SurfaceTextEngineTextData *data, const TTF_CopyOperatio
     SDL_copyp(&dst, &op->dst);
     dst.x += x;
     dst.y += y;
-    SDL_BlitSurface(glyph->surface, &op->src, surface, &dst);
+    if (op->src.w != op->dst.w || op->src.h != op->dst.h) {
+        // SDF glyphs rendered at a reference size are scaled to the font size
+        SDL_BlitSurfaceScaled(glyph_surface, &op->src, surface, &dst, SDL_SCALEMODE_LINEAR);
+    } else {
+        SDL_BlitSurface(glyph_surface, &op->src, surface, &dst);
+    }
+}
+
+// Blend a color over the destination, treating it as opaque since the source alpha is applied through sa
+static SDL_INLINE Uint32 BlendPixel(Uint32 s, Uint32 d, Uint32 sa)
+{
+    Uint32 inv = 255 - sa;
+    Uint32 a = 255 * sa + (d >> 24) * inv;
+    Uint32 r = ((s >> 16) & 0xFF) * sa + ((d >> 16) & 0xFF) * inv;
+    Uint32 g = ((s >> 8) & 0xFF) * sa + ((d >> 8) & 0xFF) * inv;
+    Uint32 b = (s & 0xFF) * sa + (d & 0xFF) * inv;
+    return (DIVIDE_BY_255(a) << 24) | (DIVIDE_BY_255(r) << 16) | (DIVIDE_BY_255(g) << 8) | DIVIDE_BY_255(b);
+}
+
+// Blend a row of 8-bit coverage in the text color
+static void BlendAlphaRow(const Uint8 *src, Uint32 *dst, int width, Uint32 color, Uint8 fg_alpha)
+{
+    for (int i = 0; i < width; ++i) {
+        Uint32 sa = src[i] * fg_alpha;
+        sa = DIVIDE_BY_255(sa);
+        if (sa) {
+            dst[i] = BlendPixel(color, dst[i], sa);
+        }
+    }
+}
+
+// Blend a row of ARGB8888 color pixels
+static void BlendColorRow(const Uint8 *src, Uint32 *dst, int width, Uint8 fg_alpha)
+{
+    for (int i = 0; i < width; ++i) {
+        Uint32 s;
+        // prevent misaligned load: s = *src++;
+        SDL_memcpy(&s, src, sizeof(s));
+        src += sizeof(Uint32);
+
+        Uint32 sa = (s >> 24) * fg_alpha;
+        sa = DIVIDE_BY_255(sa);
+        if (sa) {
+            dst[i] = BlendPixel(s, dst[i], sa);
+        }
+    }
+}
+
+#if defined(HAVE_SSE2_INTRINSICS)
+// Divide by 255 is done as:    (x + 1 + (x >> 8)) >> 8
+static SDL_INLINE __m128i Divide255_SSE(__m128i x)
+{
+    return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(x, _mm_set1_epi16(1)), _mm_srli_epi16(x, 8)), 8);
+}
+
+// Blend 4 ARGB pixels, sa has the source alpha in each 32-bit lane
+static SDL_INLINE __m128i Blend4_SSE(__m128i s, __m128i d, __m128i sa)
+{
+    const __m128i rgb    = _mm_setr_epi16(-1, -1, -1, 0, -1, -1, -1, 0);
+    const __m128i opaque = _mm_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255);
+    const __m128i full   = _mm_set1_epi16(255);
+    const __m128i zero   = _mm_setzero_si128();
+    __m128i sL, sH, dL, dH, saL, saH, L, H;
+
+    sa  = _mm_packs_epi32(sa, sa);              // a0 a1 a2 a3 a0 a1 a2 a3
+    sa  = _mm_unpacklo_epi16(sa, sa);           // a0 a0 a1 a1 a2 a2 a3 a3
+    saL = _mm_unpacklo_epi32(sa, sa);           // a0 a0 a0 a0 a1 a1 a1 a1
+    saH = _mm_unpackhi_epi32(sa, sa);           // a2 a2 a2 a2 a3 a3 a3 a3
+
+    dL  = _mm_unpacklo_epi8(d, zero);           // 16 bits per channel
+    dH  = _mm_unpackhi_epi8(d, zero);
+
+    // The source alpha is applied through the blend factor, so treat the color as opaque
+    sL  = _mm_or_si128(_mm_and_si128(_mm_unpacklo_epi8(s, zero), rgb), opaque);
+    sH  = _mm_or_si128(_mm_and_si128(_mm_unpackhi_epi8(s, zero), rgb), opaque);
+
+    // x := s * a + d * (255 - a)
+    L   = _mm_add_epi16(_mm_mullo_epi16(sL, saL), _mm_mullo_epi16(dL, _mm_sub_epi16(full, saL)));
+    H   = _mm_add_epi16(_mm_mullo_epi16(sH, saH), _mm_mullo_epi16(dH, _mm_sub_epi16(full, saH)));
+
+    return _mm_packus_epi16(Divide255_SSE(L), Divide255_SSE(H));
+}
+
+static void BlendAlphaRow_SSE(const Uint8 *src, Uint32 *dst, int width, Uint32 color, Uint8 fg_alpha)
+{
+    const __m128i alpha = _mm_set1_epi32(fg_alpha);
+    const __m128i s     = _mm_set1_epi32((int)color);
+    const __m128i zero  = _mm_setzero_si128();
+    __m128i sa, d;
+    Uint32 coverage;
+
+    int i = 0;
+    for (; (i + 4) <= width; i += 4) {
+        // Read 4 Uint8 at once and spread them into 32-bit lanes
+        SDL_memcpy(&coverage, src + i, sizeof(coverage));
+        if (!coverage) {
+            continue;
+        }
+        sa = _mm_cvtsi32_si128((int)coverage);
+        sa = _mm_unpacklo_epi16(_mm_unpacklo_epi8(sa, zero), zero);
+        sa = Divide255_SSE(_mm_mullo_epi16(sa, alpha));
+
+        d  = _mm_loadu_si128((const __m128i *)(dst + i));
+        _mm_storeu_si128((__m128i *)(dst + i), Blend4_SSE(s, d, sa));
+    }
+
+    if (i < width) {
+        BlendAlphaRow(src + i, dst + i, width - i, color, fg_alpha);
+    }
+}
+
+static void BlendColorRow_SSE(const Uint8 *src, Uint32 *dst, int width, Uint8 fg_alpha)
+{
+    const __m128i alpha = _mm_set1_epi32(fg_alpha);
+    const __m128i zero  = _mm_setzero_si128();
+    __m128i s, sa, d;
+
+    int i = 0;
+    for (; (i + 4) <= width; i += 4) {
+        // Read 4 pixels at once
+        s  = _mm_loadu_si128((const __m128i *)(src + i * 4));
+        sa = Divide255_SSE(_mm_mullo_epi16(_mm_srli_epi32(s, 24), alpha));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(sa, zero)) == 0xFFFF) {
+            // Fully transparent, nothing to do
+            continue;
+        }
+
+        d  = _mm_loadu_si128((const __m128i *)(dst + i));
+        _mm_storeu_si128((__m128i *)(dst + i), Blend4_SSE(s, d, sa));
+    }
+
+    if (i < width) {
+        BlendColorRow(src + i * 4, dst + i, width - i, fg_alpha);
+    }
+}
+#endif
+
+#if defined(HAVE_NEON_INTRINSICS)
+// Divide by 255 is done as:    (x + 1 + (x >> 8)) >> 8
+static SDL_INLINE uint8x8_t Divide255_NEON(uint16x8_t x)
+{
+    return vshrn_n_u16(vaddq_u16(vaddq_u16(x, vdupq_n_u16(1)), vshrq_n_u16(x, 8)), 8);
+}
+
+// Blend 8 pixels split into B, G, R and A, with the color treated as opaque
+static SDL_INLINE uint8x8x4_t Blend8_NEON(uint8x8x4_t s, uint8x8x4_t d, uint8x8_t sa)
+{
+    const uint8x8_t full = vdup_n_u8(255);
+    uint8x8_t inv = vsub_u8(full, sa);
+    uint8x8x4_t r;
+
+    // x := s * a + d * (255 - a)
+    r.val[0] = Divide255_NEON(vmlal_u8(vmull_u8(s.val[0], sa), d.val[0], inv));
+    r.val[1] = Divide255_NEON(vmlal_u8(vmull_u8(s.val[1], sa), d.val[1], inv));
+    r.val[2] = Divide255_NEON(vmlal_u8(vmull_u8(s.val[2], sa), d.val[2], inv));
+    r.val[3] = Divide255_NEON(vmlal_u8(vmull_u8(full, sa), d.val[3], inv));
+    return r;
+}
+
+static void BlendAlphaRow_NEON(const Uint8 *src, Uint32 *dst, int width, Uint32 color, Uint8 fg_alpha)
+{
+    const uint8x8_t alpha = vdup_n_u8(fg_alpha);
+    uint8x8x4_t s, d;
+
+    s.val[0] = vdup_n_u8((Uint8)(color >> 0));
+    s.val[1] = vdup_n_u8((Uint8)(color >> 8));
+    s.val[2] = vdup_n_u8((Uint8)(color >> 16));
+    s.val[3] = vdup_n_u8(0xFF);
+
+    int i = 0;
+    for (; (i + 8) <= width; i += 8) {
+        // Read 8 Uint8 at once
+        uint8x8_t sa = Divide255_NEON(vmull_u8(vld1_u8(src + i), alpha));
+        d = vld4_u8((const Uint8 *)(dst + i));
+        vst4_u8((Uint8 *)(dst + i), Blend8_NEON(s, d, sa));
+    }
+
+    if (i < width) {
+        BlendAlphaRow(src + i, dst + i, width - i, color, fg_alpha);
+    }
+}
+
+static void BlendColorRow_NEON(const Uint8 *src, Uint32 *dst, int width, Uint8 fg_alpha)
+{
+    const uint8x8_t alpha = vdup_n_u8(fg_alpha);
+    uint8x8x4_t s, d;
+
+    int i = 0;
+    for (; (i + 8) <= width; i += 8) {
+        // Read 8 pixels at once, split into B, G, R and A
+        s = vld4_u8(src + i * 4);
+        d = vld4_u8((const Uint8 *)(dst + i));
+        uint8x8_t sa = Divide255_NEON(vmull_u8(s.val[3], alpha));
+        vst4_u8((Uint8 *)(dst + i), Blend8_NEON(s, d, sa));
+    }
+
+    if (i < width) {
+        BlendColorRow(src + i * 4, dst + i, width - i, fg_alpha);
+    }
+}
+#endif
+
+static void GetBlendRowFuncs(BlendAlphaRowFunc *alpha_row, BlendColorRowFunc *color_row)
+{
+#if defined(HAVE_NEON_INTRINSICS)
+    if (SDL_HasNEON()) {
+        *alpha_row = BlendAlphaRow_NEON;
+        *color_row = BlendColorRow_NEON;
+        return;
+    }
+#endif
+#if defined(HAVE_SSE2_INTRINSICS)
+    if (SDL_HasSSE2()) {
+        *alpha_row = BlendAlphaRow_SSE;
+        *color_row = BlendColorRow_SSE;
+        return;
+    }
+#endif
+    *alpha_row = BlendAlphaRow;
+    *color_row = BlendColorRow;
+}
+
+static bool CanDrawDirect(SDL_Surface *surface)
+{
+    if (SDL_MUSTLOCK(surface)) {
+        return false;
+    }
+
+    switch (surface->format) {
+    case SDL_PIXELFORMAT_ARGB8888:
+    case SDL_PIXELFORMAT_XRGB8888:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Distance field glyphs need to be blitted so they're scaled and kept as-is
+static bool CanBlendGlyph(const TTF_CopyOperation *op)
+{
+    TTF_ImageType image_type = ((TTF_SurfaceTextEngineGlyphData *)op->reserved)->image->image_type;
+    return (image_type == TTF_IMAGE_ALPHA || image_type == TTF_IMAGE_COLOR);
+}
+
+static void DrawCopyDirect(TTF_SurfaceTextEngineTextData *data, const TTF_CopyOperation *op, int x, int y, SDL_Surface *surface, const SDL_Rect *clip, BlendAlphaRowFunc alpha_row, BlendColorRowFunc color_row)
+{
+    TTF_SurfaceTextEngineGlyphData *glyph = (TTF_SurfaceTextEngineGlyphData *)op->reserved;
+    const TTF_GlyphImage *image = glyph->image;
+    if (!image->pixels) {
+        return;
+    }
+
+    SDL_Rect src, dst;
+    SDL_copyp(&src, &op->src);
+    dst.x = x + op->dst.x;
+    dst.y = y + op->dst.y;
+    dst.w = src.w;
+    dst.h = src.h;
+    if (clip) {
+        SDL_Rect visible;
+        if (!SDL_GetRectIntersection(&dst, clip, &visible)) {
+            return;
+        }
+        src.x += (visible.x - dst.x);
+        src.y += (visible.y - dst.y);
+        SDL_copyp(&dst, &visible);
+    }
+
+    Uint8 *dst_row = (Uint8 *)surface->pixels + dst.y * surface->pitch + dst.x * 4;
+    if (!image->is_color) {
+        const Uint8 *src_row = image->pixels + src.y * image->pitch + src.x;
+        const Uint32 color = ((Uint32)data->color.r << 16) | ((Uint32)data->color.g << 8) | data->color.b;
+        for (int row = 0; row < dst.h; ++row) {
+            alpha_row(src_row, (Uint32 *)dst_row, dst.w, color, data->color.a);
+            src_row += image->pitch;
+            dst_row += surface->pitch;
+        }
+    } else {
+        // Don't alter the color data in the image
+        const Uint8 *src_row = image->pixels + src.y * image->pitch + src.x * 4;
+        for (int row = 0; row < dst.h; ++row) {
+            color_row(src_row, (Uint32 *)dst_row, dst.w, data->color.a);
+            src_row += image->pitch;
+            dst_row += surface->pitch;
+        }
+    }
 }
 
 bool TTF_DrawSurfaceText(TTF_Text *text, int x, int y, SDL_Surface *surface)
@@ -354,6 +712,25 @@ bool TTF_DrawSurfaceText(TTF_Text *text, int x, int y, SDL_Surface *surface)
         UpdateColor(data, &text->internal->color);
     }
 
+    // Clip once for the whole text, glyphs only need clipping if the text is partially visible
+    SDL_Rect bounds, clip, visible;
+    SDL_copyp(&bounds, &data->bounds);
+    bounds.x += x;
+    bounds.y += y;
+    SDL_GetSurfaceClipRect(surface, &clip);
+    if (!SDL_GetRectIntersection(&bounds, &clip, &visible)) {
+        return true;
+    }
+    const SDL_Rect *glyph_clip = (SDL_RectsEqual(&visible, &bounds) ? NULL : &clip);
+
+    // Blend glyphs straight into 32-bit surfaces, instead of a full blit per glyph
+    bool direct = CanDrawDirect(surface);
+    BlendAlphaRowFunc alpha_row = NULL;
+    BlendColorRowFunc color_row = NULL;
+    if (direct) {
+        GetBlendRowFuncs(&alpha_row, &color_row);
+    }
+
     for (int i = 0; i < data->num_ops; ++i) {
         const TTF_DrawOperation *op = &data->ops[i];
         switch (op->cmd) {
@@ -361,7 +738,11 @@ bool TTF_DrawSurfaceText(TTF_Text *text, int x, int y, SDL_Surface *surface)
             DrawFill(data, &op->fill, x, y, surface);
             break;
         case TTF_DRAW_COMMAND_COPY:
-            DrawCopy(data, &op->copy, x, y, surface);
+            if (direct && CanBlendGlyph(&op->copy)) {
+                DrawCopyDirect(data, &op->copy, x, y, surface, glyph_clip, alpha_row, color_row);
+            } else {
+                DrawCopy(data, &op->copy, x, y, surface);
+            }
             break;
         default:
             break;
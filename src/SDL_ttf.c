@@ -24,6 +24,7 @@
 #include <SDL3_ttf/SDL_textengine.h>
 
 #include "SDL_hashtable.h"
+#include "SDL_ttf_internal.h"
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
@@ -33,6 +34,7 @@
 #include FT_TRUETYPE_IDS_H
 #include FT_TRUETYPE_TABLES_H
 #include FT_IMAGE_H
+#include FT_SIZES_H
 
 // Enable Signed Distance Field rendering (requires latest FreeType version)
 #if defined(FT_RASTER_FLAG_SDF)
@@ -46,6 +48,13 @@
 #endif
 #define DEFAULT_SDF_SPREAD 8
 
+// Memory used by the glyphs of inactive font configurations, per font
+#define DEFAULT_CACHE_BUDGET (4 * 1024 * 1024)
+
+// The range of SDF spread supported by FreeType
+#define MIN_SDF_SPREAD 2
+#define MAX_SDF_SPREAD 32
+
 /* Enable HarfBuzz for Complex text rendering
  * Freetype may need to be compiled with FT_CONFIG_OPTION_USE_HARFBUZZ */
 #ifndef TTF_USE_HARFBUZZ
@@ -196,6 +205,21 @@ static SDL_INLINE int hasNEON(void)
 #define CACHED_LCD      0x08
 #define CACHED_SUBPIX   0x10
 
+// Subpixel positions are quantized to this many bins per pixel, each cached separately
+#define SUBPIXEL_BINS       4
+#define SUBPIXEL_STEP       (64 / SUBPIXEL_BINS)
+#define SUBPIXEL_ROUND(X)   (((X) + SUBPIXEL_STEP / 2) & ~(SUBPIXEL_STEP - 1))
+
+// Glyph keys used by the text engines have the subpixel bin in the high bits
+#define GLYPH_KEY_BIN_SHIFT 24
+#define GLYPH_KEY_INDEX(K)  ((K) & ((1u << GLYPH_KEY_BIN_SHIFT) - 1))
+#define GLYPH_KEY_BIN(K)    ((K) >> GLYPH_KEY_BIN_SHIFT)
+
+// Links of the decompressed glyph images, most recently used first
+typedef struct TTF_ImageLink {
+    struct TTF_ImageLink *prev;
+    struct TTF_ImageLink *next;
+} TTF_ImageLink;
 
 typedef struct {
     unsigned char *buffer; // aligned
@@ -205,14 +229,30 @@ typedef struct {
     int            rows;
     int            pitch;
     int            is_color;
+    TTF_GlyphImage *handle; // Shared with text engines
+
+    // Run-length encoded pixels, 'buffer' is only set while the image is in the font's hot set
+    Uint8         *compressed;
+    size_t         compressed_size;
+    TTF_Font      *hot_font;
+    TTF_ImageLink  hot;
 } TTF_Image;
 
+#define TTF_HOT_IMAGE(link) ((TTF_Image *)((Uint8 *)(link) - offsetof(TTF_Image, hot)))
+
+// Glyph image rendered at a subpixel offset
+typedef struct cached_subpixel_glyph {
+    int stored;
+    TTF_Image pixmap;
+} c_subpixel_glyph;
+
 // Cached glyph information
 typedef struct cached_glyph {
     int stored;
     FT_UInt index;
     TTF_Image bitmap;
     TTF_Image pixmap;
+    c_subpixel_glyph *subpixel_bins;    // Bins 1 to SUBPIXEL_BINS-1, bin 0 is 'pixmap'
     int sz_left;
     int sz_top;
     int sz_width;
@@ -222,7 +262,6 @@ typedef struct cached_glyph {
         // TTF_HINTING_LIGHT_SUBPIXEL (only pixmap)
         struct {
             int lsb_minus_rsb;
-            int translation;
         } subpixel;
         // Other hinting
         struct {
@@ -232,6 +271,13 @@ typedef struct cached_glyph {
     };
 } c_glyph;
 
+// Glyph rendered as SDF at the reference size, shared across point sizes
+typedef struct cached_sdf_glyph {
+    int left;   // Unscaled offset of the glyph from the pen position, without spread
+    int top;
+    TTF_Image image;
+} c_sdf_glyph;
+
 /* Internal buffer to store positions computed by TTF_Size_Internal()
  * for rendered string by Render_Line() */
 typedef struct GlyphPosition {
@@ -264,12 +310,130 @@ typedef struct CachedGlyphPositions {
     GlyphPositions positions;
 } CachedGlyphPositions;
 
+// The settings that change how glyphs are rasterized
+typedef struct GlyphCacheConfig {
+    float ptsize;
+    int hdpi;
+    int vdpi;
+    int style;
+    int outline;
+    int ft_load_target;
+    int render_subpixel;
+    bool render_sdf;
+    bool render_msdf;
+    int sdf_spread;
+    int bitmap_strike;
+    float bitmap_scale;
+} GlyphCacheConfig;
+
+// Glyphs and positions kept for a configuration that isn't currently active
+typedef struct GlyphCache {
+    GlyphCacheConfig config;
+    SDL_HashTable *glyphs;
+    SDL_HashTable *sdf_glyphs;
+    Uint32 generation;
+    Uint32 image_generation;
+    int next_cached_positions;
+    CachedGlyphPositions cached_positions[8];
+    SDL_HashTable *word_runs;
+    int num_word_runs;
+    size_t size;
+    struct GlyphCache *next;
+} GlyphCache;
+
+/* A shaped run of text, a word and its trailing spaces, used as both key
+ * and value in the font word cache. The glyph offsets are relative to the
+ * start of the run.
+ */
+typedef struct CachedWordRun {
+    TTF_Direction direction;
+    Uint32 script;
+    const char *text;
+    size_t length;
+    GlyphPositions positions;
+} CachedWordRun;
+
+// A place where a line may be broken, just after a delimiter in the text
+typedef struct TTF_BreakOpportunity {
+    int offset;
+    bool newline;   // The delimiter is a newline, the only kind used without a wrap width
+    bool hard;      // The line must be broken here
+} TTF_BreakOpportunity;
+
+/* Text shaped one paragraph at a time, kept so it can be rewrapped without
+ * shaping it again. Glyph offsets are relative to the start of the text and
+ * x positions continue from one paragraph to the next.
+ */
+typedef struct TTF_ShapedText {
+    TTF_Font *font;
+    Uint32 generation;
+    TTF_Direction direction;
+    Uint32 script;
+    bool rewrappable;
+    GlyphPositions positions;
+    TTF_BreakOpportunity *breaks;
+    int num_breaks;
+} TTF_ShapedText;
+
+typedef struct
+{
+    const char *text;
+    size_t length;
+    bool measured;  // The size below is set, for lines outside of a text viewport
+    int width;
+    int xstart;
+    int ystart;
+} TTF_Line;
+
+typedef struct TTF_SharedLayout TTF_SharedLayout;
+
+struct TTF_TextLayout
+{
+    TTF_Direction direction;
+    Uint32 script; // ISO 15924 script tag
+    int font_height;
+    int wrap_length;
+    bool wrap_whitespace_visible;
+    int *lines;
+    bool needs_reshape;
+    TTF_ShapedText shaped;
+    int incremental_glyphs;     // Glyphs rasterized per update, or 0 to rasterize all of them at once
+    int num_ready_glyphs;       // Glyph operations given to the text engine, with an incremental update
+    bool resolved;              // The text engine has all the glyphs of the text
+    TTF_Line *wrapped_lines;    // The line index, kept until the text or the wrapping changes
+    int num_wrapped_lines;
+    int wrapped_w;
+    int wrapped_h;
+    bool has_wrapped_lines;
+    bool has_viewport;
+    SDL_Rect viewport;
+    int first_line;             // The lines with drawing operations, when there is a viewport
+    int last_line;
+    bool needs_viewport_update;
+    size_t text_length;         // The length of the text, in bytes
+    size_t text_capacity;       // The size of the text allocation, including the null terminator
+    TTF_SharedLayout *shared;   // The layout results, if they are shared with other text objects
+};
+
+// Runs longer than this aren't likely to repeat, so they aren't cached
+#define TTF_WORD_CACHE_MAX_RUN_LENGTH   64
+
+// The word cache is cleared when it reaches this many runs
+#define TTF_WORD_CACHE_MAX_RUNS         4096
+
 // A structure maintaining a list of fonts
 typedef struct TTF_FontList {
     TTF_Font *font;
     struct TTF_FontList *next;
 } TTF_FontList;
 
+// A fallback font opened from a font registry entry
+typedef struct TTF_RegistryFont {
+    int entry;
+    TTF_Font *font;     // NULL if the font couldn't be opened
+    struct TTF_RegistryFont *next;
+} TTF_RegistryFont;
+
 // The structure used to hold internal font information
 struct TTF_Font {
     // The name of the font
@@ -285,6 +449,9 @@ struct TTF_Font {
     // The current font generation, changes when glyphs need to be rebuilt
     Uint32 generation;
 
+    // The generation of glyph images, which are kept across size changes with reference SDF
+    Uint32 image_generation;
+
     // Text objects using this font
     SDL_HashTable *text;
 
@@ -313,6 +480,11 @@ struct TTF_Font {
     // Extra width in glyph bounds for text styles
     int glyph_overhang;
 
+    // Whether bitmap strikes are resampled to the point size, the selected strike and the scale from it
+    bool scale_bitmaps;
+    int bitmap_strike;
+    float bitmap_scale;
+
     // Information in the font for underlining
     int line_thickness;
     int underline_top_row;
@@ -322,6 +494,15 @@ struct TTF_Font {
     SDL_HashTable *glyphs;
     SDL_HashTable *glyph_indices;
 
+    // Glyphs of other sizes and rasterization configurations, most recently used first
+    GlyphCache *glyph_caches;
+    size_t cache_budget;
+
+    // Decompressed glyph images, if glyph images are stored compressed
+    int max_hot_images;
+    int num_hot_images;
+    TTF_ImageLink hot_images;
+
     // We are responsible for closing the font stream
     SDL_IOStream *src;
     Sint64 src_offset;
@@ -334,6 +515,14 @@ struct TTF_Font {
     CachedGlyphPositions cached_positions[8];
     GlyphPositions *positions;
 
+    // Cache of shaped word runs, used to assemble lines of text
+    bool enable_word_cache;
+    SDL_HashTable *word_runs;
+    int num_word_runs;
+
+    // Layouts shared by text objects with the same content
+    SDL_HashTable *shared_layouts;
+
     // Hinting modes
     int ft_load_target;
     int render_subpixel;
@@ -344,6 +533,13 @@ struct TTF_Font {
     Uint32 script; // ISO 15924 script tag
     TTF_Direction direction;
     bool render_sdf;
+    bool render_msdf;
+    int sdf_spread;
+
+    // SDF glyphs rendered at a fixed pixel size, if sdf_reference_size is set
+    int sdf_reference_size;
+    FT_Size sdf_size;
+    SDL_HashTable *sdf_glyphs;
 
     // Extra layout setting for wrapped text
     TTF_HorizontalAlignment horizontal_align;
@@ -351,13 +547,11 @@ struct TTF_Font {
     // Fallback fonts
     TTF_FontList *fallbacks;
     TTF_FontList *fallback_for;
-};
 
-typedef struct
-{
-    const char *text;
-    size_t length;
-} TTF_Line;
+    // Fallback fonts found in a font registry, opened as they're needed
+    TTF_FontRegistry *registry;
+    TTF_RegistryFont *registry_fonts;
+};
 
 // Tell if SDL_ttf has to handle the style
 #define TTF_HANDLE_STYLE_BOLD(font)          ((font)->style & TTF_STYLE_BOLD)
@@ -376,6 +570,7 @@ static struct
     SDL_AtomicInt generation;
     SDL_Mutex *lock;
     FT_Library library;
+    int sdf_spread;
 } TTF_state;
 
 #define TTF_CHECK_INITIALIZED(errval)                   \
@@ -415,6 +610,28 @@ static Uint32 TTF_GetNextFontGeneration(void)
 }
 
 static bool Find_GlyphByIndex(TTF_Font *font, FT_UInt idx, int want_bitmap, int want_pixmap, int want_color, int want_lcd, int want_subpixel, int translation, c_glyph **out_glyph, TTF_Image **out_image);
+static bool Find_SDFGlyph(TTF_Font *font, FT_UInt idx, c_sdf_glyph **out_glyph);
+static bool Get_SDFScale(TTF_Font *font, float *scale_x, float *scale_y);
+
+// Whether SDF glyphs are rendered once at the reference size and scaled to the font size
+static bool UseReferenceSDF(const TTF_Font *font)
+{
+    return (font->render_sdf && font->sdf_reference_size > 0 && font->outline == 0 && FT_IS_SCALABLE(font->face));
+}
+
+static void SetSDFSpread(int spread)
+{
+#if TTF_USE_SDF
+    // The spread is a property of the renderer, shared by all fonts
+    if (spread != TTF_state.sdf_spread) {
+        FT_Property_Set(TTF_state.library, "bsdf", "spread", &spread);
+        FT_Property_Set(TTF_state.library, "sdf", "spread", &spread);
+        TTF_state.sdf_spread = spread;
+    }
+#else
+    (void)spread;
+#endif
+}
 
 #if defined(USE_DUFFS_LOOP)
 
@@ -1186,7 +1403,7 @@ static bool Render_Line_##NAME(TTF_Font *font, SDL_Surface *textbuf, int xstart,
         GlyphPosition *pos = &font->positions->pos[i];                                                                  \
         TTF_Font *glyph_font = pos->font;                                                                               \
         FT_UInt idx = pos->index;                                                                                       \
-        int x = pos->x;                                                                                                 \
+        int x = (WS ? SUBPIXEL_ROUND(pos->x) : pos->x);                                                                 \
         int y = pos->y;                                                                                                 \
         TTF_Image *image;                                                                                               \
                                                                                                                         \
@@ -1376,7 +1593,7 @@ static bool Render_Line(const render_mode_t render_mode, int subpixel, TTF_Font
     // Render line (positions) to textbuf at (xstart, ystart)
 
     // Subpixel with RENDER_SOLID doesn't make sense.
-    // (and 'cached->subpixel.translation' would need to distinguish bitmap/pixmap).
+    // (and the subpixel bins would need to distinguish bitmap/pixmap).
     int is_opaque = (fg.a == SDL_ALPHA_OPAQUE);
 
 #define Call_Specific_Render_Line(NAME)                                                                     \
@@ -1429,7 +1646,7 @@ static bool Render_Line(const render_mode_t render_mode, int subpixel, TTF_Font
 #endif
 }
 
-static bool Render_Line_TextEngine(TTF_Font *font, TTF_Direction direction, int xstart, int ystart, int width, int height, TTF_DrawOperation *ops, int *current_op, TTF_SubString *clusters, int *current_cluster, int cluster_offset, int line_index)
+static bool Render_Line_TextEngine(TTF_Font *font, const GlyphPositions *positions, TTF_Direction direction, int xstart, int ystart, int width, int height, TTF_DrawOperation *ops, float *subpixel_offsets, int *current_op, TTF_SubString *clusters, int *current_cluster, int cluster_offset, int line_index)
 {
     int i;
     int op_index = *current_op;
@@ -1443,8 +1660,8 @@ static bool Render_Line_TextEngine(TTF_Font *font, TTF_Direction direction, int
     bounds.w = 0;
     bounds.h = font->height;
 
-    for (i = 0; i < font->positions->len; i++) {
-        GlyphPosition *pos = &font->positions->pos[i];
+    for (i = 0; i < positions->len; i++) {
+        GlyphPosition *pos = &positions->pos[i];
         TTF_Font *glyph_font = pos->font;
         FT_UInt idx = pos->index;
         int x = pos->x;
@@ -1456,8 +1673,15 @@ static bool Render_Line_TextEngine(TTF_Font *font, TTF_Direction direction, int
         int glyph_y = 0;
         int glyph_width = glyph->sz_width;
         int glyph_rows = glyph->sz_rows;
+        int subpixel = 0;
         TTF_DrawOperation *op;
 
+        // Glyphs are drawn at the quantized subpixel offset, the integer part goes in the position
+        if (subpixel_offsets && glyph_font->render_subpixel && !glyph_font->render_sdf) {
+            x = SUBPIXEL_ROUND(x);
+            subpixel = (x & 63);
+        }
+
         // Position updated after glyph rendering
         x = xstart + FT_FLOOR(x) + glyph->sz_left;
         y = ystart + FT_FLOOR(y) - glyph->sz_top;
@@ -1501,9 +1725,29 @@ static bool Render_Line_TextEngine(TTF_Font *font, TTF_Direction direction, int
             op->copy.dst.y = y;
             op->copy.dst.w = op->copy.src.w;
             op->copy.dst.h = op->copy.src.h;
+            if (subpixel_offsets) {
+                subpixel_offsets[op_index - 1] = subpixel / 64.0f;
+            }
             if (glyph_font->render_sdf) {
-                op->copy.dst.x -= DEFAULT_SDF_SPREAD;
-                op->copy.dst.y -= DEFAULT_SDF_SPREAD;
+                c_sdf_glyph *sdf;
+                float scale_x, scale_y;
+                if (UseReferenceSDF(glyph_font) &&
+                    Find_SDFGlyph(glyph_font, idx, &sdf) &&
+                    Get_SDFScale(glyph_font, &scale_x, &scale_y)) {
+                    // Scale the whole reference image to the current font size
+                    const int spread = glyph_font->sdf_spread;
+                    op->copy.src.x = 0;
+                    op->copy.src.y = 0;
+                    op->copy.src.w = sdf->image.width;
+                    op->copy.src.h = sdf->image.rows;
+                    op->copy.dst.x = (x - glyph->sz_left) + (int)SDL_floorf((sdf->left - spread) * scale_x);
+                    op->copy.dst.y = (y + glyph->sz_top) - (int)SDL_ceilf((sdf->top + spread) * scale_y);
+                    op->copy.dst.w = (int)SDL_ceilf(sdf->image.width * scale_x);
+                    op->copy.dst.h = (int)SDL_ceilf(sdf->image.rows * scale_y);
+                } else {
+                    op->copy.dst.x -= glyph_font->sdf_spread;
+                    op->copy.dst.y -= glyph_font->sdf_spread;
+                }
             }
         } else {
             // Use the distance to the next glyph as our bounds width
@@ -1518,8 +1762,8 @@ static bool Render_Line_TextEngine(TTF_Font *font, TTF_Direction direction, int
             cluster->line_index = line_index;
             if (direction == TTF_DIRECTION_INVALID) {
                 if (last_offset == -1) {
-                    if (i < (font->positions->len - 1)) {
-                        GlyphPosition *next = &font->positions->pos[i + 1];
+                    if (i < (positions->len - 1)) {
+                        GlyphPosition *next = &positions->pos[i + 1];
                         if (offset < next->offset) {
                             cluster->flags = TTF_DIRECTION_LTR;
                         } else {
@@ -1855,6 +2099,7 @@ bool TTF_Init(void)
         TTF_SetFTError("Couldn't init FreeType engine", error);
         result = false;
     }
+    TTF_state.sdf_spread = DEFAULT_SDF_SPREAD;
 
     if (result) {
 #if TTF_USE_SDF
@@ -2029,6 +2274,7 @@ TTF_Font *TTF_OpenFontWithProperties(SDL_PropertiesID props)
     font->src_offset = src_offset;
     font->closeio = closeio;
     font->generation = TTF_GetNextFontGeneration();
+    font->image_generation = font->generation;
 
     if (existing_font) {
         if (existing_font->name) {
@@ -2083,6 +2329,7 @@ TTF_Font *TTF_OpenFontWithProperties(SDL_PropertiesID props)
         TTF_CloseFont(font);
         return NULL;
     }
+    font->cache_budget = DEFAULT_CACHE_BUDGET;
 
     font->glyph_indices = SDL_CreateHashTable(128, false, SDL_HashID, SDL_KeyMatchID, NULL, NULL);
     if (!font->glyph_indices) {
@@ -2158,10 +2405,15 @@ TTF_Font *TTF_OpenFontWithProperties(SDL_PropertiesID props)
         font->outline = existing_font->outline;
         font->ft_load_target = existing_font->ft_load_target;
         font->enable_kerning = existing_font->enable_kerning;
+        font->scale_bitmaps = existing_font->scale_bitmaps;
+        font->max_hot_images = existing_font->max_hot_images;
+        font->sdf_spread = existing_font->sdf_spread;
+        font->sdf_reference_size = existing_font->sdf_reference_size;
     } else {
         font->style = TTF_STYLE_NORMAL;
         font->outline = 0;
         font->ft_load_target = FT_LOAD_TARGET_NORMAL;
+        font->sdf_spread = DEFAULT_SDF_SPREAD;
         TTF_SetFontKerning(font, true);
 
         // Retrieve the weight from the OS2 TrueType table
@@ -2252,10 +2504,21 @@ static bool RemoveFontTextReference(TTF_Font *font, TTF_Text *text)
 static bool SDLCALL UpdateFontTextCallback(void *userdata, const SDL_HashTable *table, const void *key, const void *value)
 {
     TTF_Text *text = (TTF_Text *)key;
+    text->internal->layout->needs_reshape = true;
     text->internal->needs_layout_update = true;
     return true;
 }
 
+static void ClearWordCache(TTF_Font *font)
+{
+    if (font->word_runs) {
+        SDL_ClearHashTable(font->word_runs);
+        font->num_word_runs = 0;
+    }
+}
+
+static void DetachSharedLayouts(TTF_Font *font);
+
 static void UpdateFontText(TTF_Font *font, TTF_Font *initial_font)
 {
     if (!initial_font) {
@@ -2265,6 +2528,10 @@ static void UpdateFontText(TTF_Font *font, TTF_Font *initial_font)
         return;
     }
 
+    // Any change to this font or its fallbacks may change how words are shaped
+    ClearWordCache(font);
+    DetachSharedLayouts(font);
+
     if (font->text) {
         SDL_IterateHashTable(font->text, UpdateFontTextCallback, NULL);
     }
@@ -2288,7 +2555,7 @@ Uint32 TTF_GetFontGeneration(TTF_Font *font)
 {
     TTF_CHECK_FONT(font, 0);
 
-    return font->generation;
+    return font->image_generation;
 }
 
 bool TTF_AddFallbackFont(TTF_Font *font, TTF_Font *fallback)
@@ -2379,169 +2646,2126 @@ void TTF_ClearFallbackFonts(TTF_Font *font)
     }
 }
 
-// Update font parameter depending on a style change
-static void TTF_InitFontMetrics(TTF_Font *font)
-{
-    FT_Face face = font->face;
-    int underline_offset;
-
-    // Make sure that our font face is scalable (global metrics)
-    if (FT_IS_SCALABLE(face)) {
-        // Get the scalable font metrics for this font
-        FT_Fixed scale       = face->size->metrics.y_scale;
-        font->ascent         = FT_CEIL(FT_MulFix(face->ascender, scale));
-        font->descent        = FT_CEIL(FT_MulFix(face->descender, scale));
-        font->height         = FT_CEIL(FT_MulFix(face->ascender - face->descender, scale));
-        font->lineskip       = FT_CEIL(FT_MulFix(face->height, scale));
-        underline_offset     = FT_FLOOR(FT_MulFix(face->underline_position, scale));
-        font->line_thickness = FT_FLOOR(FT_MulFix(face->underline_thickness, scale));
-    } else {
-        // Get the font metrics for this font, for the selected size
-        font->ascent         = FT_CEIL(face->size->metrics.ascender);
-        font->descent        = FT_CEIL(face->size->metrics.descender);
-        font->height         = FT_CEIL(face->size->metrics.height);
-        font->lineskip       = FT_CEIL(face->size->metrics.height);
-        /* face->underline_position and face->underline_height are only
-         * relevant for scalable formats (see freetype.h FT_FaceRec) */
-        underline_offset     = font->descent / 2;
-        font->line_thickness = 1;
-    }
+// Font registry index file, all values little endian
+#define TTF_REGISTRY_MAGIC      0x52465454  // "TTFR"
+#define TTF_REGISTRY_VERSION    1
 
-    if (font->line_thickness < 1) {
-        font->line_thickness = 1;
-    }
+typedef struct TTF_RegistryEntry {
+    char *path;         // The font file, or NULL for fonts in memory
+    const void *data;   // The font data, for fonts in memory
+    size_t datasize;
+    Uint64 file_size;
+    SDL_Time modify_time;
+    int face_index;
+    char *family;
+    char *style;
+    int weight;
+    bool italic;
+    int num_ranges;
+    Uint32 *ranges;     // Pairs of the first and last codepoint covered
+    bool removed;       // The font file was indexed again, the entry is kept so fonts opened from it stay valid
+} TTF_RegistryEntry;
+
+// The entries of each indexed font file, which are consecutive
+typedef struct TTF_RegistryFile {
+    char *path;
+    Uint64 file_size;
+    SDL_Time modify_time;
+    int first_entry;
+    int num_entries;
+} TTF_RegistryFile;
+
+struct TTF_FontRegistry {
+    SDL_Mutex *lock;
+    int num_entries;
+    int max_entries;
+    TTF_RegistryEntry *entries;
 
-    font->underline_top_row     = font->ascent - underline_offset - 1;
-    font->strikethrough_top_row = font->height / 2;
+    // Font files by path
+    SDL_HashTable *files;
 
-    // Adjust OutlineStyle, only for scalable fonts
-    /* TTF_Size(): increase w and h by 2 * outline, translate positionning by 1 * outline */
-    if (font->outline > 0) {
-        int fo = font->outline;
-        font->line_thickness        += 2 * fo;
-        font->underline_top_row     -= fo;
-        font->strikethrough_top_row -= fo;
-    }
+    // Codepoints mapped to the first entry covering them, plus one, or 0 if none do
+    SDL_HashTable *lookups;
+};
 
-    // Robustness: no negative values allowed
-    font->underline_top_row     = SDL_max(0, font->underline_top_row);
-    font->strikethrough_top_row = SDL_max(0, font->strikethrough_top_row);
+static void DestroyRegistryEntry(TTF_RegistryEntry *entry)
+{
+    SDL_free(entry->path);
+    SDL_free(entry->family);
+    SDL_free(entry->style);
+    SDL_free(entry->ranges);
+}
 
-    // Update height according to the needs of the underline style
-    if (TTF_HANDLE_STYLE_UNDERLINE(font)) {
-        int bottom_row = font->underline_top_row + font->line_thickness;
-        font->height = SDL_max(font->height, bottom_row);
-    }
-    // Update height according to the needs of the strikethrough style
-    if (TTF_HANDLE_STYLE_STRIKETHROUGH(font)) {
-        int bottom_row = font->strikethrough_top_row + font->line_thickness;
-        font->height = SDL_max(font->height, bottom_row);
+static TTF_RegistryEntry *AddRegistryEntry(TTF_FontRegistry *registry)
+{
+    if (registry->num_entries == registry->max_entries) {
+        int max_entries = SDL_max(16, registry->max_entries * 2);
+        TTF_RegistryEntry *entries = (TTF_RegistryEntry *)SDL_realloc(registry->entries, max_entries * sizeof(*entries));
+        if (!entries) {
+            return NULL;
+        }
+        registry->entries = entries;
+        registry->max_entries = max_entries;
     }
 
-#if defined(DEBUG_FONTS)
-    SDL_Log("Font metrics:");
-    SDL_Log("ascent = %d, descent = %d", font->ascent, font->descent);
-    SDL_Log("height = %d, lineskip = %d", font->height, font->lineskip);
-    SDL_Log("underline_offset = %d, line_thickness = %d", underline_offset, font->line_thickness);
-    SDL_Log("underline_top_row = %d, strikethrough_top_row = %d", font->underline_top_row, font->strikethrough_top_row);
-    SDL_Log("scalable=%d fixed_sizes=%d", FT_IS_SCALABLE(face), FT_HAS_FIXED_SIZES(face));
-#endif
-
-    font->glyph_overhang = face->size->metrics.y_ppem / 10;
+    TTF_RegistryEntry *entry = &registry->entries[registry->num_entries++];
+    SDL_zerop(entry);
+    return entry;
 }
 
-static void Flush_Glyph_Image(TTF_Image *image)
+// Any added or removed entry may change which entry covers a codepoint
+static void UpdateRegistryLookups(TTF_FontRegistry *registry)
 {
-    if (image->buffer) {
-        SDL_free(image->buffer);
-        image->buffer = NULL;
+    if (registry->lookups) {
+        SDL_ClearHashTable(registry->lookups);
     }
 }
 
-static void Flush_Glyph(c_glyph *glyph)
+static void SDLCALL DestroyRegistryFile(void *userdata, const void *key, const void *value)
 {
-    glyph->stored = 0;
-    Flush_Glyph_Image(&glyph->pixmap);
-    Flush_Glyph_Image(&glyph->bitmap);
+    TTF_RegistryFile *file = (TTF_RegistryFile *)value;
+
+    (void)userdata;
+    (void)key;
+    SDL_free(file->path);
+    SDL_free(file);
 }
 
-static bool SDLCALL FlushCacheCallback(void *userdata, const SDL_HashTable *table, const void *key, const void *value)
+// Remove the entries of a font file that was indexed before
+static void RemoveRegistryFile(TTF_FontRegistry *registry, const char *path)
 {
-    c_glyph *glyph = (c_glyph *)value;
-    if (glyph->stored) {
-        Flush_Glyph(glyph);
+    TTF_RegistryFile *file;
+
+    if (!SDL_FindInHashTable(registry->files, path, (const void **)&file)) {
+        return;
     }
-    return true;
+
+    for (int i = 0; i < file->num_entries; ++i) {
+        TTF_RegistryEntry *entry = &registry->entries[file->first_entry + i];
+        DestroyRegistryEntry(entry);
+        SDL_zerop(entry);
+        entry->removed = true;
+    }
+    SDL_RemoveFromHashTable(registry->files, path);
+    UpdateRegistryLookups(registry);
 }
 
-static void Flush_Cache(TTF_Font *font)
+static TTF_RegistryFile *AddRegistryFileEntries(TTF_FontRegistry *registry, const char *path, Uint64 file_size, SDL_Time modify_time, int first_entry)
 {
-    SDL_IterateHashTable(font->glyphs, FlushCacheCallback, NULL);
+    TTF_RegistryFile *file = (TTF_RegistryFile *)SDL_calloc(1, sizeof(*file));
+    if (!file) {
+        return NULL;
+    }
 
-    for (unsigned int i = 0; i < SDL_arraysize(font->cached_positions); ++i) {
-        CachedGlyphPositions *cached = &font->cached_positions[i];
-        if (cached->text) {
-            SDL_free(cached->text);
-            cached->text = NULL;
-            cached->length = 0;
-        }
-        if (cached->positions.pos) {
-            SDL_free(cached->positions.pos);
-            cached->positions.pos = NULL;
-            cached->positions.len = 0;
-            cached->positions.maxlen = 0;
-        }
+    file->path = SDL_strdup(path);
+    if (!file->path) {
+        SDL_free(file);
+        return NULL;
     }
-    font->positions = NULL;
+    file->file_size = file_size;
+    file->modify_time = modify_time;
+    file->first_entry = first_entry;
+    file->num_entries = registry->num_entries - first_entry;
 
-    font->generation = TTF_GetNextFontGeneration();
+    if (!SDL_InsertIntoHashTable(registry->files, file->path, file, true)) {
+        DestroyRegistryFile(NULL, file->path, file);
+        return NULL;
+    }
+    return file;
 }
 
-static bool Load_Glyph(TTF_Font *font, c_glyph *cached, int want, int translation)
+static bool GetRegistryCoverage(FT_Face face, TTF_RegistryEntry *entry)
 {
-    const int alignment = Get_Alignment() - 1;
-    FT_GlyphSlot slot;
-    FT_Error error;
+    int max_ranges = 0;
+    FT_UInt idx;
 
-    int ft_load = FT_LOAD_DEFAULT | font->ft_load_target;
+    if (FT_Select_Charmap(face, FT_ENCODING_UNICODE) != 0) {
+        // Not a Unicode font, it can't be used for fallback
+        return true;
+    }
 
-    if (want & CACHED_COLOR) {
-        ft_load |= FT_LOAD_COLOR;
+    // Merge consecutive codepoints into ranges
+    FT_ULong ch = FT_Get_First_Char(face, &idx);
+    while (idx != 0) {
+        if (entry->num_ranges > 0 && entry->ranges[2 * entry->num_ranges - 1] + 1 == ch) {
+            entry->ranges[2 * entry->num_ranges - 1] = (Uint32)ch;
+        } else {
+            if (entry->num_ranges == max_ranges) {
+                max_ranges = SDL_max(64, max_ranges * 2);
+                Uint32 *ranges = (Uint32 *)SDL_realloc(entry->ranges, 2 * max_ranges * sizeof(*ranges));
+                if (!ranges) {
+                    return false;
+                }
+                entry->ranges = ranges;
+            }
+            entry->ranges[2 * entry->num_ranges] = (Uint32)ch;
+            entry->ranges[2 * entry->num_ranges + 1] = (Uint32)ch;
+            ++entry->num_ranges;
+        }
+        ch = FT_Get_Next_Char(face, ch, &idx);
     }
 
-    if (FT_HAS_SVG(font->face)) {
-        // We won't get metrics unless we add FT_LOAD_COLOR
-        ft_load |= FT_LOAD_COLOR;
+    // Trim the ranges to fit
+    if (entry->num_ranges > 0 && entry->num_ranges < max_ranges) {
+        Uint32 *ranges = (Uint32 *)SDL_realloc(entry->ranges, 2 * entry->num_ranges * sizeof(*ranges));
+        if (ranges) {
+            entry->ranges = ranges;
+        }
     }
+    return true;
+}
 
-    error = FT_Load_Glyph(font->face, cached->index, ft_load);
-    if (error) {
-        return TTF_SetFTError("FT_Load_Glyph() failed", error);
+static bool RegistryEntryCovers(const TTF_RegistryEntry *entry, Uint32 ch)
+{
+    int low = 0;
+    int high = entry->num_ranges - 1;
+    while (low <= high) {
+        int mid = (low + high) / 2;
+        if (ch < entry->ranges[2 * mid]) {
+            high = mid - 1;
+        } else if (ch > entry->ranges[2 * mid + 1]) {
+            low = mid + 1;
+        } else {
+            return true;
+        }
     }
+    return false;
+}
 
-    // Get our glyph shortcut
-    slot = font->face->glyph;
+// Index every face in a font file or buffer
+static bool IndexRegistryFont(TTF_FontRegistry *registry, const char *path, const void *data, size_t datasize, const SDL_PathInfo *info)
+{
+    FT_Long num_faces = 1;
+    bool result = true;
 
-    if (want & CACHED_LCD) {
-        if (slot->format == FT_GLYPH_FORMAT_BITMAP) {
-            return SDL_SetError("LCD mode not possible with bitmap font");
-        }
+    if (path) {
+        RemoveRegistryFile(registry, path);
     }
+    const int first_entry = registry->num_entries;
 
-    // Get the glyph metrics, always needed
-    if (cached->stored == 0) {
-        cached->sz_left  = slot->bitmap_left;
-        cached->sz_top   = slot->bitmap_top;
-        cached->sz_rows  = slot->bitmap.rows;
-        cached->sz_width = slot->bitmap.width;
+    for (FT_Long face_index = 0; face_index < num_faces; ++face_index) {
+        FT_Face face = NULL;
+        FT_Error error;
 
-        /* Current version of freetype is 2.9.1, but on older freetype (2.8.1) this can be 0.
-         * Try to get them from 'FT_Glyph_Metrics' */
-        if (cached->sz_left == 0 && cached->sz_top == 0 && cached->sz_rows == 0 && cached->sz_width == 0) {
-            FT_Glyph_Metrics *metrics = &slot->metrics;
-            if (metrics) {
-                int minx = FT_FLOOR(metrics->horiBearingX);
-                int maxx = FT_CEIL(metrics->horiBearingX + metrics->width);
+        SDL_LockMutex(TTF_state.lock);
+        error = FT_New_Memory_Face(TTF_state.library, (const FT_Byte *)data, (FT_Long)datasize, face_index, &face);
+        SDL_UnlockMutex(TTF_state.lock);
+        if (error || !face) {
+            // Not a font we can use, skip it
+            break;
+        }
+        num_faces = face->num_faces;
+
+        TTF_RegistryEntry *entry = AddRegistryEntry(registry);
+        if (!entry) {
+            result = false;
+        } else {
+            if (path) {
+                entry->path = SDL_strdup(path);
+                entry->file_size = info->size;
+                entry->modify_time = info->modify_time;
+            } else {
+                entry->data = data;
+                entry->datasize = datasize;
+            }
+            entry->face_index = (int)face_index;
+            entry->family = SDL_strdup(face->family_name ? face->family_name : "");
+            entry->style = SDL_strdup(face->style_name ? face->style_name : "");
+            entry->italic = ((face->style_flags & FT_STYLE_FLAG_ITALIC) != 0);
+
+            TT_OS2 *os2 = (TT_OS2 *)FT_Get_Sfnt_Table(face, FT_SFNT_OS2);
+            if (os2 && os2->version != 0xFFFF && os2->usWeightClass != 0) {
+                entry->weight = os2->usWeightClass;
+            } else if (face->style_flags & FT_STYLE_FLAG_BOLD) {
+                entry->weight = TTF_FONT_WEIGHT_BOLD;
+            } else {
+                entry->weight = TTF_FONT_WEIGHT_NORMAL;
+            }
+
+            if ((path && !entry->path) || !entry->family || !entry->style ||
+                !GetRegistryCoverage(face, entry)) {
+                DestroyRegistryEntry(entry);
+                --registry->num_entries;
+                result = false;
+            }
+        }
+
+        SDL_LockMutex(TTF_state.lock);
+        FT_Done_Face(face);
+        SDL_UnlockMutex(TTF_state.lock);
+
+        if (!result) {
+            break;
+        }
+    }
+
+    // Files without usable fonts are recorded too, so they aren't parsed again
+    if (path && !AddRegistryFileEntries(registry, path, info->size, info->modify_time, first_entry)) {
+        result = false;
+    }
+    UpdateRegistryLookups(registry);
+
+    return result;
+}
+
+static bool IsRegistryFontFile(const char *path)
+{
+    static const char *extensions[] = { ".ttf", ".otf", ".ttc", ".otc" };
+    size_t length = SDL_strlen(path);
+
+    for (unsigned int i = 0; i < SDL_arraysize(extensions); ++i) {
+        size_t extlen = SDL_strlen(extensions[i]);
+        if (length > extlen && SDL_strcasecmp(path + length - extlen, extensions[i]) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool IsRegistryFileIndexed(TTF_FontRegistry *registry, const char *path, const SDL_PathInfo *info)
+{
+    const TTF_RegistryFile *file;
+
+    if (!SDL_FindInHashTable(registry->files, path, (const void **)&file)) {
+        return false;
+    }
+    return (file->file_size == info->size && file->modify_time == info->modify_time);
+}
+
+static bool AddRegistryFile(TTF_FontRegistry *registry, const char *path, const SDL_PathInfo *info)
+{
+    if (IsRegistryFileIndexed(registry, path, info)) {
+        return true;
+    }
+
+    size_t datasize = 0;
+    void *data = SDL_LoadFile(path, &datasize);
+    if (!data) {
+        return false;
+    }
+    bool result = IndexRegistryFont(registry, path, data, datasize, info);
+    SDL_free(data);
+    return result;
+}
+
+static bool AddRegistryPath(TTF_FontRegistry *registry, const char *path);
+
+static SDL_EnumerationResult SDLCALL AddRegistryDirectoryEntry(void *userdata, const char *dirname, const char *fname)
+{
+    TTF_FontRegistry *registry = (TTF_FontRegistry *)userdata;
+    char *path = NULL;
+
+    if (SDL_asprintf(&path, "%s%s", dirname, fname) < 0) {
+        return SDL_ENUM_FAILURE;
+    }
+
+    SDL_PathInfo info;
+    if (SDL_GetPathInfo(path, &info)) {
+        // Unreadable fonts are skipped, they shouldn't prevent indexing the rest of the directory
+        if (info.type == SDL_PATHTYPE_DIRECTORY) {
+            AddRegistryPath(registry, path);
+        } else if (info.type == SDL_PATHTYPE_FILE && IsRegistryFontFile(path)) {
+            AddRegistryFile(registry, path, &info);
+        }
+    }
+    SDL_free(path);
+
+    return SDL_ENUM_CONTINUE;
+}
+
+static bool AddRegistryPath(TTF_FontRegistry *registry, const char *path)
+{
+    SDL_PathInfo info;
+
+    if (!SDL_GetPathInfo(path, &info)) {
+        return false;
+    }
+
+    if (info.type == SDL_PATHTYPE_DIRECTORY) {
+        return SDL_EnumerateDirectory(path, AddRegistryDirectoryEntry, registry);
+    }
+    return AddRegistryFile(registry, path, &info);
+}
+
+TTF_FontRegistry *TTF_CreateFontRegistry(void)
+{
+    TTF_CHECK_INITIALIZED(NULL);
+
+    TTF_FontRegistry *registry = (TTF_FontRegistry *)SDL_calloc(1, sizeof(*registry));
+    if (!registry) {
+        return NULL;
+    }
+
+    registry->lock = SDL_CreateMutex();
+    registry->files = SDL_CreateHashTable(0, false, SDL_HashString, SDL_KeyMatchString, DestroyRegistryFile, NULL);
+    registry->lookups = SDL_CreateHashTable(0, false, SDL_HashID, SDL_KeyMatchID, NULL, NULL);
+    if (!registry->lock || !registry->files || !registry->lookups) {
+        TTF_DestroyFontRegistry(registry);
+        return NULL;
+    }
+    return registry;
+}
+
+bool TTF_AddFontRegistryPath(TTF_FontRegistry *registry, const char *path)
+{
+    TTF_CHECK_POINTER("registry", registry, false);
+    TTF_CHECK_POINTER("path", path, false);
+
+    SDL_LockMutex(registry->lock);
+    bool result = AddRegistryPath(registry, path);
+    SDL_UnlockMutex(registry->lock);
+
+    return result;
+}
+
+bool TTF_AddFontRegistryData(TTF_FontRegistry *registry, const void *data, size_t size)
+{
+    TTF_CHECK_POINTER("registry", registry, false);
+    TTF_CHECK_POINTER("data", data, false);
+
+    SDL_LockMutex(registry->lock);
+    bool result = IndexRegistryFont(registry, NULL, data, size, NULL);
+    SDL_UnlockMutex(registry->lock);
+
+    return result;
+}
+
+static bool WriteRegistryString(SDL_IOStream *dst, const char *string)
+{
+    Uint32 length = (Uint32)SDL_strlen(string);
+    return SDL_WriteU32LE(dst, length) && SDL_WriteIO(dst, string, length) == length;
+}
+
+// The index is read from disk, so anything it says is stored must fit in what's left of it
+static bool CheckRegistryLength(SDL_IOStream *src, Uint64 length)
+{
+    Sint64 size = SDL_GetIOSize(src);
+    Sint64 offset = SDL_TellIO(src);
+    if (size < 0 || offset < 0 || offset > size || length > (Uint64)(size - offset) || length >= SDL_SIZE_MAX) {
+        return SDL_SetError("Corrupt font registry index");
+    }
+    return true;
+}
+
+static bool ReadRegistryString(SDL_IOStream *src, char **string)
+{
+    Uint32 length;
+    if (!SDL_ReadU32LE(src, &length) || !CheckRegistryLength(src, length)) {
+        return false;
+    }
+
+    *string = (char *)SDL_malloc((size_t)length + 1);
+    if (!*string) {
+        return false;
+    }
+    if (SDL_ReadIO(src, *string, length) != length) {
+        return false;
+    }
+    (*string)[length] = '\0';
+    return true;
+}
+
+bool TTF_SaveFontRegistry(TTF_FontRegistry *registry, const char *file)
+{
+    TTF_CHECK_POINTER("registry", registry, false);
+    TTF_CHECK_POINTER("file", file, false);
+
+    SDL_IOStream *dst = SDL_IOFromFile(file, "wb");
+    if (!dst) {
+        return false;
+    }
+
+    SDL_LockMutex(registry->lock);
+
+    Uint32 num_entries = 0;
+    for (int i = 0; i < registry->num_entries; ++i) {
+        if (registry->entries[i].path) {
+            ++num_entries;
+        }
+    }
+
+    bool result = (SDL_WriteU32LE(dst, TTF_REGISTRY_MAGIC) &&
+                   SDL_WriteU32LE(dst, TTF_REGISTRY_VERSION) &&
+                   SDL_WriteU32LE(dst, num_entries));
+    for (int i = 0; result && i < registry->num_entries; ++i) {
+        const TTF_RegistryEntry *entry = &registry->entries[i];
+        if (!entry->path) {
+            // Fonts in memory can't be found again
+            continue;
+        }
+
+        result = (WriteRegistryString(dst, entry->path) &&
+                  SDL_WriteU64LE(dst, entry->file_size) &&
+                  SDL_WriteS64LE(dst, entry->modify_time) &&
+                  SDL_WriteU32LE(dst, (Uint32)entry->face_index) &&
+                  WriteRegistryString(dst, entry->family) &&
+                  WriteRegistryString(dst, entry->style) &&
+                  SDL_WriteU32LE(dst, (Uint32)entry->weight) &&
+                  SDL_WriteU8(dst, entry->italic ? 1 : 0) &&
+                  SDL_WriteU32LE(dst, (Uint32)entry->num_ranges));
+        for (int j = 0; result && j < 2 * entry->num_ranges; ++j) {
+            result = SDL_WriteU32LE(dst, entry->ranges[j]);
+        }
+    }
+
+    SDL_UnlockMutex(registry->lock);
+
+    if (!SDL_CloseIO(dst)) {
+        result = false;
+    }
+    return result;
+}
+
+static bool ReadRegistryEntry(SDL_IOStream *src, TTF_RegistryEntry *entry)
+{
+    Uint32 face_index, weight, num_ranges;
+    Uint8 italic;
+
+    if (!ReadRegistryString(src, &entry->path) ||
+        !SDL_ReadU64LE(src, &entry->file_size) ||
+        !SDL_ReadS64LE(src, &entry->modify_time) ||
+        !SDL_ReadU32LE(src, &face_index) ||
+        !ReadRegistryString(src, &entry->family) ||
+        !ReadRegistryString(src, &entry->style) ||
+        !SDL_ReadU32LE(src, &weight) ||
+        !SDL_ReadU8(src, &italic) ||
+        !SDL_ReadU32LE(src, &num_ranges)) {
+        return false;
+    }
+    entry->face_index = (int)face_index;
+    entry->weight = (int)weight;
+    entry->italic = (italic != 0);
+
+    if (num_ranges > 0) {
+        if (num_ranges > SDL_MAX_SINT32 / 2 ||
+            !CheckRegistryLength(src, 2 * (Uint64)num_ranges * sizeof(*entry->ranges))) {
+            return false;
+        }
+        entry->ranges = (Uint32 *)SDL_malloc(2 * (size_t)num_ranges * sizeof(*entry->ranges));
+        if (!entry->ranges) {
+            return false;
+        }
+        for (Uint32 i = 0; i < 2 * num_ranges; ++i) {
+            if (!SDL_ReadU32LE(src, &entry->ranges[i])) {
+                return false;
+            }
+        }
+
+        // Coverage is binary searched, so the ranges have to be sorted and can't overlap
+        for (Uint32 i = 0; i < num_ranges; ++i) {
+            if (entry->ranges[2 * i] > entry->ranges[2 * i + 1] ||
+                (i > 0 && entry->ranges[2 * i] <= entry->ranges[2 * i - 1])) {
+                return SDL_SetError("Corrupt font registry index");
+            }
+        }
+    }
+    entry->num_ranges = (int)num_ranges;
+    return true;
+}
+
+bool TTF_LoadFontRegistry(TTF_FontRegistry *registry, const char *file)
+{
+    TTF_CHECK_POINTER("registry", registry, false);
+    TTF_CHECK_POINTER("file", file, false);
+
+    SDL_IOStream *src = SDL_IOFromFile(file, "rb");
+    if (!src) {
+        return false;
+    }
+
+    bool result = false;
+    Uint32 magic, version, num_entries;
+    if (!SDL_ReadU32LE(src, &magic) ||
+        !SDL_ReadU32LE(src, &version) ||
+        !SDL_ReadU32LE(src, &num_entries)) {
+        SDL_CloseIO(src);
+        return false;
+    }
+    if (magic != TTF_REGISTRY_MAGIC || version != TTF_REGISTRY_VERSION) {
+        SDL_CloseIO(src);
+        return SDL_SetError("Unsupported font registry index");
+    }
+
+    SDL_LockMutex(registry->lock);
+
+    const int first_loaded = registry->num_entries;
+    Uint32 i;
+    for (i = 0; i < num_entries; ++i) {
+        TTF_RegistryEntry *entry = AddRegistryEntry(registry);
+        if (!entry) {
+            break;
+        }
+        if (!ReadRegistryEntry(src, entry)) {
+            DestroyRegistryEntry(entry);
+            --registry->num_entries;
+            break;
+        }
+
+        // Skip fonts that have changed since the index was saved
+        SDL_PathInfo info;
+        if (!SDL_GetPathInfo(entry->path, &info) ||
+            info.size != entry->file_size || info.modify_time != entry->modify_time) {
+            DestroyRegistryEntry(entry);
+            --registry->num_entries;
+            continue;
+        }
+
+        // The entries of a file replace the ones it had before
+        const int index = registry->num_entries - 1;
+        TTF_RegistryFile *indexed;
+        if (SDL_FindInHashTable(registry->files, entry->path, (const void **)&indexed) &&
+            indexed->first_entry >= first_loaded && indexed->first_entry + indexed->num_entries == index) {
+            ++indexed->num_entries;
+        } else {
+            RemoveRegistryFile(registry, entry->path);
+            if (!AddRegistryFileEntries(registry, entry->path, entry->file_size, entry->modify_time, index)) {
+                DestroyRegistryEntry(entry);
+                --registry->num_entries;
+                break;
+            }
+        }
+    }
+    if (i == num_entries) {
+        result = true;
+    }
+    UpdateRegistryLookups(registry);
+
+    SDL_UnlockMutex(registry->lock);
+
+    SDL_CloseIO(src);
+    return result;
+}
+
+static TTF_Font *OpenRegistryFont(const TTF_RegistryEntry *entry, float ptsize, int hdpi, int vdpi)
+{
+    SDL_PropertiesID props = SDL_CreateProperties();
+    if (!props) {
+        return NULL;
+    }
+
+    if (entry->path) {
+        SDL_SetStringProperty(props, TTF_PROP_FONT_CREATE_FILENAME_STRING, entry->path);
+    } else {
+        SDL_IOStream *src = SDL_IOFromConstMem(entry->data, entry->datasize);
+        if (!src) {
+            SDL_DestroyProperties(props);
+            return NULL;
+        }
+        SDL_SetPointerProperty(props, TTF_PROP_FONT_CREATE_IOSTREAM_POINTER, src);
+        SDL_SetBooleanProperty(props, TTF_PROP_FONT_CREATE_IOSTREAM_AUTOCLOSE_BOOLEAN, true);
+    }
+    SDL_SetNumberProperty(props, TTF_PROP_FONT_CREATE_FACE_NUMBER, entry->face_index);
+    SDL_SetFloatProperty(props, TTF_PROP_FONT_CREATE_SIZE_FLOAT, ptsize);
+    SDL_SetNumberProperty(props, TTF_PROP_FONT_CREATE_HORIZONTAL_DPI_NUMBER, hdpi);
+    SDL_SetNumberProperty(props, TTF_PROP_FONT_CREATE_VERTICAL_DPI_NUMBER, vdpi);
+    TTF_Font *font = TTF_OpenFontWithProperties(props);
+    SDL_DestroyProperties(props);
+    return font;
+}
+
+TTF_Font *TTF_OpenFontFromRegistry(TTF_FontRegistry *registry, const char *family, TTF_FontStyleFlags style, float ptsize)
+{
+    TTF_CHECK_POINTER("registry", registry, NULL);
+    TTF_CHECK_POINTER("family", family, NULL);
+
+    const bool italic = ((style & TTF_STYLE_ITALIC) != 0);
+    const int weight = ((style & TTF_STYLE_BOLD) ? TTF_FONT_WEIGHT_BOLD : TTF_FONT_WEIGHT_NORMAL);
+    TTF_Font *font = NULL;
+
+    SDL_LockMutex(registry->lock);
+
+    // Italic matters more than weight, which is compared by distance
+    const TTF_RegistryEntry *best = NULL;
+    int best_score = 0;
+    for (int i = 0; i < registry->num_entries; ++i) {
+        const TTF_RegistryEntry *entry = &registry->entries[i];
+        if (entry->removed || SDL_strcasecmp(entry->family, family) != 0) {
+            continue;
+        }
+
+        int score = SDL_abs(entry->weight - weight);
+        if (entry->italic != italic) {
+            score += 1000;
+        }
+        if (!best || score < best_score) {
+            best = entry;
+            best_score = score;
+        }
+    }
+
+    if (best) {
+        font = OpenRegistryFont(best, ptsize, 0, 0);
+    } else {
+        SDL_SetError("Couldn't find font family %s", family);
+    }
+
+    SDL_UnlockMutex(registry->lock);
+
+    return font;
+}
+
+// Find the first entry at or after 'start' that covers a codepoint
+static int FindRegistryEntry(TTF_FontRegistry *registry, Uint32 ch, int start)
+{
+    const void *value;
+
+    if (start == 0 && SDL_FindInHashTable(registry->lookups, (const void *)(uintptr_t)ch, &value)) {
+        return (int)(uintptr_t)value - 1;
+    }
+
+    int found = -1;
+    for (int i = start; i < registry->num_entries; ++i) {
+        if (RegistryEntryCovers(&registry->entries[i], ch)) {
+            found = i;
+            break;
+        }
+    }
+
+    if (start == 0) {
+        SDL_InsertIntoHashTable(registry->lookups, (const void *)(uintptr_t)ch, (const void *)(uintptr_t)(found + 1), true);
+    }
+    return found;
+}
+
+static bool IsFallbackFont(TTF_Font *font, TTF_Font *fallback)
+{
+    for (TTF_FontList *list = font->fallbacks; list; list = list->next) {
+        if (list->font == fallback) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Registry fonts aren't visible to the application, so they're given the size and
+ * rasterization settings of the font they're a fallback for, and follow its changes */
+static void SyncRegistryFont(const TTF_Font *font, TTF_Font *fallback)
+{
+    TTF_SetFontSizeDPI(fallback, font->ptsize, font->hdpi, font->vdpi);
+    TTF_SetFontStyle(fallback, font->style);
+    TTF_SetFontOutline(fallback, font->outline);
+    TTF_SetFontHinting(fallback, TTF_GetFontHinting(font));
+#if TTF_USE_SDF
+    if (font->render_msdf) {
+        TTF_SetFontMSDF(fallback, true);
+    } else {
+        TTF_SetFontSDF(fallback, font->render_sdf);
+    }
+#endif
+    TTF_SetFontSDFSpread(fallback, font->sdf_spread);
+    TTF_SetFontSDFReferenceSize(fallback, font->sdf_reference_size);
+    TTF_SetFontDirection(fallback, font->direction);
+#if TTF_USE_HARFBUZZ
+    if (fallback->script != font->script) {
+        TTF_SetFontScript(fallback, font->script);
+    }
+#endif
+}
+
+static void SyncRegistryFonts(TTF_Font *font)
+{
+    for (TTF_RegistryFont *opened = font->registry_fonts; opened; opened = opened->next) {
+        if (opened->font) {
+            SyncRegistryFont(font, opened->font);
+        }
+    }
+}
+
+/* Open the first registry font covering a codepoint that isn't in the font yet, and
+ * add it as a fallback font. Returns the new fallback font, or NULL if there isn't one. */
+static TTF_Font *LoadRegistryFallback(TTF_Font *font, Uint32 ch)
+{
+    TTF_FontRegistry *registry = font->registry;
+    TTF_Font *fallback = NULL;
+
+    if (ch < ' ' || ch == 0x7F) {
+        // Control characters aren't drawn, there's no need to look for them
+        return NULL;
+    }
+
+    SDL_LockMutex(registry->lock);
+
+    for (int entry = FindRegistryEntry(registry, ch, 0); entry >= 0; entry = FindRegistryEntry(registry, ch, entry + 1)) {
+        TTF_RegistryFont *opened;
+        for (opened = font->registry_fonts; opened; opened = opened->next) {
+            if (opened->entry == entry) {
+                break;
+            }
+        }
+
+        if (opened) {
+            // This was removed with TTF_ClearFallbackFonts(), add it back
+            if (!IsFallbackFont(font, opened->font) && TTF_AddFallbackFont(font, opened->font)) {
+                fallback = opened->font;
+                break;
+            }
+            continue;
+        }
+
+        opened = (TTF_RegistryFont *)SDL_calloc(1, sizeof(*opened));
+        if (!opened) {
+            break;
+        }
+        opened->entry = entry;
+        opened->font = OpenRegistryFont(&registry->entries[entry], font->ptsize, font->hdpi, font->vdpi);
+        if (!opened->font) {
+            // Remember that this one is unusable
+            opened->next = font->registry_fonts;
+            font->registry_fonts = opened;
+            continue;
+        }
+        opened->next = font->registry_fonts;
+        font->registry_fonts = opened;
+        SyncRegistryFont(font, opened->font);
+
+        if (TTF_AddFallbackFont(font, opened->font)) {
+            fallback = opened->font;
+        }
+        break;
+    }
+
+    SDL_UnlockMutex(registry->lock);
+
+    return fallback;
+}
+
+static void CloseRegistryFonts(TTF_Font *font)
+{
+    while (font->registry_fonts) {
+        TTF_RegistryFont *opened = font->registry_fonts;
+        font->registry_fonts = opened->next;
+        if (opened->font) {
+            TTF_RemoveFallbackFont(font, opened->font);
+            TTF_CloseFont(opened->font);
+        }
+        SDL_free(opened);
+    }
+}
+
+bool TTF_SetFontRegistry(TTF_Font *font, TTF_FontRegistry *registry)
+{
+    TTF_CHECK_FONT(font, false);
+
+    if (registry == font->registry) {
+        return true;
+    }
+
+    CloseRegistryFonts(font);
+    font->registry = registry;
+
+    // Characters that were missing may be found now
+    UpdateFontText(font, NULL);
+
+    return true;
+}
+
+TTF_FontRegistry *TTF_GetFontRegistry(const TTF_Font *font)
+{
+    TTF_CHECK_FONT(font, NULL);
+
+    return font->registry;
+}
+
+void TTF_DestroyFontRegistry(TTF_FontRegistry *registry)
+{
+    if (!registry) {
+        return;
+    }
+
+    for (int i = 0; i < registry->num_entries; ++i) {
+        DestroyRegistryEntry(&registry->entries[i]);
+    }
+    SDL_free(registry->entries);
+    if (registry->files) {
+        SDL_DestroyHashTable(registry->files);
+    }
+    if (registry->lookups) {
+        SDL_DestroyHashTable(registry->lookups);
+    }
+    if (registry->lock) {
+        SDL_DestroyMutex(registry->lock);
+    }
+    SDL_free(registry);
+}
+
+// Scale a value measured at the selected bitmap strike to the requested point size
+static int Scale_BitmapValue(const TTF_Font *font, long value)
+{
+    if (font->bitmap_scale > 0.0f) {
+        return (int)SDL_roundf(value * font->bitmap_scale);
+    }
+    return (int)value;
+}
+
+// Update font parameter depending on a style change
+static void TTF_InitFontMetrics(TTF_Font *font)
+{
+    FT_Face face = font->face;
+    int underline_offset;
+
+    // Make sure that our font face is scalable (global metrics)
+    if (FT_IS_SCALABLE(face)) {
+        // Get the scalable font metrics for this font
+        FT_Fixed scale       = face->size->metrics.y_scale;
+        font->ascent         = FT_CEIL(FT_MulFix(face->ascender, scale));
+        font->descent        = FT_CEIL(FT_MulFix(face->descender, scale));
+        font->height         = FT_CEIL(FT_MulFix(face->ascender - face->descender, scale));
+        font->lineskip       = FT_CEIL(FT_MulFix(face->height, scale));
+        underline_offset     = FT_FLOOR(FT_MulFix(face->underline_position, scale));
+        font->line_thickness = FT_FLOOR(FT_MulFix(face->underline_thickness, scale));
+    } else {
+        // Get the font metrics for this font, for the selected size
+        font->ascent         = FT_CEIL(Scale_BitmapValue(font, face->size->metrics.ascender));
+        font->descent        = FT_CEIL(Scale_BitmapValue(font, face->size->metrics.descender));
+        font->height         = FT_CEIL(Scale_BitmapValue(font, face->size->metrics.height));
+        font->lineskip       = FT_CEIL(Scale_BitmapValue(font, face->size->metrics.height));
+        /* face->underline_position and face->underline_height are only
+         * relevant for scalable formats (see freetype.h FT_FaceRec) */
+        underline_offset     = font->descent / 2;
+        font->line_thickness = 1;
+    }
+
+    if (font->line_thickness < 1) {
+        font->line_thickness = 1;
+    }
+
+    font->underline_top_row     = font->ascent - underline_offset - 1;
+    font->strikethrough_top_row = font->height / 2;
+
+    // Adjust OutlineStyle, only for scalable fonts
+    /* TTF_Size(): increase w and h by 2 * outline, translate positionning by 1 * outline */
+    if (font->outline > 0) {
+        int fo = font->outline;
+        font->line_thickness        += 2 * fo;
+        font->underline_top_row     -= fo;
+        font->strikethrough_top_row -= fo;
+    }
+
+    // Robustness: no negative values allowed
+    font->underline_top_row     = SDL_max(0, font->underline_top_row);
+    font->strikethrough_top_row = SDL_max(0, font->strikethrough_top_row);
+
+    // Update height according to the needs of the underline style
+    if (TTF_HANDLE_STYLE_UNDERLINE(font)) {
+        int bottom_row = font->underline_top_row + font->line_thickness;
+        font->height = SDL_max(font->height, bottom_row);
+    }
+    // Update height according to the needs of the strikethrough style
+    if (TTF_HANDLE_STYLE_STRIKETHROUGH(font)) {
+        int bottom_row = font->strikethrough_top_row + font->line_thickness;
+        font->height = SDL_max(font->height, bottom_row);
+    }
+
+#if defined(DEBUG_FONTS)
+    SDL_Log("Font metrics:");
+    SDL_Log("ascent = %d, descent = %d", font->ascent, font->descent);
+    SDL_Log("height = %d, lineskip = %d", font->height, font->lineskip);
+    SDL_Log("underline_offset = %d, line_thickness = %d", underline_offset, font->line_thickness);
+    SDL_Log("underline_top_row = %d, strikethrough_top_row = %d", font->underline_top_row, font->strikethrough_top_row);
+    SDL_Log("scalable=%d fixed_sizes=%d", FT_IS_SCALABLE(face), FT_HAS_FIXED_SIZES(face));
+#endif
+
+    font->glyph_overhang = Scale_BitmapValue(font, face->size->metrics.y_ppem) / 10;
+}
+
+static void Unlink_HotImage(TTF_Image *image)
+{
+    if (image->hot_font) {
+        image->hot.prev->next = image->hot.next;
+        image->hot.next->prev = image->hot.prev;
+        --image->hot_font->num_hot_images;
+        image->hot_font = NULL;
+    }
+}
+
+static void Link_HotImage(TTF_Font *font, TTF_Image *image)
+{
+    if (!font->hot_images.next) {
+        font->hot_images.prev = &font->hot_images;
+        font->hot_images.next = &font->hot_images;
+    }
+
+    image->hot.prev = &font->hot_images;
+    image->hot.next = font->hot_images.next;
+    image->hot.next->prev = &image->hot;
+    font->hot_images.next = &image->hot;
+    image->hot_font = font;
+    ++font->num_hot_images;
+}
+
+// Drop the decompressed pixels of the least recently used glyph images, keeping the one in use
+static void Trim_HotImages(TTF_Font *font)
+{
+    while (font->num_hot_images > SDL_max(font->max_hot_images, 1)) {
+        TTF_Image *image = TTF_HOT_IMAGE(font->hot_images.prev);
+        Unlink_HotImage(image);
+
+        // Text engines may be using the pixels, those are kept until the image is used again
+        if (!image->handle) {
+            SDL_free(image->buffer);
+            image->buffer = NULL;
+        }
+    }
+}
+
+/* Run-length encode the pixels of a grayscale or monochrome glyph image.
+ * Each row is a series of runs: a control byte below 128 is followed by that many plus one
+ * literal pixels, one above 128 is followed by a pixel repeated 257 minus that many times.
+ * Images that don't get smaller are left uncompressed. */
+static bool Compress_GlyphImage(TTF_Font *font, TTF_Image *image, int alignment)
+{
+    const int width = image->width;
+    const Uint8 *pixels = image->buffer + alignment;
+
+    /* At worst a single literal pixel alternates with a run of two, taking 4 bytes
+     * for 3 pixels, plus a control byte for a literal pixel left at the end of the row */
+    size_t max_size = (size_t)image->rows * (width + (width + 2) / 3 + 1);
+
+    Uint8 *compressed = (Uint8 *)SDL_malloc(max_size);
+    if (!compressed) {
+        return false;
+    }
+
+    Uint8 *dst = compressed;
+    for (int y = 0; y < image->rows; ++y) {
+        const Uint8 *src = pixels + y * image->pitch;
+        int remaining = width;
+        while (remaining > 0) {
+            int run = 1;
+            while (run < remaining && run < 128 && src[run] == src[0]) {
+                ++run;
+            }
+            if (run > 1) {
+                *dst++ = (Uint8)(257 - run);
+                *dst++ = src[0];
+            } else {
+                // Collect literal pixels until the next repeated pair
+                while (run < remaining && run < 128 &&
+                       !(run + 1 < remaining && src[run] == src[run + 1])) {
+                    ++run;
+                }
+                *dst++ = (Uint8)(run - 1);
+                SDL_memcpy(dst, src, run);
+                dst += run;
+            }
+            src += run;
+            remaining -= run;
+        }
+    }
+
+    size_t compressed_size = (size_t)(dst - compressed);
+    if (compressed_size >= (size_t)image->width * image->rows) {
+        SDL_free(compressed);
+        return true;
+    }
+
+    image->compressed_size = compressed_size;
+    image->compressed = (Uint8 *)SDL_realloc(compressed, image->compressed_size);
+    if (!image->compressed) {
+        image->compressed = compressed;
+    }
+
+    // The image was just rendered to be used, so keep it decompressed for now
+    Link_HotImage(font, image);
+    Trim_HotImages(font);
+    return true;
+}
+
+static bool Decompress_GlyphImage(TTF_Image *image)
+{
+    const int alignment = Get_Alignment() - 1;
+
+    Uint8 *buffer = (Uint8 *)SDL_calloc(1, alignment + (size_t)image->pitch * image->rows);
+    if (!buffer) {
+        return false;
+    }
+
+    const Uint8 *src = image->compressed;
+    for (int y = 0; y < image->rows; ++y) {
+        Uint8 *dst = buffer + alignment + y * image->pitch;
+        int x = 0;
+        while (x < image->width) {
+            int control = *src++;
+            if (control < 128) {
+                SDL_memcpy(&dst[x], src, control + 1);
+                src += control + 1;
+                x += control + 1;
+            } else {
+                SDL_memset(&dst[x], *src++, 257 - control);
+                x += 257 - control;
+            }
+        }
+    }
+    image->buffer = buffer;
+    return true;
+}
+
+// Make sure the pixels of a compressed glyph image are available, and mark it as recently used
+static bool Use_GlyphImage(TTF_Font *font, TTF_Image *image)
+{
+    if (!image->buffer && !Decompress_GlyphImage(image)) {
+        return false;
+    }
+
+    Unlink_HotImage(image);
+    Link_HotImage(font, image);
+    Trim_HotImages(font);
+    return true;
+}
+
+static void Flush_Glyph_Image(TTF_Image *image)
+{
+    Unlink_HotImage(image);
+    if (image->compressed) {
+        SDL_free(image->compressed);
+        image->compressed = NULL;
+        image->compressed_size = 0;
+    }
+    if (image->handle) {
+        // A text engine is still using this image, let it keep the pixels
+        image->handle->buffer = image->buffer;
+        image->handle->cached = NULL;
+        image->handle = NULL;
+        image->buffer = NULL;
+    }
+    if (image->buffer) {
+        SDL_free(image->buffer);
+        image->buffer = NULL;
+    }
+}
+
+static void Flush_Glyph(c_glyph *glyph)
+{
+    glyph->stored = 0;
+    Flush_Glyph_Image(&glyph->pixmap);
+    Flush_Glyph_Image(&glyph->bitmap);
+    if (glyph->subpixel_bins) {
+        for (int i = 0; i < SUBPIXEL_BINS - 1; ++i) {
+            Flush_Glyph_Image(&glyph->subpixel_bins[i].pixmap);
+        }
+        SDL_free(glyph->subpixel_bins);
+        glyph->subpixel_bins = NULL;
+    }
+}
+
+static bool SDLCALL FlushCacheCallback(void *userdata, const SDL_HashTable *table, const void *key, const void *value)
+{
+    c_glyph *glyph = (c_glyph *)value;
+    if (glyph->stored) {
+        Flush_Glyph(glyph);
+    }
+    return true;
+}
+
+static void Flush_CachedGlyphPositions(CachedGlyphPositions *positions, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        CachedGlyphPositions *cached = &positions[i];
+        if (cached->text) {
+            SDL_free(cached->text);
+            cached->text = NULL;
+            cached->length = 0;
+        }
+        if (cached->positions.pos) {
+            SDL_free(cached->positions.pos);
+            cached->positions.pos = NULL;
+            cached->positions.len = 0;
+            cached->positions.maxlen = 0;
+        }
+    }
+}
+
+static void Flush_CachedPositions(TTF_Font *font)
+{
+    Flush_CachedGlyphPositions(font->cached_positions, SDL_arraysize(font->cached_positions));
+    font->positions = NULL;
+}
+
+static void SDLCALL DestroySDFGlyph(void *unused, const void *key, const void *value)
+{
+    c_sdf_glyph *glyph = (c_sdf_glyph *)value;
+    Flush_Glyph_Image(&glyph->image);
+    SDL_free(glyph);
+}
+
+static void Get_GlyphCacheConfig(const TTF_Font *font, GlyphCacheConfig *config)
+{
+    SDL_zerop(config);
+    config->ptsize = font->ptsize;
+    config->hdpi = font->hdpi;
+    config->vdpi = font->vdpi;
+    config->style = (font->style & ~TTF_STYLE_NO_GLYPH_CHANGE);
+    config->outline = font->outline;
+    config->ft_load_target = font->ft_load_target;
+    config->render_subpixel = font->render_subpixel;
+    config->render_sdf = font->render_sdf;
+    config->render_msdf = font->render_msdf;
+    if (font->render_sdf) {
+        config->sdf_spread = font->sdf_spread;
+    }
+    config->bitmap_strike = font->bitmap_strike;
+    config->bitmap_scale = font->bitmap_scale;
+}
+
+static size_t Get_ImageSize(const TTF_Image *image)
+{
+    size_t size = image->compressed_size;
+    if (image->buffer) {
+        size += (size_t)(Get_Alignment() - 1) + (size_t)image->pitch * image->rows;
+    }
+    return size;
+}
+
+static bool SDLCALL GlyphSizeCallback(void *userdata, const SDL_HashTable *table, const void *key, const void *value)
+{
+    const c_glyph *glyph = (const c_glyph *)value;
+    size_t *size = (size_t *)userdata;
+
+    *size += sizeof(*glyph) + Get_ImageSize(&glyph->bitmap) + Get_ImageSize(&glyph->pixmap);
+    if (glyph->subpixel_bins) {
+        for (int i = 0; i < SUBPIXEL_BINS - 1; ++i) {
+            *size += Get_ImageSize(&glyph->subpixel_bins[i].pixmap);
+        }
+    }
+    return true;
+}
+
+static bool SDLCALL SDFGlyphSizeCallback(void *userdata, const SDL_HashTable *table, const void *key, const void *value)
+{
+    const c_sdf_glyph *glyph = (const c_sdf_glyph *)value;
+    size_t *size = (size_t *)userdata;
+
+    *size += sizeof(*glyph) + Get_ImageSize(&glyph->image);
+    return true;
+}
+
+static void Destroy_GlyphCache(GlyphCache *cache)
+{
+    SDL_IterateHashTable(cache->glyphs, FlushCacheCallback, NULL);
+    SDL_DestroyHashTable(cache->glyphs);
+    if (cache->sdf_glyphs) {
+        SDL_DestroyHashTable(cache->sdf_glyphs);
+    }
+    Flush_CachedGlyphPositions(cache->cached_positions, SDL_arraysize(cache->cached_positions));
+    if (cache->word_runs) {
+        SDL_DestroyHashTable(cache->word_runs);
+    }
+    SDL_free(cache);
+}
+
+static void Flush_GlyphCaches(TTF_Font *font)
+{
+    while (font->glyph_caches) {
+        GlyphCache *cache = font->glyph_caches;
+        font->glyph_caches = cache->next;
+        Destroy_GlyphCache(cache);
+    }
+}
+
+// Drop the least recently used configurations until they fit in the budget
+static void Trim_GlyphCaches(TTF_Font *font)
+{
+    GlyphCache **prev = &font->glyph_caches;
+    size_t size = 0;
+
+    while (*prev) {
+        GlyphCache *cache = *prev;
+        if (size + cache->size > font->cache_budget) {
+            *prev = cache->next;
+            Destroy_GlyphCache(cache);
+        } else {
+            size += cache->size;
+            prev = &cache->next;
+        }
+    }
+}
+
+/* Switch to the glyphs of the current rasterization configuration,
+ * keeping the glyphs of the previous one so switching back is cheap */
+static void Switch_GlyphCache(TTF_Font *font, const GlyphCacheConfig *prev)
+{
+    GlyphCacheConfig config, unsized;
+    GlyphCache *cache, **link;
+    SDL_HashTable *glyphs = NULL;
+    bool keep_sdf_glyphs;
+
+    Get_GlyphCacheConfig(font, &config);
+    if (SDL_memcmp(&config, prev, sizeof(config)) == 0) {
+        return;
+    }
+
+    // Reference SDF glyphs are shared by all sizes with otherwise identical settings
+    SDL_copyp(&unsized, prev);
+    unsized.ptsize = config.ptsize;
+    unsized.hdpi = config.hdpi;
+    unsized.vdpi = config.vdpi;
+    keep_sdf_glyphs = (UseReferenceSDF(font) && SDL_memcmp(&config, &unsized, sizeof(config)) == 0);
+
+    for (link = &font->glyph_caches; *link; link = &(*link)->next) {
+        if (SDL_memcmp(&(*link)->config, &config, sizeof(config)) == 0) {
+            break;
+        }
+    }
+    if (!*link) {
+        glyphs = SDL_CreateHashTable(128, false, SDL_HashID, SDL_KeyMatchID, SDL_DestroyHashValue, NULL);
+    }
+
+    cache = (GlyphCache *)SDL_calloc(1, sizeof(*cache));
+    if (!cache || (!*link && !glyphs)) {
+        // Fall back to rebuilding the glyphs from scratch
+        SDL_free(cache);
+        if (glyphs) {
+            SDL_DestroyHashTable(glyphs);
+        }
+        Flush_Cache(font);
+        return;
+    }
+
+    // Keep the current glyphs and positions around
+    SDL_copyp(&cache->config, prev);
+    cache->glyphs = font->glyphs;
+    cache->generation = font->generation;
+    cache->image_generation = font->image_generation;
+    SDL_IterateHashTable(cache->glyphs, GlyphSizeCallback, &cache->size);
+    if (!keep_sdf_glyphs) {
+        cache->sdf_glyphs = font->sdf_glyphs;
+        if (cache->sdf_glyphs) {
+            SDL_IterateHashTable(cache->sdf_glyphs, SDFGlyphSizeCallback, &cache->size);
+        }
+    }
+    cache->next_cached_positions = font->next_cached_positions;
+    SDL_memcpy(cache->cached_positions, font->cached_positions, sizeof(cache->cached_positions));
+    cache->word_runs = font->word_runs;
+    cache->num_word_runs = font->num_word_runs;
+
+    if (*link) {
+        // Reuse everything from the last time this configuration was active
+        GlyphCache *found = *link;
+        *link = found->next;
+        font->glyphs = found->glyphs;
+        if (keep_sdf_glyphs) {
+            if (found->sdf_glyphs) {
+                SDL_DestroyHashTable(found->sdf_glyphs);
+            }
+        } else {
+            font->sdf_glyphs = found->sdf_glyphs;
+            font->image_generation = found->image_generation;
+        }
+        font->generation = found->generation;
+        font->next_cached_positions = found->next_cached_positions;
+        SDL_memcpy(font->cached_positions, found->cached_positions, sizeof(font->cached_positions));
+        font->word_runs = found->word_runs;
+        font->num_word_runs = found->num_word_runs;
+        SDL_free(found);
+    } else {
+        font->glyphs = glyphs;
+        if (!keep_sdf_glyphs) {
+            font->sdf_glyphs = NULL;
+            font->image_generation = TTF_GetNextFontGeneration();
+        }
+        font->generation = TTF_GetNextFontGeneration();
+        font->next_cached_positions = 0;
+        SDL_zeroa(font->cached_positions);
+        font->word_runs = NULL;
+        font->num_word_runs = 0;
+    }
+    font->positions = NULL;
+
+    cache->next = font->glyph_caches;
+    font->glyph_caches = cache;
+    Trim_GlyphCaches(font);
+}
+
+static void Flush_Cache(TTF_Font *font)
+{
+    Flush_GlyphCaches(font);
+
+    if (font->sdf_glyphs) {
+        SDL_ClearHashTable(font->sdf_glyphs);
+    }
+
+    SDL_IterateHashTable(font->glyphs, FlushCacheCallback, NULL);
+
+    Flush_CachedPositions(font);
+    ClearWordCache(font);
+
+    font->generation = TTF_GetNextFontGeneration();
+    font->image_generation = font->generation;
+}
+
+bool TTF_SetFontCacheBudget(TTF_Font *font, size_t bytes)
+{
+    TTF_CHECK_FONT(font, false);
+
+    font->cache_budget = bytes;
+    Trim_GlyphCaches(font);
+    return true;
+}
+
+size_t TTF_GetFontCacheBudget(const TTF_Font *font)
+{
+    TTF_CHECK_FONT(font, 0);
+
+    return font->cache_budget;
+}
+
+bool TTF_SetFontGlyphCompression(TTF_Font *font, int hot_glyphs)
+{
+    TTF_CHECK_FONT(font, false);
+
+    hot_glyphs = SDL_max(hot_glyphs, 0);
+
+    bool was_enabled = (font->max_hot_images > 0);
+    font->max_hot_images = hot_glyphs;
+
+    if ((hot_glyphs > 0) != was_enabled) {
+        // Render the glyphs again in the new format
+        Flush_Cache(font);
+        UpdateFontText(font, NULL);
+    } else {
+        Trim_HotImages(font);
+    }
+    return true;
+}
+
+int TTF_GetFontGlyphCompression(const TTF_Font *font)
+{
+    TTF_CHECK_FONT(font, 0);
+
+    return font->max_hot_images;
+}
+
+/* Multi-channel signed distance fields
+ *
+ * This follows the original msdfgen approach by Viktor Chlumsky: the edges of
+ * each contour are split at corners and colored so that the two edges meeting
+ * at a corner share exactly one channel. Each channel stores the signed
+ * pseudo-distance to the nearest edge of its color, and the median of the
+ * three channels reconstructs sharp corners at any scale. The alpha channel
+ * has the true signed distance, like a regular SDF.
+ *
+ * Overlapping contours aren't resolved, which is fine for most fonts.
+ */
+#define MSDF_BLACK      0
+#define MSDF_RED        1
+#define MSDF_GREEN      2
+#define MSDF_YELLOW     3
+#define MSDF_BLUE       4
+#define MSDF_MAGENTA    5
+#define MSDF_CYAN       6
+#define MSDF_WHITE      7
+
+// Curves are split into this many line segments for distance queries
+#define MSDF_CONIC_STEPS    8
+#define MSDF_CUBIC_STEPS    12
+
+// Larger than any distance in a glyph image
+#define MSDF_INFINITY       1e30f
+
+// Edges meeting at an angle over 3 radians from straight form a corner: sin(3)
+#define MSDF_CORNER_THRESHOLD   0.14112f
+
+typedef struct MSDF_Point {
+    float x;
+    float y;
+} MSDF_Point;
+
+typedef struct MSDF_Edge {
+    int color;
+    int first_point;
+    int num_points;
+} MSDF_Edge;
+
+typedef struct MSDF_Shape {
+    MSDF_Point *points;
+    int num_points;
+    int max_points;
+    MSDF_Edge *edges;
+    int num_edges;
+    int max_edges;
+    int *contours;  // The first edge of each contour
+    int num_contours;
+    int max_contours;
+    MSDF_Point pen;
+    bool failed;
+} MSDF_Shape;
+
+static bool MSDF_AddPoint(MSDF_Shape *shape, float x, float y)
+{
+    if (shape->num_points == shape->max_points) {
+        int max_points = SDL_max(64, 2 * shape->max_points);
+        MSDF_Point *points = (MSDF_Point *)SDL_realloc(shape->points, max_points * sizeof(*points));
+        if (!points) {
+            shape->failed = true;
+            return false;
+        }
+        shape->points = points;
+        shape->max_points = max_points;
+    }
+
+    MSDF_Point *point = &shape->points[shape->num_points++];
+    point->x = x;
+    point->y = y;
+    return true;
+}
+
+// Add an edge made of the points added since first_point
+static void MSDF_AddEdge(MSDF_Shape *shape, int first_point)
+{
+    int num_points = shape->num_points - first_point;
+    const MSDF_Point *points = &shape->points[first_point];
+
+    // Skip degenerate edges
+    bool empty = true;
+    for (int i = 1; i < num_points; ++i) {
+        if (points[i].x != points[0].x || points[i].y != points[0].y) {
+            empty = false;
+            break;
+        }
+    }
+    if (empty) {
+        shape->num_points = first_point;
+        return;
+    }
+
+    if (shape->num_edges == shape->max_edges) {
+        int max_edges = SDL_max(32, 2 * shape->max_edges);
+        MSDF_Edge *edges = (MSDF_Edge *)SDL_realloc(shape->edges, max_edges * sizeof(*edges));
+        if (!edges) {
+            shape->failed = true;
+            return;
+        }
+        shape->edges = edges;
+        shape->max_edges = max_edges;
+    }
+
+    MSDF_Edge *edge = &shape->edges[shape->num_edges++];
+    edge->color = MSDF_WHITE;
+    edge->first_point = first_point;
+    edge->num_points = num_points;
+    shape->pen = points[num_points - 1];
+}
+
+static int MSDF_MoveTo(const FT_Vector *to, void *user)
+{
+    MSDF_Shape *shape = (MSDF_Shape *)user;
+
+    if (shape->num_contours == shape->max_contours) {
+        int max_contours = SDL_max(8, 2 * shape->max_contours);
+        int *contours = (int *)SDL_realloc(shape->contours, max_contours * sizeof(*contours));
+        if (!contours) {
+            shape->failed = true;
+            return 1;
+        }
+        shape->contours = contours;
+        shape->max_contours = max_contours;
+    }
+    shape->contours[shape->num_contours++] = shape->num_edges;
+
+    shape->pen.x = to->x / 64.0f;
+    shape->pen.y = to->y / 64.0f;
+    return 0;
+}
+
+static int MSDF_LineTo(const FT_Vector *to, void *user)
+{
+    MSDF_Shape *shape = (MSDF_Shape *)user;
+    int first_point = shape->num_points;
+
+    if (!MSDF_AddPoint(shape, shape->pen.x, shape->pen.y) ||
+        !MSDF_AddPoint(shape, to->x / 64.0f, to->y / 64.0f)) {
+        return 1;
+    }
+    MSDF_AddEdge(shape, first_point);
+    return shape->failed;
+}
+
+static int MSDF_ConicTo(const FT_Vector *control, const FT_Vector *to, void *user)
+{
+    MSDF_Shape *shape = (MSDF_Shape *)user;
+    int first_point = shape->num_points;
+    const MSDF_Point p0 = shape->pen;
+    const float cx = control->x / 64.0f, cy = control->y / 64.0f;
+    const float x = to->x / 64.0f, y = to->y / 64.0f;
+
+    if (!MSDF_AddPoint(shape, p0.x, p0.y)) {
+        return 1;
+    }
+    for (int i = 1; i <= MSDF_CONIC_STEPS; ++i) {
+        float t = (float)i / MSDF_CONIC_STEPS;
+        float s = 1.0f - t;
+        if (!MSDF_AddPoint(shape, s * s * p0.x + 2.0f * s * t * cx + t * t * x,
+                                  s * s * p0.y + 2.0f * s * t * cy + t * t * y)) {
+            return 1;
+        }
+    }
+    MSDF_AddEdge(shape, first_point);
+    return shape->failed;
+}
+
+static int MSDF_CubicTo(const FT_Vector *control1, const FT_Vector *control2, const FT_Vector *to, void *user)
+{
+    MSDF_Shape *shape = (MSDF_Shape *)user;
+    int first_point = shape->num_points;
+    const MSDF_Point p0 = shape->pen;
+    const float c1x = control1->x / 64.0f, c1y = control1->y / 64.0f;
+    const float c2x = control2->x / 64.0f, c2y = control2->y / 64.0f;
+    const float x = to->x / 64.0f, y = to->y / 64.0f;
+
+    if (!MSDF_AddPoint(shape, p0.x, p0.y)) {
+        return 1;
+    }
+    for (int i = 1; i <= MSDF_CUBIC_STEPS; ++i) {
+        float t = (float)i / MSDF_CUBIC_STEPS;
+        float s = 1.0f - t;
+        if (!MSDF_AddPoint(shape, s * s * s * p0.x + 3.0f * s * s * t * c1x + 3.0f * s * t * t * c2x + t * t * t * x,
+                                  s * s * s * p0.y + 3.0f * s * s * t * c1y + 3.0f * s * t * t * c2y + t * t * t * y)) {
+            return 1;
+        }
+    }
+    MSDF_AddEdge(shape, first_point);
+    return shape->failed;
+}
+
+// Get the normalized direction at the start or end of an edge
+static MSDF_Point MSDF_EdgeDirection(const MSDF_Shape *shape, const MSDF_Edge *edge, bool at_end)
+{
+    const MSDF_Point *points = &shape->points[edge->first_point];
+    MSDF_Point dir = { 0.0f, 0.0f };
+
+    for (int i = 1; i < edge->num_points; ++i) {
+        const MSDF_Point *a, *b;
+        if (at_end) {
+            a = &points[edge->num_points - 1 - i];
+            b = &points[edge->num_points - i];
+        } else {
+            a = &points[i - 1];
+            b = &points[i];
+        }
+        dir.x = b->x - a->x;
+        dir.y = b->y - a->y;
+        if (dir.x != 0.0f || dir.y != 0.0f) {
+            float length = SDL_sqrtf(dir.x * dir.x + dir.y * dir.y);
+            dir.x /= length;
+            dir.y /= length;
+            break;
+        }
+    }
+    return dir;
+}
+
+static bool MSDF_IsCorner(const MSDF_Shape *shape, const MSDF_Edge *prev, const MSDF_Edge *edge)
+{
+    MSDF_Point a = MSDF_EdgeDirection(shape, prev, true);
+    MSDF_Point b = MSDF_EdgeDirection(shape, edge, false);
+    return (a.x * b.x + a.y * b.y) <= 0.0f || SDL_fabsf(a.x * b.y - a.y * b.x) > MSDF_CORNER_THRESHOLD;
+}
+
+static int MSDF_SwitchColor(int color, int banned)
+{
+    int combined = (color & banned);
+    if (combined == MSDF_RED || combined == MSDF_GREEN || combined == MSDF_BLUE) {
+        return (combined ^ MSDF_WHITE);
+    }
+    int shifted = (color << 1);
+    return ((shifted | (shifted >> 3)) & MSDF_WHITE);
+}
+
+static void MSDF_ColorEdges(MSDF_Shape *shape)
+{
+    for (int c = 0; c < shape->num_contours; ++c) {
+        MSDF_Edge *edges = &shape->edges[shape->contours[c]];
+        int count = ((c + 1 < shape->num_contours) ? shape->contours[c + 1] : shape->num_edges) - shape->contours[c];
+        int num_corners = 0;
+        int first_corner = 0;
+
+        for (int i = 0; i < count; ++i) {
+            if (MSDF_IsCorner(shape, &edges[(i + count - 1) % count], &edges[i])) {
+                if (num_corners == 0) {
+                    first_corner = i;
+                }
+                ++num_corners;
+            }
+        }
+
+        if (num_corners == 0 || count < 3) {
+            // A smooth contour, all channels are the same
+            for (int i = 0; i < count; ++i) {
+                edges[i].color = MSDF_WHITE;
+            }
+        } else if (num_corners == 1) {
+            // A teardrop, split the contour in three around the corner
+            static const int colors[] = { MSDF_MAGENTA, MSDF_WHITE, MSDF_YELLOW };
+            for (int i = 0; i < count; ++i) {
+                edges[(first_corner + i) % count].color = colors[(3 * i) / count];
+            }
+        } else {
+            int color = MSDF_CYAN;
+            int initial_color = color;
+            int corner = 0;
+            for (int i = 0; i < count; ++i) {
+                int index = (first_corner + i) % count;
+                if (i > 0 && MSDF_IsCorner(shape, &edges[(index + count - 1) % count], &edges[index])) {
+                    ++corner;
+                    // Make sure the last edge doesn't share a color with the first one
+                    color = MSDF_SwitchColor(color, (corner == num_corners - 1) ? initial_color : MSDF_BLACK);
+                }
+                edges[index].color = color;
+            }
+        }
+    }
+}
+
+/* Get the signed distance from a point to an edge, along with how far from
+ * perpendicular the nearest point is, to break ties between edges meeting at
+ * a corner, and the pseudo-distance that extends the edge past its ends.
+ */
+static void MSDF_EdgeDistance(const MSDF_Shape *shape, const MSDF_Edge *edge, float px, float py, float *distance, float *dot, float *pseudo_distance)
+{
+    const MSDF_Point *points = &shape->points[edge->first_point];
+    const int last = edge->num_points - 2;
+    float best = MSDF_INFINITY;
+    float best_dot = 1.0f;
+    float best_t = 0.0f;
+    float sign = 1.0f;
+    int best_segment = 0;
+
+    for (int i = 0; i <= last; ++i) {
+        const MSDF_Point *a = &points[i];
+        const MSDF_Point *b = &points[i + 1];
+        float abx = b->x - a->x;
+        float aby = b->y - a->y;
+        float length2 = abx * abx + aby * aby;
+        if (length2 <= 0.0f) {
+            continue;
+        }
+
+        float apx = px - a->x;
+        float apy = py - a->y;
+        float t = (apx * abx + apy * aby) / length2;
+        float tc = SDL_clamp(t, 0.0f, 1.0f);
+        float dx = apx - abx * tc;
+        float dy = apy - aby * tc;
+        float d = SDL_sqrtf(dx * dx + dy * dy);
+        float ortho = 0.0f;
+        if (d > 0.0f) {
+            ortho = SDL_fabsf(abx * dx + aby * dy) / (SDL_sqrtf(length2) * d);
+        }
+        if (d < best || (d == best && ortho < best_dot)) {
+            best = d;
+            best_dot = ortho;
+            best_t = t;
+            best_segment = i;
+            sign = ((abx * apy - aby * apx) >= 0.0f) ? 1.0f : -1.0f;
+        }
+    }
+
+    *distance = sign * best;
+    *dot = best_dot;
+    *pseudo_distance = *distance;
+
+    if (best_segment == 0 && best_t < 0.0f) {
+        MSDF_Point dir = MSDF_EdgeDirection(shape, edge, false);
+        float apx = px - points[0].x;
+        float apy = py - points[0].y;
+        if (apx * dir.x + apy * dir.y < 0.0f) {
+            float pd = dir.x * apy - dir.y * apx;
+            if (SDL_fabsf(pd) <= best) {
+                *pseudo_distance = pd;
+            }
+        }
+    } else if (best_segment == last && best_t > 1.0f) {
+        MSDF_Point dir = MSDF_EdgeDirection(shape, edge, true);
+        float bpx = px - points[last + 1].x;
+        float bpy = py - points[last + 1].y;
+        if (bpx * dir.x + bpy * dir.y > 0.0f) {
+            float pd = dir.x * bpy - dir.y * bpx;
+            if (SDL_fabsf(pd) <= best) {
+                *pseudo_distance = pd;
+            }
+        }
+    }
+}
+
+static float MSDF_Median(float a, float b, float c)
+{
+    return SDL_max(SDL_min(a, b), SDL_min(SDL_max(a, b), c));
+}
+
+// Check whether interpolating between two pixels would create an artifact
+static bool MSDF_Clash(const float *a, const float *b, float threshold)
+{
+    float a0 = a[0], a1 = a[1], a2 = a[2];
+    float b0 = b[0], b1 = b[1], b2 = b[2];
+    float tmp;
+
+    // Sort the channels so the pairs go from the biggest to the smallest difference
+    if (SDL_fabsf(b0 - a0) < SDL_fabsf(b1 - a1)) {
+        tmp = a0; a0 = a1; a1 = tmp;
+        tmp = b0; b0 = b1; b1 = tmp;
+    }
+    if (SDL_fabsf(b1 - a1) < SDL_fabsf(b2 - a2)) {
+        tmp = a1; a1 = a2; a2 = tmp;
+        tmp = b1; b1 = b2; b2 = tmp;
+        if (SDL_fabsf(b0 - a0) < SDL_fabsf(b1 - a1)) {
+            tmp = a0; a0 = a1; a1 = tmp;
+            tmp = b0; b0 = b1; b1 = tmp;
+        }
+    }
+    return (SDL_fabsf(b1 - a1) >= threshold) &&
+           !(b0 == b1 && b0 == b2) &&   // The other pixel was already corrected
+           SDL_fabsf(a2 - 0.5f) >= SDL_fabsf(b2 - 0.5f);  // Only fix the pixel further from the edge
+}
+
+static bool MSDF_CorrectErrors(float *values, int width, int rows, float threshold)
+{
+    bool *clashes = (bool *)SDL_calloc(width * rows, sizeof(*clashes));
+    if (!clashes) {
+        return false;
+    }
+
+    const float diagonal_threshold = threshold * 1.41421356f;
+    for (int y = 0; y < rows; ++y) {
+        for (int x = 0; x < width; ++x) {
+            const float *pixel = &values[(y * width + x) * 4];
+            if ((x > 0 && MSDF_Clash(pixel, pixel - 4, threshold)) ||
+                (x < width - 1 && MSDF_Clash(pixel, pixel + 4, threshold)) ||
+                (y > 0 && MSDF_Clash(pixel, pixel - width * 4, threshold)) ||
+                (y < rows - 1 && MSDF_Clash(pixel, pixel + width * 4, threshold)) ||
+                (x > 0 && y > 0 && MSDF_Clash(pixel, pixel - (width + 1) * 4, diagonal_threshold)) ||
+                (x < width - 1 && y > 0 && MSDF_Clash(pixel, pixel - (width - 1) * 4, diagonal_threshold)) ||
+                (x > 0 && y < rows - 1 && MSDF_Clash(pixel, pixel + (width - 1) * 4, diagonal_threshold)) ||
+                (x < width - 1 && y < rows - 1 && MSDF_Clash(pixel, pixel + (width + 1) * 4, diagonal_threshold))) {
+                clashes[y * width + x] = true;
+            }
+        }
+    }
+
+    for (int i = 0; i < width * rows; ++i) {
+        if (clashes[i]) {
+            float *pixel = &values[i * 4];
+            pixel[0] = pixel[1] = pixel[2] = MSDF_Median(pixel[0], pixel[1], pixel[2]);
+        }
+    }
+    SDL_free(clashes);
+    return true;
+}
+
+static Uint8 MSDF_ToByte(float value)
+{
+    return (Uint8)SDL_clamp(value * 255.0f + 0.5f, 0.0f, 255.0f);
+}
+
+/* Render a multi-channel signed distance field for an outline, as ARGB8888.
+ * The origin is the top left corner of the image in outline pixels.
+ */
+static bool Render_MSDF(FT_Outline *outline, int origin_x, int origin_y, int width, int rows, int spread, TTF_Image *dst)
+{
+    const int alignment = Get_Alignment() - 1;
+    const float range = 2.0f * spread;
+    FT_Outline_Funcs funcs;
+    MSDF_Shape shape;
+    float *values = NULL;
+    bool result = false;
+
+    dst->width    = SDL_max(width, 0);
+    dst->rows     = SDL_max(rows, 0);
+    dst->pitch    = 4 * dst->width + alignment;
+    dst->is_color = 1;
+    dst->buffer   = NULL;
+    if (dst->width == 0 || dst->rows == 0) {
+        dst->width = 0;
+        dst->rows = 0;
+        return true;
+    }
+
+    SDL_zero(funcs);
+    funcs.move_to = MSDF_MoveTo;
+    funcs.line_to = MSDF_LineTo;
+    funcs.conic_to = MSDF_ConicTo;
+    funcs.cubic_to = MSDF_CubicTo;
+
+    SDL_zero(shape);
+    if (FT_Outline_Decompose(outline, &funcs, &shape) != 0 || shape.failed) {
+        if (!shape.failed) {
+            SDL_SetError("Couldn't decompose glyph outline");
+        }
+        goto done;
+    }
+    MSDF_ColorEdges(&shape);
+
+    dst->buffer = (unsigned char *)SDL_calloc(1, alignment + dst->pitch * dst->rows);
+    if (!dst->buffer) {
+        goto done;
+    }
+    if (shape.num_edges == 0) {
+        // Nothing to draw, the whole image is outside the glyph
+        result = true;
+        goto done;
+    }
+
+    values = (float *)SDL_malloc(dst->width * dst->rows * 4 * sizeof(*values));
+    if (!values) {
+        goto done;
+    }
+
+    // The inside is on the right of TrueType contours and on the left of PostScript contours
+    const float fill_sign = (FT_Outline_Get_Orientation(outline) == FT_ORIENTATION_TRUETYPE) ? -1.0f : 1.0f;
+
+    float *value = values;
+    for (int row = 0; row < dst->rows; ++row) {
+        const float py = origin_y - row - 0.5f;
+        for (int col = 0; col < dst->width; ++col) {
+            const float px = origin_x + col + 0.5f;
+            float best[3] = { MSDF_INFINITY, MSDF_INFINITY, MSDF_INFINITY };
+            float best_dot[3] = { 1.0f, 1.0f, 1.0f };
+            float channel[3] = { 0.0f, 0.0f, 0.0f };
+            float nearest = MSDF_INFINITY;
+            float nearest_dot = 1.0f;
+            float true_distance = 0.0f;
+
+            for (int i = 0; i < shape.num_edges; ++i) {
+                const MSDF_Edge *edge = &shape.edges[i];
+                float distance, dot, pseudo_distance;
+
+                MSDF_EdgeDistance(&shape, edge, px, py, &distance, &dot, &pseudo_distance);
+
+                const float d = SDL_fabsf(distance);
+                for (int c = 0; c < 3; ++c) {
+                    if ((edge->color & (1 << c)) &&
+                        (d < best[c] || (d == best[c] && dot < best_dot[c]))) {
+                        best[c] = d;
+                        best_dot[c] = dot;
+                        channel[c] = pseudo_distance;
+                    }
+                }
+                if (d < nearest || (d == nearest && dot < nearest_dot)) {
+                    nearest = d;
+                    nearest_dot = dot;
+                    true_distance = distance;
+                }
+            }
+
+            // Channels are stored in RGB order, converted to ARGB8888 below
+            for (int c = 0; c < 3; ++c) {
+                if (best[c] == MSDF_INFINITY) {
+                    channel[c] = true_distance;
+                }
+                *value++ = 0.5f + fill_sign * channel[c] / range;
+            }
+            *value++ = 0.5f + fill_sign * true_distance / range;
+        }
+    }
+
+    if (!MSDF_CorrectErrors(values, dst->width, dst->rows, 1.001f / range)) {
+        goto done;
+    }
+
+    value = values;
+    for (int row = 0; row < dst->rows; ++row) {
+        Uint8 *dstp = dst->buffer + alignment + row * dst->pitch;
+        for (int col = 0; col < dst->width; ++col) {
+            *dstp++ = MSDF_ToByte(value[2]);
+            *dstp++ = MSDF_ToByte(value[1]);
+            *dstp++ = MSDF_ToByte(value[0]);
+            *dstp++ = MSDF_ToByte(value[3]);
+            value += 4;
+        }
+    }
+    result = true;
+
+done:
+    if (!result) {
+        SDL_free(dst->buffer);
+        dst->buffer = NULL;
+        dst->width = 0;
+        dst->rows = 0;
+    }
+    SDL_free(values);
+    SDL_free(shape.points);
+    SDL_free(shape.edges);
+    SDL_free(shape.contours);
+    return result;
+}
+
+// Box filter weights for resampling one axis of a glyph image
+typedef struct GlyphScaleAxis {
+    int *first;     // First source pixel contributing to each destination pixel
+    int *count;     // Number of contributing source pixels
+    float *weights; // 'stride' normalized weights per destination pixel
+    int stride;
+} GlyphScaleAxis;
+
+static bool Init_GlyphScaleAxis(GlyphScaleAxis *axis, int src_size, int dst_size)
+{
+    const float ratio = (float)src_size / dst_size;
+
+    axis->stride = (int)SDL_ceilf(ratio) + 1;
+    axis->first = (int *)SDL_malloc(2 * dst_size * sizeof(int));
+    axis->weights = (float *)SDL_malloc(dst_size * axis->stride * sizeof(float));
+    if (!axis->first || !axis->weights) {
+        SDL_free(axis->first);
+        SDL_free(axis->weights);
+        return false;
+    }
+    axis->count = axis->first + dst_size;
+
+    for (int i = 0; i < dst_size; ++i) {
+        // Each destination pixel covers [start, end) in source pixels
+        float start = i * ratio;
+        float end = SDL_min((i + 1) * ratio, (float)src_size);
+        int first = (int)start;
+        int last = SDL_min((int)SDL_ceilf(end), src_size);
+        float *weights = &axis->weights[i * axis->stride];
+        float total = 0.0f;
+        int count = 0;
+
+        for (int j = first; j < last && count < axis->stride; ++j) {
+            float weight = SDL_min(end, (float)(j + 1)) - SDL_max(start, (float)j);
+            weights[count++] = weight;
+            total += weight;
+        }
+        for (int j = 0; j < count; ++j) {
+            weights[j] /= total;
+        }
+        axis->first[i] = first;
+        axis->count[i] = count;
+    }
+    return true;
+}
+
+static void Quit_GlyphScaleAxis(GlyphScaleAxis *axis)
+{
+    SDL_free(axis->first);
+    SDL_free(axis->weights);
+}
+
+/* Resample a glyph image with a box filter, averaging the source pixels covered by each
+ * destination pixel. Color glyphs are premultiplied, so the channels can be filtered independently. */
+static bool Scale_GlyphImage(TTF_Image *image, float scale, int bpp, int mono, int alignment)
+{
+    const int src_w = image->width;
+    const int src_h = image->rows;
+    const int dst_w = SDL_max(1, (int)SDL_roundf(src_w * scale));
+    const int dst_h = SDL_max(1, (int)SDL_roundf(src_h * scale));
+    const int dst_pitch = dst_w * bpp + alignment;
+    const int row_size = dst_w * bpp;
+    GlyphScaleAxis x_axis, y_axis;
+    float *rows = NULL;
+    unsigned char *buffer = NULL;
+    bool result = false;
+
+    SDL_zero(x_axis);
+    SDL_zero(y_axis);
+    if (!Init_GlyphScaleAxis(&x_axis, src_w, dst_w) ||
+        !Init_GlyphScaleAxis(&y_axis, src_h, dst_h)) {
+        goto done;
+    }
+
+    // Horizontal pass, one filtered row per source row
+    rows = (float *)SDL_malloc((size_t)src_h * row_size * sizeof(float));
+    if (!rows) {
+        goto done;
+    }
+    for (int y = 0; y < src_h; ++y) {
+        const unsigned char *src = image->buffer + y * image->pitch;
+        float *dst = rows + y * row_size;
+        for (int x = 0; x < dst_w; ++x) {
+            const float *weights = &x_axis.weights[x * x_axis.stride];
+            const unsigned char *srcp = src + x_axis.first[x] * bpp;
+            for (int c = 0; c < bpp; ++c) {
+                float value = 0.0f;
+                for (int i = 0; i < x_axis.count[x]; ++i) {
+                    value += weights[i] * srcp[i * bpp + c];
+                }
+                *dst++ = value;
+            }
+        }
+    }
+
+    // Vertical pass into a new glyph buffer, padded the same way as the original
+    buffer = (unsigned char *)SDL_calloc(1, alignment + (size_t)dst_pitch * dst_h);
+    if (!buffer) {
+        goto done;
+    }
+    for (int y = 0; y < dst_h; ++y) {
+        const float *weights = &y_axis.weights[y * y_axis.stride];
+        const float *src = rows + y_axis.first[y] * row_size;
+        unsigned char *dst = buffer + alignment + y * dst_pitch;
+        for (int x = 0; x < row_size; ++x) {
+            float value = 0.0f;
+            for (int i = 0; i < y_axis.count[y]; ++i) {
+                value += weights[i] * src[i * row_size + x];
+            }
+            if (mono) {
+                dst[x] = (value >= 0.5f) ? 1 : 0;
+            } else {
+                dst[x] = (unsigned char)SDL_min(SDL_roundf(value), 255.0f);
+            }
+        }
+    }
+
+    SDL_free(image->buffer - alignment);
+    image->buffer = buffer + alignment;
+    image->width = dst_w;
+    image->rows = dst_h;
+    image->pitch = dst_pitch;
+    image->left = (int)SDL_roundf(image->left * scale);
+    image->top = (int)SDL_roundf(image->top * scale);
+    result = true;
+
+done:
+    Quit_GlyphScaleAxis(&x_axis);
+    Quit_GlyphScaleAxis(&y_axis);
+    SDL_free(rows);
+    return result;
+}
+
+static bool Load_Glyph(TTF_Font *font, c_glyph *cached, int want, int translation)
+{
+    const int alignment = Get_Alignment() - 1;
+    FT_GlyphSlot slot;
+    FT_Error error;
+
+    int ft_load = FT_LOAD_DEFAULT | font->ft_load_target;
+
+    if (want & CACHED_COLOR) {
+        ft_load |= FT_LOAD_COLOR;
+    }
+
+    if (FT_HAS_SVG(font->face)) {
+        // We won't get metrics unless we add FT_LOAD_COLOR
+        ft_load |= FT_LOAD_COLOR;
+    }
+
+    error = FT_Load_Glyph(font->face, cached->index, ft_load);
+    if (error) {
+        return TTF_SetFTError("FT_Load_Glyph() failed", error);
+    }
+
+    // Get our glyph shortcut
+    slot = font->face->glyph;
+
+    if (want & CACHED_LCD) {
+        if (slot->format == FT_GLYPH_FORMAT_BITMAP) {
+            return SDL_SetError("LCD mode not possible with bitmap font");
+        }
+    }
+
+    // Get the glyph metrics, always needed
+    if (cached->stored == 0) {
+        cached->sz_left  = slot->bitmap_left;
+        cached->sz_top   = slot->bitmap_top;
+        cached->sz_rows  = slot->bitmap.rows;
+        cached->sz_width = slot->bitmap.width;
+
+        /* Current version of freetype is 2.9.1, but on older freetype (2.8.1) this can be 0.
+         * Try to get them from 'FT_Glyph_Metrics' */
+        if (cached->sz_left == 0 && cached->sz_top == 0 && cached->sz_rows == 0 && cached->sz_width == 0) {
+            FT_Glyph_Metrics *metrics = &slot->metrics;
+            if (metrics) {
+                int minx = FT_FLOOR(metrics->horiBearingX);
+                int maxx = FT_CEIL(metrics->horiBearingX + metrics->width);
                 int maxy = FT_FLOOR(metrics->horiBearingY);
                 int miny = maxy - FT_CEIL(metrics->height);
 
@@ -2555,6 +4779,15 @@ static bool Load_Glyph(TTF_Font *font, c_glyph *cached, int want, int translatio
         // All FP 26.6 are 'long' but 'int' should be engouh
         cached->advance  = (int)slot->metrics.horiAdvance; // FP 26.6
 
+        // Bitmap strikes are resampled to the requested size
+        if (font->bitmap_scale > 0.0f) {
+            cached->sz_left  = Scale_BitmapValue(font, cached->sz_left);
+            cached->sz_top   = Scale_BitmapValue(font, cached->sz_top);
+            cached->sz_rows  = Scale_BitmapValue(font, cached->sz_rows);
+            cached->sz_width = Scale_BitmapValue(font, cached->sz_width);
+            cached->advance  = Scale_BitmapValue(font, cached->advance);
+        }
+
         if (font->render_subpixel == 0) {
             // FT KERNING_MODE_SMART
             cached->kerning_smart.rsb_delta = (int)slot->rsb_delta; // FP 26.6
@@ -2562,7 +4795,6 @@ static bool Load_Glyph(TTF_Font *font, c_glyph *cached, int want, int translatio
         } else {
             // FT LCD_MODE_LIGHT_SUBPIXEL
             cached->subpixel.lsb_minus_rsb  = (int)(slot->lsb_delta - slot->rsb_delta); // FP 26.6
-            cached->subpixel.translation    = 0; // FP 26.6
         }
 
 #if defined(DEBUG_FONTS)
@@ -2589,8 +4821,8 @@ static bool Load_Glyph(TTF_Font *font, c_glyph *cached, int want, int translatio
 
         // Adjust for SDF
         if (font->render_sdf) {
-            cached->sz_width += 2 * DEFAULT_SDF_SPREAD;
-            cached->sz_rows  += 2 * DEFAULT_SDF_SPREAD;
+            cached->sz_width += 2 * font->sdf_spread;
+            cached->sz_rows  += 2 * font->sdf_spread;
         }
 
         cached->stored |= CACHED_METRICS;
@@ -2604,6 +4836,8 @@ static bool Load_Glyph(TTF_Font *font, c_glyph *cached, int want, int translatio
        ) {
         const int  mono  = (want & CACHED_BITMAP);
         TTF_Image *dst   = (mono ? &cached->bitmap : &cached->pixmap);
+        int       *stored = &cached->stored;
+        int        shift = 0;
         FT_Glyph   glyph = NULL;
         FT_Bitmap *src;
         FT_Render_Mode ft_render_mode;
@@ -2615,6 +4849,7 @@ static bool Load_Glyph(TTF_Font *font, c_glyph *cached, int want, int translatio
 #if TTF_USE_SDF
             if ((want & CACHED_COLOR) && font->render_sdf) {
                 ft_render_mode = FT_RENDER_MODE_SDF;
+                SetSDFSpread(font->sdf_spread);
             }
 #endif
             if ((want & CACHED_LCD)) {
@@ -2622,11 +4857,12 @@ static bool Load_Glyph(TTF_Font *font, c_glyph *cached, int want, int translatio
             }
         }
 
-        // Subpixel translation, flush previous datas
+        // Subpixel translation, rendered into the glyph's bin for that offset
         if (want & CACHED_SUBPIX) {
-            Flush_Glyph_Image(&cached->pixmap);
+            c_subpixel_glyph *bin = &cached->subpixel_bins[translation / SUBPIXEL_STEP - 1];
+            dst = &bin->pixmap;
+            stored = &bin->stored;
             FT_Outline_Translate(&slot->outline, translation, 0 );
-            cached->subpixel.translation = translation;
         }
 
         // Handle the italic style, only for scalable fonts
@@ -2639,6 +4875,20 @@ static bool Load_Glyph(TTF_Font *font, c_glyph *cached, int want, int translatio
             FT_Outline_Transform(&slot->outline, &shear);
         }
 
+        // Generate a multi-channel distance field from the outline
+        if ((want & CACHED_COLOR) && font->render_msdf && font->outline == 0 && slot->format == FT_GLYPH_FORMAT_OUTLINE) {
+            if (TTF_HANDLE_STYLE_BOLD(font)) {
+                FT_Outline_EmboldenXY(&slot->outline, F26Dot6(font->glyph_overhang), 0);
+            }
+            dst->left = cached->sz_left - font->sdf_spread;
+            dst->top  = cached->sz_top + font->sdf_spread;
+            if (!Render_MSDF(&slot->outline, dst->left, dst->top, cached->sz_width, cached->sz_rows, font->sdf_spread, dst)) {
+                return false;
+            }
+            *stored |= CACHED_COLOR;
+            return true;
+        }
+
         // Render as outline
         if ((font->outline > 0 && slot->format == FT_GLYPH_FORMAT_OUTLINE) ||
             slot->format == FT_GLYPH_FORMAT_BITMAP) {
@@ -2707,6 +4957,14 @@ static bool Load_Glyph(TTF_Font *font, c_glyph *cached, int want, int translatio
             dst->width += font->glyph_overhang;
         }
 
+        /* Keep the translated glyph at the same origin as the untranslated one,
+         * so text engines can place every subpixel variant using the glyph metrics */
+        if ((want & CACHED_SUBPIX) && dst->width > 0 && dst->left > cached->sz_left) {
+            shift = dst->left - cached->sz_left;
+            dst->left -= shift;
+            dst->width += shift;
+        }
+
         // Compute pitch: glyph is padded right to be able to read an 'aligned' size expanding on the right
         dst->pitch = dst->width + alignment;
         if (src->pixel_mode == FT_PIXEL_MODE_BGRA && (want & CACHED_COLOR)) {
@@ -2715,6 +4973,10 @@ static bool Load_Glyph(TTF_Font *font, c_glyph *cached, int want, int translatio
         if (src->pixel_mode == FT_PIXEL_MODE_LCD) {
             dst->pitch += 3 * dst->width;
         }
+        if (shift) {
+            // Shift in bytes
+            shift *= (dst->pitch - alignment) / dst->width;
+        }
 
         if (dst->rows != 0) {
             unsigned int i;
@@ -2741,7 +5003,7 @@ static bool Load_Glyph(TTF_Font *font, c_glyph *cached, int want, int translatio
              * according to the format of embedded bitmap/graymap. */
             for (i = 0; i < (unsigned int)src->rows; i++) {
                 unsigned char *srcp = src->buffer + i * src->pitch;
-                unsigned char *dstp = dst->buffer + i * dst->pitch;
+                unsigned char *dstp = dst->buffer + i * dst->pitch + shift;
                 unsigned int k, quotient, remainder;
 
                 // Decode exactly the needed size from src->width
@@ -2943,6 +5205,17 @@ static bool Load_Glyph(TTF_Font *font, c_glyph *cached, int want, int translatio
 #pragma warning(pop)
 #endif
 
+        // Resample bitmap strikes to the requested size, once when the glyph is cached
+        if (font->bitmap_scale > 0.0f && dst->buffer) {
+            const int bpp = (dst->pitch - alignment) / dst->width;
+            if (!Scale_GlyphImage(dst, font->bitmap_scale, bpp, mono, alignment)) {
+                if (glyph) {
+                    FT_Done_Glyph(glyph);
+                }
+                return false;
+            }
+        }
+
         // Handle the bold style
         if (TTF_HANDLE_STYLE_BOLD(font)) {
             int row;
@@ -2968,136 +5241,386 @@ static bool Load_Glyph(TTF_Font *font, c_glyph *cached, int want, int translatio
             }
         }
 
-        // Shift back
-        if (dst->buffer) {
-            dst->buffer -= alignment;
-        }
+        // Shift back
+        if (dst->buffer) {
+            dst->buffer -= alignment;
+        }
+
+        if (src->pixel_mode == FT_PIXEL_MODE_BGRA && (want & CACHED_COLOR)) {
+            dst->is_color = 1;
+        } else {
+            dst->is_color = 0;
+        }
+
+        // Grayscale and monochrome images use one byte per pixel and compress well
+        if (font->max_hot_images > 0 && dst->buffer && !dst->is_color &&
+            src->pixel_mode != FT_PIXEL_MODE_LCD && dst->pitch == dst->width + alignment) {
+            if (!Compress_GlyphImage(font, dst, alignment)) {
+                if (glyph) {
+                    FT_Done_Glyph(glyph);
+                }
+                return false;
+            }
+        }
+
+        // Mark that we rendered this format
+        if (mono) {
+            *stored |= CACHED_BITMAP;
+        } else if (src->pixel_mode == FT_PIXEL_MODE_LCD) {
+            *stored |= CACHED_LCD;
+        } else {
+            if (want & CACHED_COLOR) {
+                *stored |= CACHED_COLOR;
+                /* Most of the time, glyphs loaded with FT_LOAD_COLOR are non colored, so the cache is
+                   also suitable for Shaded rendering (eg, loaded without FT_LOAD_COLOR) */
+                if (dst->is_color == 0) {
+                    *stored |= CACHED_PIXMAP;
+                }
+            } else {
+                *stored |= CACHED_PIXMAP;
+                // If font has no color information, Shaded/Pixmap cache is also suitable for Blend/Color
+                if (!FT_HAS_COLOR(font->face)) {
+                    *stored |= CACHED_COLOR;
+                }
+            }
+        }
+
+        // Free outlined glyph
+        if (glyph) {
+            FT_Done_Glyph(glyph);
+        }
+    }
+
+    // We're done, this glyph is cached since 'stored' is not 0
+    return true;
+}
+
+static bool Get_GlyphByIndex(TTF_Font *font, FT_UInt idx,
+        int want_bitmap, int want_pixmap, int want_color, int want_lcd, int want_subpixel,
+        int translation, c_glyph **out_glyph, TTF_Image **out_image)
+{
+    c_glyph *glyph = NULL;
+    if (!SDL_FindInHashTable(font->glyphs, (const void *)(uintptr_t)idx, (const void **)&glyph)) {
+        glyph = (c_glyph *)SDL_calloc(1, sizeof(*glyph));
+        if (!glyph) {
+            return false;
+        }
+        glyph->index = idx;
+
+        if (!SDL_InsertIntoHashTable(font->glyphs, (const void *)(uintptr_t)idx, (const void *)glyph, true)) {
+            SDL_free(glyph);
+            return false;
+        }
+    }
+
+    if (out_glyph) {
+        *out_glyph = glyph;
+    }
+
+    if (want_pixmap || want_color || want_lcd) {
+        *out_image = &glyph->pixmap;
+    }
+
+    if (want_bitmap) {
+        *out_image = &glyph->bitmap;
+    }
+
+    if (want_subpixel && FT_IS_SCALABLE(font->face)) {
+        // Each quantized offset is cached in its own bin, bin 0 is the untranslated glyph
+        const int bin = (translation & 63) / SUBPIXEL_STEP;
+        if (bin > 0) {
+            const int want = CACHED_METRICS | want_bitmap | want_pixmap | want_color | want_lcd | want_subpixel;
+            c_subpixel_glyph *subpixel;
+
+            if (!glyph->subpixel_bins) {
+                glyph->subpixel_bins = (c_subpixel_glyph *)SDL_calloc(SUBPIXEL_BINS - 1, sizeof(*glyph->subpixel_bins));
+                if (!glyph->subpixel_bins) {
+                    return false;
+                }
+            }
+            subpixel = &glyph->subpixel_bins[bin - 1];
+            *out_image = &subpixel->pixmap;
+
+            if ((glyph->stored & CACHED_METRICS) &&
+                (subpixel->stored & (want_pixmap | want_color | want_lcd)) == (want_pixmap | want_color | want_lcd)) {
+                return true;
+            }
+
+            // Bins hold a single format, like 'pixmap'
+            if (subpixel->stored) {
+                subpixel->stored = 0;
+                Flush_Glyph_Image(&subpixel->pixmap);
+            }
+            return Load_Glyph(font, glyph, want, bin * SUBPIXEL_STEP);
+        }
+    }
+
+    const int want = CACHED_METRICS | want_bitmap | want_pixmap | want_color | want_lcd;
+
+    // Faster check as it gets inlined
+    if (want_pixmap) {
+        if (glyph->stored & CACHED_PIXMAP) {
+            return true;
+        }
+    } else if (want_bitmap) {
+        if (glyph->stored & CACHED_BITMAP) {
+            return true;
+        }
+    } else if (want_color) {
+        if (glyph->stored & CACHED_COLOR) {
+            return true;
+        }
+    } else if (want_lcd) {
+        if (glyph->stored & CACHED_LCD) {
+            return true;
+        }
+    } else {
+        // Get metrics
+        if (glyph->stored) {
+            return true;
+        }
+    }
+
+    /* Cache cannot contain both PIXMAP and COLOR (unless COLOR is actually not colored) and LCD
+       So, if it's already used, clear it */
+    if (want_color || want_pixmap || want_lcd) {
+        if (glyph->stored & (CACHED_COLOR|CACHED_PIXMAP|CACHED_LCD)) {
+            Flush_Glyph(glyph);
+        }
+    }
+
+    return Load_Glyph(font, glyph, want, 0);
+}
+
+static bool Find_GlyphByIndex(TTF_Font *font, FT_UInt idx,
+        int want_bitmap, int want_pixmap, int want_color, int want_lcd, int want_subpixel,
+        int translation, c_glyph **out_glyph, TTF_Image **out_image)
+{
+    if (!Get_GlyphByIndex(font, idx, want_bitmap, want_pixmap, want_color, want_lcd, want_subpixel, translation, out_glyph, out_image)) {
+        return false;
+    }
+
+    // Compressed images are decompressed on demand
+    if (out_image && *out_image && (*out_image)->compressed) {
+        return Use_GlyphImage(font, *out_image);
+    }
+    return true;
+}
+
+static bool Init_SDFSize(TTF_Font *font)
+{
+    FT_Face face = font->face;
+    FT_Size size = face->size;
+    FT_Error error;
+
+    if (font->sdf_size) {
+        return true;
+    }
+
+    error = FT_New_Size(face, &font->sdf_size);
+    if (error) {
+        font->sdf_size = NULL;
+        return TTF_SetFTError("FT_New_Size() failed", error);
+    }
+
+    error = FT_Activate_Size(font->sdf_size);
+    if (!error) {
+        error = FT_Set_Pixel_Sizes(face, 0, (FT_UInt)font->sdf_reference_size);
+    }
+    FT_Activate_Size(size);
+    if (error) {
+        FT_Done_Size(font->sdf_size);
+        font->sdf_size = NULL;
+        return TTF_SetFTError("Couldn't set SDF reference size", error);
+    }
+    return true;
+}
+
+static bool Load_SDFGlyph(TTF_Font *font, FT_UInt idx, c_sdf_glyph *cached)
+{
+    const int alignment = Get_Alignment() - 1;
+    TTF_Image *dst = &cached->image;
+    FT_Face face = font->face;
+    FT_Size size = face->size;
+    FT_GlyphSlot slot = face->glyph;
+    FT_Error error;
 
-        if (src->pixel_mode == FT_PIXEL_MODE_BGRA && (want & CACHED_COLOR)) {
-            dst->is_color = 1;
-        } else {
-            dst->is_color = 0;
-        }
+    if (!Init_SDFSize(font)) {
+        return false;
+    }
 
-        // Mark that we rendered this format
-        if (mono) {
-            cached->stored |= CACHED_BITMAP;
-        } else if (src->pixel_mode == FT_PIXEL_MODE_LCD) {
-            cached->stored |= CACHED_LCD;
-        } else {
-            if (want & CACHED_COLOR) {
-                cached->stored |= CACHED_COLOR;
-                /* Most of the time, glyphs loaded with FT_LOAD_COLOR are non colored, so the cache is
-                   also suitable for Shaded rendering (eg, loaded without FT_LOAD_COLOR) */
-                if (dst->is_color == 0) {
-                    cached->stored |= CACHED_PIXMAP;
-                }
-            } else {
-                cached->stored |= CACHED_PIXMAP;
-                // If font has no color information, Shaded/Pixmap cache is also suitable for Blend/Color
-                if (!FT_HAS_COLOR(font->face)) {
-                    cached->stored |= CACHED_COLOR;
-                }
+    // Hinting depends on the size, so the reference glyph isn't hinted
+    error = FT_Activate_Size(font->sdf_size);
+    if (!error) {
+        error = FT_Load_Glyph(face, idx, FT_LOAD_NO_HINTING);
+    }
+    if (!error) {
+        cached->left = FT_FLOOR(slot->metrics.horiBearingX);
+        cached->top  = FT_FLOOR(slot->metrics.horiBearingY);
+
+        if (slot->format == FT_GLYPH_FORMAT_OUTLINE) {
+            // Handle the bold style
+            if (TTF_HANDLE_STYLE_BOLD(font)) {
+                FT_Outline_EmboldenXY(&slot->outline, F26Dot6(font->sdf_size->metrics.y_ppem / 10), 0);
+            }
+
+            // Handle the italic style
+            if (TTF_HANDLE_STYLE_ITALIC(font)) {
+                FT_Matrix shear;
+                shear.xx = 1 << 16;
+                shear.xy = GLYPH_ITALICS;
+                shear.yx = 0;
+                shear.yy = 1 << 16;
+                FT_Outline_Transform(&slot->outline, &shear);
             }
         }
 
-        // Free outlined glyph
-        if (glyph) {
-            FT_Done_Glyph(glyph);
+        if (font->render_msdf && slot->format == FT_GLYPH_FORMAT_OUTLINE) {
+            FT_BBox cbox;
+            FT_Outline_Get_CBox(&slot->outline, &cbox);
+            cached->left = FT_FLOOR(cbox.xMin);
+            cached->top  = FT_CEIL(cbox.yMax);
+
+            const int spread = font->sdf_spread;
+            const int width  = FT_CEIL(cbox.xMax) - cached->left + 2 * spread;
+            const int rows   = cached->top - FT_FLOOR(cbox.yMin) + 2 * spread;
+            bool result = Render_MSDF(&slot->outline, cached->left - spread, cached->top + spread, width, rows, spread, dst);
+            FT_Activate_Size(size);
+            return result;
         }
+#if TTF_USE_SDF
+        SetSDFSpread(font->sdf_spread);
+        error = FT_Render_Glyph(slot, FT_RENDER_MODE_SDF);
+#endif
+    }
+    FT_Activate_Size(size);
+    if (error) {
+        return TTF_SetFTError("Couldn't render SDF glyph", error);
+    }
+
+    const FT_Bitmap *src = &slot->bitmap;
+    dst->width    = src->width;
+    dst->rows     = src->rows;
+    dst->pitch    = dst->width + alignment;
+    dst->is_color = 0;
+    dst->buffer   = NULL;
+    if (dst->width == 0 || !src->buffer || src->pixel_mode != FT_PIXEL_MODE_GRAY) {
+        dst->width = 0;
+        dst->rows  = 0;
+        return true;
     }
 
-    // We're done, this glyph is cached since 'stored' is not 0
+    dst->buffer = (unsigned char *)SDL_calloc(1, alignment + dst->pitch * dst->rows);
+    if (!dst->buffer) {
+        return false;
+    }
+    for (int row = 0; row < dst->rows; ++row) {
+        SDL_memcpy(dst->buffer + alignment + row * dst->pitch, src->buffer + row * src->pitch, dst->width);
+    }
     return true;
 }
 
-static bool Find_GlyphByIndex(TTF_Font *font, FT_UInt idx,
-        int want_bitmap, int want_pixmap, int want_color, int want_lcd, int want_subpixel,
-        int translation, c_glyph **out_glyph, TTF_Image **out_image)
+static bool Find_SDFGlyph(TTF_Font *font, FT_UInt idx, c_sdf_glyph **out_glyph)
 {
-    c_glyph *glyph = NULL;
-    if (!SDL_FindInHashTable(font->glyphs, (const void *)(uintptr_t)idx, (const void **)&glyph)) {
-        glyph = (c_glyph *)SDL_calloc(1, sizeof(*glyph));
+    c_sdf_glyph *glyph = NULL;
+
+    if (!font->sdf_glyphs) {
+        font->sdf_glyphs = SDL_CreateHashTable(128, false, SDL_HashID, SDL_KeyMatchID, DestroySDFGlyph, NULL);
+        if (!font->sdf_glyphs) {
+            return false;
+        }
+    }
+
+    if (!SDL_FindInHashTable(font->sdf_glyphs, (const void *)(uintptr_t)idx, (const void **)&glyph)) {
+        glyph = (c_sdf_glyph *)SDL_calloc(1, sizeof(*glyph));
         if (!glyph) {
             return false;
         }
-        glyph->index = idx;
 
-        if (!SDL_InsertIntoHashTable(font->glyphs, (const void *)(uintptr_t)idx, (const void *)glyph, true)) {
+        if (!Load_SDFGlyph(font, idx, glyph) ||
+            !SDL_InsertIntoHashTable(font->sdf_glyphs, (const void *)(uintptr_t)idx, (const void *)glyph, true)) {
+            Flush_Glyph_Image(&glyph->image);
             SDL_free(glyph);
             return false;
         }
     }
 
-    if (out_glyph) {
-        *out_glyph = glyph;
-    }
+    *out_glyph = glyph;
+    return true;
+}
 
-    if (want_pixmap || want_color || want_lcd) {
-        *out_image = &glyph->pixmap;
+// Get the scale from reference SDF glyph images to the current font size
+static bool Get_SDFScale(TTF_Font *font, float *scale_x, float *scale_y)
+{
+    if (!UseReferenceSDF(font)) {
+        *scale_x = 1.0f;
+        *scale_y = 1.0f;
+        return true;
     }
 
-    if (want_bitmap) {
-        *out_image = &glyph->bitmap;
+    if (!Init_SDFSize(font)) {
+        return false;
     }
 
-    if (want_subpixel) {
-        /* Not a real cache, but if it always advances by integer pixels (eg translation 0 or same as previous),
-         * this allows to render as fast as normal mode. */
-        int want = CACHED_METRICS | want_bitmap | want_pixmap | want_color | want_lcd | want_subpixel;
-
-        if (glyph->subpixel.translation == translation) {
-            want &= ~CACHED_SUBPIX;
-        }
+    const FT_Size_Metrics *reference = &font->sdf_size->metrics;
+    const FT_Size_Metrics *current = &font->face->size->metrics;
+    *scale_x = (float)current->x_scale / reference->x_scale;
+    *scale_y = (float)current->y_scale / reference->y_scale;
+    return true;
+}
 
-        if ((glyph->stored & want) == want) {
-            return true;
+// Get the image that text engines use for a glyph, at a subpixel translation in FP 26.6
+static bool Find_GlyphImage(TTF_Font *font, FT_UInt idx, int translation, TTF_Image **out_image, TTF_ImageType *out_image_type)
+{
+    if (UseReferenceSDF(font)) {
+        c_sdf_glyph *glyph;
+        if (!Find_SDFGlyph(font, idx, &glyph)) {
+            return false;
         }
+        *out_image = &glyph->image;
+        *out_image_type = (glyph->image.is_color ? TTF_IMAGE_MSDF : TTF_IMAGE_SDF);
+        return true;
+    }
 
-        if (want_color || want_pixmap || want_lcd) {
-            if (glyph->stored & (CACHED_COLOR|CACHED_PIXMAP|CACHED_LCD)) {
-                Flush_Glyph(glyph);
-            }
+    if (font->render_sdf) {
+        translation = 0;
+    }
+    if (!Find_GlyphByIndex(font, idx, COLOR, (translation ? SUBPIX : 0), translation, NULL, out_image)) {
+        return false;
+    }
+    if ((*out_image)->is_color) {
+        // We can't tell the difference between SDF data and say, color emoji
+        // Hopefully the application sets the right mode on the font.
+        if (font->render_msdf) {
+            *out_image_type = TTF_IMAGE_MSDF;
+        } else if (font->render_sdf) {
+            *out_image_type = TTF_IMAGE_SDF;
+        } else {
+            *out_image_type = TTF_IMAGE_COLOR;
         }
-
-        return Load_Glyph(font, glyph, want, translation);
     } else {
-        const int want = CACHED_METRICS | want_bitmap | want_pixmap | want_color | want_lcd;
+        *out_image_type = TTF_IMAGE_ALPHA;
+    }
+    return true;
+}
 
-        // Faster check as it gets inlined
-        if (want_pixmap) {
-            if (glyph->stored & CACHED_PIXMAP) {
-                return true;
-            }
-        } else if (want_bitmap) {
-            if (glyph->stored & CACHED_BITMAP) {
-                return true;
-            }
-        } else if (want_color) {
-            if (glyph->stored & CACHED_COLOR) {
-                return true;
-            }
-        } else if (want_lcd) {
-            if (glyph->stored & CACHED_LCD) {
-                return true;
-            }
-        } else {
-            // Get metrics
-            if (glyph->stored) {
-                return true;
-            }
-        }
+// Check whether the image that text engines use for a glyph is already rendered
+static bool Has_GlyphImage(TTF_Font *font, FT_UInt idx, int translation)
+{
+    c_glyph *glyph;
 
-        /* Cache cannot contain both PIXMAP and COLOR (unless COLOR is actually not colored) and LCD
-           So, if it's already used, clear it */
-        if (want_color || want_pixmap || want_lcd) {
-            if (glyph->stored & (CACHED_COLOR|CACHED_PIXMAP|CACHED_LCD)) {
-                Flush_Glyph(glyph);
-            }
-        }
+    if (UseReferenceSDF(font)) {
+        return (font->sdf_glyphs && SDL_FindInHashTable(font->sdf_glyphs, (const void *)(uintptr_t)idx, NULL));
+    }
 
-        return Load_Glyph(font, glyph, want, 0);
+    if (!SDL_FindInHashTable(font->glyphs, (const void *)(uintptr_t)idx, (const void **)&glyph)) {
+        return false;
     }
+    if (translation && !font->render_sdf && FT_IS_SCALABLE(font->face)) {
+        const int bin = translation / SUBPIXEL_STEP;
+        return (glyph->subpixel_bins && (glyph->subpixel_bins[bin - 1].stored & CACHED_COLOR));
+    }
+    return ((glyph->stored & CACHED_COLOR) != 0);
 }
 
 static FT_UInt get_char_index(TTF_Font *font, Uint32 ch)
@@ -3134,11 +5657,35 @@ static FT_UInt get_char_index_fallback(TTF_Font *font, Uint32 ch, TTF_Font *init
                 break;
             }
         }
+
+        if (idx == 0 && font == initial_font && font->registry) {
+            TTF_Font *fallback = LoadRegistryFallback(font, ch);
+            if (fallback) {
+                idx = get_char_index_fallback(fallback, ch, initial_font, glyph_font);
+            }
+        }
     }
     return idx;
 }
 
+// Open registry fonts for the characters missing from shaped text, and return whether any were found
+static bool LoadRegistryFallbacks(TTF_Font *font, const char *text, size_t length, const GlyphPositions *positions)
+{
+    bool found = false;
 
+    for (int i = 0; i < positions->len; ++i) {
+        const GlyphPosition *pos = &positions->pos[i];
+        if (pos->index == 0 && (size_t)pos->offset < length) {
+            const char *spot = text + pos->offset;
+            size_t left = length - pos->offset;
+            Uint32 ch = SDL_StepUTF8(&spot, &left);
+            if (get_char_index_fallback(font, ch, NULL, NULL) > 0) {
+                found = true;
+            }
+        }
+    }
+    return found;
+}
 
 static bool Find_GlyphMetrics(TTF_Font *font, Uint32 ch, c_glyph **out_glyph, bool allow_fallback)
 {
@@ -3181,10 +5728,11 @@ SDL_Surface *TTF_GetGlyphImage(TTF_Font *font, Uint32 ch, TTF_ImageType *image_t
     return TTF_GetGlyphImageForIndex(glyph_font, idx, image_type);
 }
 
-SDL_Surface *TTF_GetGlyphImageForIndex(TTF_Font *font, Uint32 glyph_index, TTF_ImageType *image_type)
+static SDL_Surface *Get_GlyphImageSurface(TTF_Font *font, FT_UInt idx, int translation, TTF_ImageType *image_type)
 {
     const int alignment = Get_Alignment() - 1;
     TTF_Image *image;
+    TTF_ImageType type;
     SDL_Surface *surface;
     const Uint8 *src;
 
@@ -3194,7 +5742,7 @@ SDL_Surface *TTF_GetGlyphImageForIndex(TTF_Font *font, Uint32 glyph_index, TTF_I
 
     TTF_CHECK_FONT(font, NULL);
 
-    if (!Find_GlyphByIndex(font, glyph_index, COLOR, 0, 0, NULL, &image)) {
+    if (!Find_GlyphImage(font, idx, translation, &image, &type)) {
         return NULL;
     }
 
@@ -3209,13 +5757,11 @@ SDL_Surface *TTF_GetGlyphImageForIndex(TTF_Font *font, Uint32 glyph_index, TTF_I
 
     src = image->buffer + alignment;
 
-    if (image->is_color) {
-        if (image_type) {
-            // We can't tell the difference between SDF data and say, color emoji
-            // Hopefully the application sets the right mode on the font.
-            *image_type = (font->render_sdf ? TTF_IMAGE_SDF : TTF_IMAGE_COLOR);
-        }
+    if (image_type) {
+        *image_type = type;
+    }
 
+    if (image->is_color) {
         if (surface->pitch == image->pitch) {
             SDL_memcpy(surface->pixels, src, image->rows * image->pitch);
         } else {
@@ -3229,10 +5775,6 @@ SDL_Surface *TTF_GetGlyphImageForIndex(TTF_Font *font, Uint32 glyph_index, TTF_I
             }
         }
     } else {
-        if (image_type) {
-            *image_type = TTF_IMAGE_ALPHA;
-        }
-
         int row, col;
         Uint32 *dst = (Uint32 *)surface->pixels;
         int skip = (surface->pitch - surface->w * 4) / 4;
@@ -3248,6 +5790,94 @@ SDL_Surface *TTF_GetGlyphImageForIndex(TTF_Font *font, Uint32 glyph_index, TTF_I
     return surface;
 }
 
+SDL_Surface *TTF_GetGlyphImageForIndex(TTF_Font *font, Uint32 glyph_index, TTF_ImageType *image_type)
+{
+    return Get_GlyphImageSurface(font, glyph_index, 0, image_type);
+}
+
+SDL_Surface *TTF_GetSubpixelGlyphImageForIndex(TTF_Font *font, Uint32 glyph_index, float offset, TTF_ImageType *image_type)
+{
+    int translation = (int)SDL_floorf(offset * 64.0f + 0.5f);
+    return Get_GlyphImageSurface(font, glyph_index, (SUBPIXEL_ROUND(translation) & 63), image_type);
+}
+
+// Get the quantized subpixel translation in FP 26.6 of a drawing operation
+static int Get_OpTranslation(const TTF_TextData *data, int op_index)
+{
+    if (!data->subpixel_offsets) {
+        return 0;
+    }
+    return (SUBPIXEL_ROUND((int)SDL_floorf(data->subpixel_offsets[op_index] * 64.0f + 0.5f)) & 63);
+}
+
+void TTF_SetGlyphKeys(const TTF_TextData *data, TTF_DrawOperation *ops)
+{
+    if (!data->subpixel_offsets) {
+        return;
+    }
+
+    for (int i = 0; i < data->num_ops; ++i) {
+        if (ops[i].cmd == TTF_DRAW_COMMAND_COPY) {
+            Uint32 bin = (Uint32)Get_OpTranslation(data, i) / SUBPIXEL_STEP;
+            ops[i].copy.glyph_index |= (bin << GLYPH_KEY_BIN_SHIFT);
+        }
+    }
+}
+
+SDL_Surface *TTF_GetGlyphImageForKey(TTF_Font *font, Uint32 glyph_key, TTF_ImageType *image_type)
+{
+    return Get_GlyphImageSurface(font, GLYPH_KEY_INDEX(glyph_key), GLYPH_KEY_BIN(glyph_key) * SUBPIXEL_STEP, image_type);
+}
+
+TTF_GlyphImage *TTF_AcquireGlyphImage(TTF_Font *font, Uint32 glyph_key)
+{
+    TTF_Image *image;
+    TTF_ImageType image_type;
+
+    TTF_CHECK_FONT(font, NULL);
+
+    if (!Find_GlyphImage(font, GLYPH_KEY_INDEX(glyph_key), GLYPH_KEY_BIN(glyph_key) * SUBPIXEL_STEP, &image, &image_type)) {
+        return NULL;
+    }
+
+    if (!image->handle) {
+        TTF_GlyphImage *handle = (TTF_GlyphImage *)SDL_calloc(1, sizeof(*handle));
+        if (!handle) {
+            return NULL;
+        }
+
+        handle->image_type = image_type;
+        handle->is_color = (image->is_color != 0);
+        handle->width = image->width;
+        handle->rows = image->rows;
+        handle->pitch = image->pitch;
+        if (image->buffer) {
+            handle->pixels = image->buffer + (Get_Alignment() - 1);
+        }
+        handle->cached = image;
+        image->handle = handle;
+    }
+    ++image->handle->refcount;
+
+    return image->handle;
+}
+
+void TTF_ReleaseGlyphImage(TTF_GlyphImage *handle)
+{
+    if (!handle) {
+        return;
+    }
+
+    --handle->refcount;
+    if (handle->refcount == 0) {
+        if (handle->cached) {
+            ((TTF_Image *)handle->cached)->handle = NULL;
+        }
+        SDL_free(handle->buffer);
+        SDL_free(handle);
+    }
+}
+
 bool TTF_GetGlyphMetrics(TTF_Font *font, Uint32 ch, int *minx, int *maxx, int *miny, int *maxy, int *advance)
 {
     c_glyph *glyph;
@@ -3306,7 +5936,7 @@ bool TTF_GetGlyphKerning(TTF_Font *font, Uint32 previous_ch, Uint32 ch, int *ker
         }
 
         if (kerning) {
-            *kerning = (int)(delta.x >> 6);
+            *kerning = Scale_BitmapValue(font, delta.x) >> 6;
         }
     }
     return true;
@@ -3369,10 +5999,10 @@ static bool CollectGlyphsFromFont(TTF_Font *font, const char *text, size_t lengt
         GlyphPosition *pos = &positions->pos[i];
         pos->font = font;
         pos->index = hb_glyph_info[i].codepoint;
-        pos->x_advance = hb_glyph_position[i].x_advance + advance_if_bold + font->char_spacing;
-        pos->y_advance = hb_glyph_position[i].y_advance;
-        pos->x_offset = hb_glyph_position[i].x_offset;
-        pos->y_offset = hb_glyph_position[i].y_offset;
+        pos->x_advance = Scale_BitmapValue(font, hb_glyph_position[i].x_advance) + advance_if_bold + font->char_spacing;
+        pos->y_advance = Scale_BitmapValue(font, hb_glyph_position[i].y_advance);
+        pos->x_offset = Scale_BitmapValue(font, hb_glyph_position[i].x_offset);
+        pos->y_offset = Scale_BitmapValue(font, hb_glyph_position[i].y_offset);
         pos->offset = (int)hb_glyph_info[i].cluster;
         if (!Find_GlyphByIndex(font, pos->index, 0, 0, 0, 0, 0, 0, &pos->glyph, NULL)) {
             return SDL_SetError("Couldn't find glyph %u in font", pos->index);
@@ -3434,7 +6064,7 @@ static bool CollectGlyphsFromFont(TTF_Font *font, const char *text, size_t lengt
             if (prev_index && glyph->index) {
                 FT_Vector delta;
                 FT_Get_Kerning(font->face, prev_index, glyph->index, FT_KERNING_UNFITTED, &delta);
-                pos->x_offset += delta.x;
+                pos->x_offset += Scale_BitmapValue(font, delta.x);
             }
             prev_index = glyph->index;
         }
@@ -3540,46 +6170,232 @@ static bool CollectGlyphsWithFallbacks(TTF_Font *font, const char *text, size_t
         return true;
     }
 
-    if (!CollectGlyphsFromFont(font, text, length, direction, script, positions)) {
+    if (!CollectGlyphsFromFont(font, text, length, direction, script, positions)) {
+        return false;
+    }
+
+    // Create spans of missing characters and fill them in from fallback fonts
+    bool complete = false;
+    TTF_FontList *fallback = font->fallbacks;
+    while (!complete && fallback) {
+        complete = true;
+        int start = -1;
+        for (int i = 0; i < positions->len; ++i) {
+            GlyphPosition *pos = &positions->pos[i];
+            if (pos->index == 0) {
+                complete = false;
+                if (start < 0) {
+                    start = i;
+                }
+            } else if (start >= 0) {
+                // Fill in this span with the fallback font
+                int replaced = FillFallbackSpan(fallback->font, text, length, direction, script, positions, initial_font, start, i);
+                if (replaced > 0) {
+                    i = start + replaced;
+                }
+                start = -1;
+            }
+        }
+        if (start >= 0) {
+            // Fill in this span with the fallback font
+            FillFallbackSpan(fallback->font, text, length, direction, script, positions, initial_font, start, positions->len);
+        }
+        fallback = fallback->next;
+    }
+
+    return true;
+}
+
+static Uint32 SDLCALL HashWordRun(void *unused, const void *key)
+{
+    const CachedWordRun *run = (const CachedWordRun *)key;
+    return SDL_murmur3_32(run->text, run->length, (Uint32)run->direction ^ run->script);
+}
+
+static bool SDLCALL KeyMatchWordRun(void *unused, const void *a, const void *b)
+{
+    const CachedWordRun *A = (const CachedWordRun *)a;
+    const CachedWordRun *B = (const CachedWordRun *)b;
+    return (A->direction == B->direction &&
+            A->script == B->script &&
+            A->length == B->length &&
+            SDL_memcmp(A->text, B->text, A->length) == 0);
+}
+
+static void SDLCALL DestroyWordRun(void *unused, const void *key, const void *value)
+{
+    CachedWordRun *run = (CachedWordRun *)key;
+    SDL_free(run->positions.pos);
+    SDL_free(run);
+}
+
+/* Resolve the direction and script that would be used to shape the text,
+ * and return whether it is laid out left to right.
+ */
+static bool IsLeftToRight(TTF_Font *font, const char *text, size_t length, TTF_Direction *direction, Uint32 *script)
+{
+#if TTF_USE_HARFBUZZ
+    if (*direction == TTF_DIRECTION_INVALID || *script == 0) {
+        hb_buffer_t *hb_buffer = hb_buffer_create();
+        if (!hb_buffer) {
+            return false;
+        }
+        hb_buffer_set_language(hb_buffer, font->hb_language);
+        hb_buffer_set_direction(hb_buffer, (hb_direction_t)*direction);
+        hb_buffer_set_script(hb_buffer, hb_script_from_iso15924_tag(*script));
+        hb_buffer_add_utf8(hb_buffer, text, (int)length, 0, -1);
+        hb_buffer_guess_segment_properties(hb_buffer);
+        *direction = (TTF_Direction)hb_buffer_get_direction(hb_buffer);
+        *script = hb_script_to_iso15924_tag(hb_buffer_get_script(hb_buffer));
+        hb_buffer_destroy(hb_buffer);
+    }
+    return (*direction == TTF_DIRECTION_LTR);
+#else
+    return true;
+#endif
+}
+
+static bool UseWordCache(TTF_Font *font, const char *text, size_t length, TTF_Direction *direction, Uint32 *script)
+{
+    if (!font->enable_word_cache) {
+        return false;
+    }
+
+    /* Resolve the direction and script for the whole line, so each word is
+     * shaped the same way the line would have been. Right to left and
+     * vertical runs can't be assembled by simple concatenation.
+     */
+    return IsLeftToRight(font, text, length, direction, script);
+}
+
+static bool GetWordRun(TTF_Font *font, const char *text, size_t length, TTF_Direction direction, Uint32 script, GlyphPositions *scratch, const GlyphPositions **result)
+{
+    if (length > TTF_WORD_CACHE_MAX_RUN_LENGTH) {
+        if (!CollectGlyphsWithFallbacks(font, text, length, direction, script, scratch, NULL)) {
+            return false;
+        }
+        *result = scratch;
+        return true;
+    }
+
+    if (!font->word_runs) {
+        font->word_runs = SDL_CreateHashTable(0, false, HashWordRun, KeyMatchWordRun, DestroyWordRun, NULL);
+        if (!font->word_runs) {
+            return false;
+        }
+    }
+
+    CachedWordRun key;
+    SDL_zero(key);
+    key.direction = direction;
+    key.script = script;
+    key.text = text;
+    key.length = length;
+
+    const CachedWordRun *cached;
+    if (SDL_FindInHashTable(font->word_runs, &key, (const void **)&cached)) {
+        *result = &cached->positions;
+        return true;
+    }
+
+    CachedWordRun *run = (CachedWordRun *)SDL_calloc(1, sizeof(*run) + length);
+    if (!run) {
+        return false;
+    }
+    run->direction = direction;
+    run->script = script;
+    run->text = (const char *)(run + 1);
+    run->length = length;
+    SDL_memcpy(run + 1, text, length);
+
+    if (!CollectGlyphsWithFallbacks(font, text, length, direction, script, &run->positions, NULL)) {
+        DestroyWordRun(NULL, run, NULL);
         return false;
     }
 
-    // Create spans of missing characters and fill them in from fallback fonts
-    bool complete = false;
-    TTF_FontList *fallback = font->fallbacks;
-    while (!complete && fallback) {
-        complete = true;
-        int start = -1;
-        for (int i = 0; i < positions->len; ++i) {
-            GlyphPosition *pos = &positions->pos[i];
-            if (pos->index == 0) {
-                complete = false;
-                if (start < 0) {
-                    start = i;
-                }
-            } else if (start >= 0) {
-                // Fill in this span with the fallback font
-                int replaced = FillFallbackSpan(fallback->font, text, length, direction, script, positions, initial_font, start, i);
-                if (replaced > 0) {
-                    i = start + replaced;
-                }
-                start = -1;
+    if (font->num_word_runs >= TTF_WORD_CACHE_MAX_RUNS) {
+        ClearWordCache(font);
+    }
+    if (!SDL_InsertIntoHashTable(font->word_runs, run, run, false)) {
+        DestroyWordRun(NULL, run, NULL);
+        return false;
+    }
+    ++font->num_word_runs;
+
+    *result = &run->positions;
+    return true;
+}
+
+/* Assemble a line of left to right text from cached runs, each made of a
+ * word and any spaces following it.
+ */
+static bool CollectGlyphsFromWords(TTF_Font *font, const char *text, size_t length, TTF_Direction direction, Uint32 script, GlyphPositions *positions)
+{
+    GlyphPositions scratch;
+    bool result = false;
+
+    SDL_zero(scratch);
+    positions->len = 0;
+
+    size_t start = 0;
+    while (start < length) {
+        size_t end = start;
+        while (end < length && text[end] != ' ') {
+            ++end;
+        }
+        while (end < length && text[end] == ' ') {
+            ++end;
+        }
+
+        const GlyphPositions *run;
+        if (!GetWordRun(font, &text[start], (end - start), direction, script, &scratch, &run)) {
+            goto done;
+        }
+
+        int len = positions->len + run->len;
+        if (len > positions->maxlen) {
+            int maxlen = SDL_max(len, positions->maxlen * 2);
+            GlyphPosition *pos = (GlyphPosition *)SDL_realloc(positions->pos, maxlen * sizeof(*pos));
+            if (!pos) {
+                goto done;
             }
+            positions->pos = pos;
+            positions->maxlen = maxlen;
         }
-        if (start >= 0) {
-            // Fill in this span with the fallback font
-            FillFallbackSpan(fallback->font, text, length, direction, script, positions, initial_font, start, positions->len);
+
+        GlyphPosition *pos = &positions->pos[positions->len];
+        SDL_memcpy(pos, run->pos, run->len * sizeof(*pos));
+        for (int i = 0; i < run->len; ++i) {
+            pos[i].offset += (int)start;
         }
-        fallback = fallback->next;
+        positions->len = len;
+
+        start = end;
     }
+    result = true;
 
-    return true;
+done:
+    SDL_free(scratch.pos);
+    return result;
 }
 
 static bool CollectGlyphs(TTF_Font *font, const char *text, size_t length, TTF_Direction direction, Uint32 script, GlyphPositions *positions)
 {
-    if (!CollectGlyphsWithFallbacks(font, text, length, direction, script, positions, NULL)) {
-        return false;
+    for (bool retried = false; ; retried = true) {
+        if (UseWordCache(font, text, length, &direction, &script)) {
+            if (!CollectGlyphsFromWords(font, text, length, direction, script, positions)) {
+                return false;
+            }
+        } else {
+            if (!CollectGlyphsWithFallbacks(font, text, length, direction, script, positions, NULL)) {
+                return false;
+            }
+        }
+
+        // Shaping only uses fallback fonts that are already open, so shape again if registry fonts have the missing characters
+        if (!font->registry || retried || !LoadRegistryFallbacks(font, text, length, positions)) {
+            break;
+        }
     }
 
     // Calculate the glyph positions and number of clusters
@@ -3673,7 +6489,12 @@ static GlyphPositions *GetCachedGlyphPositions(TTF_Font *font, const char *text,
     return font->positions;
 }
 
-static bool TTF_Size_Internal(TTF_Font *font, const char *text, size_t length, TTF_Direction direction, Uint32 script, int *w, int *h, int *xstart, int *ystart, bool measure_width, int max_width, int *measured_width, size_t *measured_length, bool include_spread)
+/* Calculate the bounds of a run of glyph positions.
+ *
+ * The glyph x positions and offsets are relative to base_x and base_offset,
+ * which allows measuring part of a longer run without copying it.
+ */
+static void GetGlyphPositionsSize(TTF_Font *font, const GlyphPositions *positions, int base_x, int base_offset, int *w, int *h, int *xstart, int *ystart, bool measure_width, int max_width, int *measured_width, size_t *measured_length, bool include_spread)
 {
     int x = 0;
     int pos_x, pos_y;
@@ -3681,38 +6502,12 @@ static bool TTF_Size_Internal(TTF_Font *font, const char *text, size_t length, T
     int miny, maxy;
     int spread_adjustment;
 
-    if (w) {
-        *w = 0;
-    }
-    if (h) {
-        *h = 0;
-    }
-    if (measured_width) {
-        *measured_width = 0;
-    }
-    if (measured_length) {
-        *measured_length = 0;
-    }
-
-    TTF_CHECK_INITIALIZED(false);
-    TTF_CHECK_POINTER("font", font, false);
-    TTF_CHECK_POINTER("text", text, false);
-
-    if (measured_length) {
-        *measured_length = length;
-    }
-
     if (font->render_sdf && !include_spread) {
-        spread_adjustment = DEFAULT_SDF_SPREAD;
+        spread_adjustment = font->sdf_spread;
     } else {
         spread_adjustment = 0;
     }
 
-    GlyphPositions *positions = GetCachedGlyphPositions(font, text, length, direction, script);
-    if (!positions) {
-        return false;
-    }
-
     minx = 0;
     maxx = 0;
     miny = 0;
@@ -3727,14 +6522,14 @@ static bool TTF_Size_Internal(TTF_Font *font, const char *text, size_t length, T
     }
 
     if (positions->len > 0) {
-        if (positions->pos[0].offset == 0) {
+        if (positions->pos[0].offset == base_offset) {
             // Left to right layout
             for (int i = 0; i < positions->len; ++i) {
                 GlyphPosition *pos = &positions->pos[i];
                 c_glyph *glyph = pos->glyph;
 
                 // Compute provisional global bounding box
-                pos_x = FT_FLOOR(pos->x) + glyph->sz_left + spread_adjustment;
+                pos_x = FT_FLOOR(pos->x - base_x) + glyph->sz_left + spread_adjustment;
                 pos_y = FT_FLOOR(pos->y) - glyph->sz_top + spread_adjustment;
 
                 minx = SDL_min(minx, pos_x);
@@ -3758,7 +6553,7 @@ static bool TTF_Size_Internal(TTF_Font *font, const char *text, size_t length, T
                         }
                     } else {
                         if (measured_length) {
-                            *measured_length = (size_t)pos->offset;
+                            *measured_length = (size_t)(pos->offset - base_offset);
                         }
                         break;
                     }
@@ -3773,7 +6568,7 @@ static bool TTF_Size_Internal(TTF_Font *font, const char *text, size_t length, T
                 c_glyph *glyph = pos->glyph;
 
                 // Compute provisional global bounding box
-                pos_x = FT_FLOOR(pos->x) + glyph->sz_left + spread_adjustment;
+                pos_x = FT_FLOOR(pos->x - base_x) + glyph->sz_left + spread_adjustment;
                 pos_y = FT_FLOOR(pos->y) - glyph->sz_top + spread_adjustment;
 
                 minx = SDL_min(minx, pos_x);
@@ -3791,7 +6586,7 @@ static bool TTF_Size_Internal(TTF_Font *font, const char *text, size_t length, T
                         }
                     } else {
                         if (measured_length) {
-                            *measured_length = (size_t)pos->offset;
+                            *measured_length = (size_t)(pos->offset - base_offset);
                         }
                         break;
                     }
@@ -3819,7 +6614,7 @@ static bool TTF_Size_Internal(TTF_Font *font, const char *text, size_t length, T
         *xstart = (minx < 0) ? -minx : 0;
         *xstart += font->outline;
         if (font->render_sdf && include_spread) {
-            *xstart += DEFAULT_SDF_SPREAD;
+            *xstart += font->sdf_spread;
         }
     }
 
@@ -3840,9 +6635,40 @@ static bool TTF_Size_Internal(TTF_Font *font, const char *text, size_t length, T
         *h = (maxy - miny);
         *h += 2 * font->outline;
         if (font->render_sdf && include_spread) {
-            *h += (2 * DEFAULT_SDF_SPREAD);
+            *h += (2 * font->sdf_spread);
         }
     }
+}
+
+static bool TTF_Size_Internal(TTF_Font *font, const char *text, size_t length, TTF_Direction direction, Uint32 script, int *w, int *h, int *xstart, int *ystart, bool measure_width, int max_width, int *measured_width, size_t *measured_length, bool include_spread)
+{
+    if (w) {
+        *w = 0;
+    }
+    if (h) {
+        *h = 0;
+    }
+    if (measured_width) {
+        *measured_width = 0;
+    }
+    if (measured_length) {
+        *measured_length = 0;
+    }
+
+    TTF_CHECK_INITIALIZED(false);
+    TTF_CHECK_POINTER("font", font, false);
+    TTF_CHECK_POINTER("text", text, false);
+
+    if (measured_length) {
+        *measured_length = length;
+    }
+
+    GlyphPositions *positions = GetCachedGlyphPositions(font, text, length, direction, script);
+    if (!positions) {
+        return false;
+    }
+
+    GetGlyphPositionsSize(font, positions, 0, 0, w, h, xstart, ystart, measure_width, max_width, measured_width, measured_length, include_spread);
     return true;
 }
 
@@ -3851,15 +6677,315 @@ bool TTF_GetStringSize(TTF_Font *font, const char *text, size_t length, int *w,
     if (!length && text) {
         length = SDL_strlen(text);
     }
-    return TTF_Size_Internal(font, text, length, font->direction, font->script, w, h, NULL, NULL, NO_MEASUREMENT, true);
-}
+    return TTF_Size_Internal(font, text, length, font->direction, font->script, w, h, NULL, NULL, NO_MEASUREMENT, true);
+}
+
+bool TTF_MeasureString(TTF_Font *font, const char *text, size_t length, int max_width, int *measured_width, size_t *measured_length)
+{
+    if (!length && text) {
+        length = SDL_strlen(text);
+    }
+    return TTF_Size_Internal(font, text, length, font->direction, font->script, NULL, NULL, NULL, NULL, true, max_width, measured_width, measured_length, true);
+}
+
+// Minimum number of unique strings per worker before it's worth spinning up threads
+#define TTF_MEASURE_STRINGS_PER_THREAD  256
+
+typedef struct TTF_MeasureItem
+{
+    const char *text;
+    size_t length;
+    int index;          // Index of the first occurrence in the caller's array
+    int w, h;
+    bool measured;
+} TTF_MeasureItem;
+
+typedef struct TTF_MeasureWorker
+{
+    SDL_Thread *thread;
+    TTF_Font *font;
+    TTF_MeasureItem *items;
+    int num_items;
+    SDL_AtomicInt *next_item;
+} TTF_MeasureWorker;
+
+static int SDLCALL SortMeasureItems(void *userdata, const void *a, const void *b)
+{
+    const TTF_MeasureItem *A = (const TTF_MeasureItem *)a;
+    const TTF_MeasureItem *B = (const TTF_MeasureItem *)b;
+
+    if (A->length != B->length) {
+        return (A->length < B->length) ? -1 : 1;
+    }
+    int result = SDL_memcmp(A->text, B->text, A->length);
+    if (result == 0) {
+        // Keep duplicates in their original order so the first occurrence wins
+        result = (A->index < B->index) ? -1 : 1;
+    }
+    return result;
+}
+
+static bool SameMeasureText(const TTF_MeasureItem *a, const TTF_MeasureItem *b)
+{
+    return (a->length == b->length && SDL_memcmp(a->text, b->text, a->length) == 0);
+}
+
+static int SDLCALL MeasureStringsThread(void *data)
+{
+    TTF_MeasureWorker *worker = (TTF_MeasureWorker *)data;
+    TTF_Font *font = worker->font;
+
+    for ( ; ; ) {
+        int i = SDL_AddAtomicInt(worker->next_item, 1);
+        if (i >= worker->num_items) {
+            break;
+        }
+
+        TTF_MeasureItem *item = &worker->items[i];
+        if (TTF_Size_Internal(font, item->text, item->length, font->direction, font->script, &item->w, &item->h, NULL, NULL, NO_MEASUREMENT, true)) {
+            item->measured = true;
+        }
+    }
+    return 0;
+}
+
+/* Create a private copy of the font for a worker thread.
+ *
+ * The copy reads from its own memory stream over the font data, so the
+ * FreeType face, HarfBuzz font and glyph cache are never shared between
+ * threads.
+ */
+static TTF_Font *CreateMeasureFont(TTF_Font *font, const void *data, size_t datasize)
+{
+    TTF_Font *copy = NULL;
+
+    SDL_IOStream *src = SDL_IOFromConstMem(data, datasize);
+    if (!src) {
+        return NULL;
+    }
+
+    SDL_PropertiesID props = SDL_CreateProperties();
+    if (!props) {
+        SDL_CloseIO(src);
+        return NULL;
+    }
+    SDL_SetPointerProperty(props, TTF_PROP_FONT_CREATE_EXISTING_FONT_POINTER, font);
+    SDL_SetPointerProperty(props, TTF_PROP_FONT_CREATE_IOSTREAM_POINTER, src);
+    SDL_SetBooleanProperty(props, TTF_PROP_FONT_CREATE_IOSTREAM_AUTOCLOSE_BOOLEAN, true);
+    copy = TTF_OpenFontWithProperties(props);
+    SDL_DestroyProperties(props);
+    if (!copy) {
+        return NULL;
+    }
+
+    // Match the settings that affect glyph metrics and shaping
+    copy->outline = 0;
+    if (!TTF_SetFontOutline(copy, font->outline)) {
+        TTF_CloseFont(copy);
+        return NULL;
+    }
+    copy->render_subpixel = font->render_subpixel;
+    copy->char_spacing = font->char_spacing;
+    copy->render_sdf = font->render_sdf;
+    copy->render_msdf = font->render_msdf;
+    copy->sdf_spread = font->sdf_spread;
+    copy->sdf_reference_size = font->sdf_reference_size;
+    copy->direction = font->direction;
+    copy->script = font->script;
+    copy->enable_word_cache = font->enable_word_cache;
+    copy->cache_budget = font->cache_budget;
+#if TTF_USE_HARFBUZZ
+    copy->hb_language = font->hb_language;
+#endif
+    return copy;
+}
+
+static void *LoadFontData(TTF_Font *font, size_t *datasize)
+{
+    Sint64 size = SDL_GetIOSize(font->src) - font->src_offset;
+    if (size <= 0 || (Uint64)size > SDL_SIZE_MAX) {
+        SDL_SetError("Couldn't get font data size");
+        return NULL;
+    }
+
+    void *data = SDL_malloc((size_t)size);
+    if (!data) {
+        return NULL;
+    }
+
+    if (SDL_SeekIO(font->src, font->src_offset, SDL_IO_SEEK_SET) < 0 ||
+        SDL_ReadIO(font->src, data, (size_t)size) != (size_t)size) {
+        SDL_free(data);
+        return NULL;
+    }
+    *datasize = (size_t)size;
+    return data;
+}
+
+static void MeasureStringsThreaded(TTF_Font *font, TTF_MeasureItem *items, int num_items)
+{
+    int num_threads = SDL_min(SDL_GetNumLogicalCPUCores(), num_items / TTF_MEASURE_STRINGS_PER_THREAD);
+    if (num_threads < 2) {
+        return;
+    }
+
+    size_t datasize = 0;
+    void *data = LoadFontData(font, &datasize);
+    if (!data) {
+        return;
+    }
+
+    TTF_MeasureWorker *workers = (TTF_MeasureWorker *)SDL_calloc(num_threads, sizeof(*workers));
+    if (!workers) {
+        SDL_free(data);
+        return;
+    }
+
+    SDL_AtomicInt next_item;
+    SDL_SetAtomicInt(&next_item, 0);
+
+    // Fonts are created and destroyed on this thread, only measurement runs on the workers
+    for (int i = 0; i < num_threads; ++i) {
+        TTF_MeasureWorker *worker = &workers[i];
+        worker->font = CreateMeasureFont(font, data, datasize);
+        if (!worker->font) {
+            break;
+        }
+        worker->items = items;
+        worker->num_items = num_items;
+        worker->next_item = &next_item;
+        worker->thread = SDL_CreateThread(MeasureStringsThread, "TTF_MeasureStrings", worker);
+        if (!worker->thread) {
+            break;
+        }
+    }
+
+    for (int i = 0; i < num_threads; ++i) {
+        TTF_MeasureWorker *worker = &workers[i];
+        if (worker->thread) {
+            SDL_WaitThread(worker->thread, NULL);
+        }
+        if (worker->font) {
+            TTF_CloseFont(worker->font);
+        }
+    }
+    SDL_free(workers);
+    SDL_free(data);
+}
+
+bool TTF_MeasureStrings(TTF_Font *font, const char **strings, const size_t *lengths, int count, int *widths, int *heights, TTF_MeasureFlags flags)
+{
+    TTF_MeasureItem *items;
+    int num_unique;
+    bool result = false;
+
+    TTF_CHECK_INITIALIZED(false);
+    TTF_CHECK_FONT(font, false);
+    TTF_CHECK_POINTER("strings", strings, false);
+
+    if (count <= 0) {
+        return true;
+    }
+
+    items = (TTF_MeasureItem *)SDL_malloc(count * sizeof(*items));
+    if (!items) {
+        return false;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        TTF_MeasureItem *item = &items[i];
+
+        if (!strings[i]) {
+            SDL_InvalidParamError("strings");
+            goto done;
+        }
+        item->text = strings[i];
+        item->length = lengths ? lengths[i] : 0;
+        if (!item->length) {
+            item->length = SDL_strlen(item->text);
+        }
+        item->index = i;
+        item->w = 0;
+        item->h = 0;
+        item->measured = false;
+    }
+
+    // Sort identical strings next to each other and collapse them
+    SDL_qsort_r(items, count, sizeof(*items), SortMeasureItems, NULL);
+    num_unique = 1;
+    for (int i = 1; i < count; ++i) {
+        if (!SameMeasureText(&items[i], &items[num_unique - 1])) {
+            if (i != num_unique) {
+                SDL_copyp(&items[num_unique], &items[i]);
+            }
+            ++num_unique;
+        }
+    }
+
+    if (!(flags & TTF_MEASURE_SINGLE_THREADED) && !font->fallbacks && !font->registry) {
+        // Failing to set up the workers isn't an error, the strings are measured here instead
+        char *error = SDL_strdup(SDL_GetError());
+        MeasureStringsThreaded(font, items, num_unique);
+        if (error) {
+            if (*error) {
+                SDL_SetError("%s", error);
+            } else {
+                SDL_ClearError();
+            }
+            SDL_free(error);
+        }
+    }
+
+    // Measure anything the workers didn't get to, which also reports any errors
+    for (int i = 0; i < num_unique; ++i) {
+        TTF_MeasureItem *item = &items[i];
+        if (!item->measured) {
+            if (!TTF_Size_Internal(font, item->text, item->length, font->direction, font->script, &item->w, &item->h, NULL, NULL, NO_MEASUREMENT, true)) {
+                goto done;
+            }
+            item->measured = true;
+        }
+    }
+
+    // Fill in the results for every string, including duplicates
+    for (int i = 0; i < count; ++i) {
+        size_t length = lengths ? lengths[i] : 0;
+        if (!length) {
+            length = SDL_strlen(strings[i]);
+        }
+
+        TTF_MeasureItem key;
+        key.text = strings[i];
+        key.length = length;
+
+        int lo = 0, hi = num_unique - 1;
+        while (lo < hi) {
+            int mid = lo + (hi - lo) / 2;
+            const TTF_MeasureItem *item = &items[mid];
+            int cmp;
+            if (item->length != key.length) {
+                cmp = (item->length < key.length) ? -1 : 1;
+            } else {
+                cmp = SDL_memcmp(item->text, key.text, key.length);
+            }
+            if (cmp < 0) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        if (widths) {
+            widths[i] = items[lo].w;
+        }
+        if (heights) {
+            heights[i] = items[lo].h;
+        }
+    }
+    result = true;
 
-bool TTF_MeasureString(TTF_Font *font, const char *text, size_t length, int max_width, int *measured_width, size_t *measured_length)
-{
-    if (!length && text) {
-        length = SDL_strlen(text);
-    }
-    return TTF_Size_Internal(font, text, length, font->direction, font->script, NULL, NULL, NULL, NULL, true, max_width, measured_width, measured_length, true);
+done:
+    SDL_free(items);
+    return result;
 }
 
 static SDL_Surface* TTF_Render_Internal(TTF_Font *font, const char *text, size_t length, SDL_Color fg, SDL_Color bg, const render_mode_t render_mode)
@@ -3881,15 +7007,16 @@ static SDL_Surface* TTF_Render_Internal(TTF_Font *font, const char *text, size_t
         goto failure;
     }
 
-#if TTF_USE_SDF
     // Invalid cache if we were using SDF
     if (render_mode != RENDER_BLENDED) {
         if (font->render_sdf) {
+            GlyphCacheConfig prev_config;
+            Get_GlyphCacheConfig(font, &prev_config);
             font->render_sdf = false;
-            Flush_Cache(font);
+            font->render_msdf = false;
+            Switch_GlyphCache(font, &prev_config);
         }
     }
-#endif
 
     // Get the dimensions of the text surface
     if (!TTF_Size_Internal(font, text, length, font->direction, font->script, &width, &height, &xstart, &ystart, NO_MEASUREMENT, true) || !width) {
@@ -4010,7 +7137,226 @@ static bool CharacterIsNewLine(Uint32 c)
     return false;
 }
 
-static bool GetWrappedLines(TTF_Font *font, const char *text, size_t length, TTF_Direction direction, Uint32 script, int xoffset, int wrap_width, bool trim_whitespace, TTF_Line **lines, int *num_lines, int *w, int *h, bool include_spread)
+static void DestroyShapedText(TTF_ShapedText *shaped)
+{
+    SDL_free(shaped->positions.pos);
+    SDL_free(shaped->breaks);
+    SDL_zerop(shaped);
+}
+
+static bool ShapeText(TTF_Font *font, const char *text, size_t length, TTF_Direction direction, Uint32 script, TTF_ShapedText *shaped)
+{
+    GlyphPositions paragraph;
+    GlyphPositions *positions = &shaped->positions;
+    int x = 0;
+    bool result = false;
+
+    DestroyShapedText(shaped);
+    SDL_zero(paragraph);
+
+    size_t start = 0;
+    while (start < length) {
+        size_t end = start;
+        while (end < length && text[end] != '\n') {
+            ++end;
+        }
+        if (end < length) {
+            // Include the newline in the paragraph, it's part of the measured text
+            ++end;
+        }
+
+        TTF_Direction paragraph_direction = direction;
+        Uint32 paragraph_script = script;
+        if (!IsLeftToRight(font, &text[start], (end - start), &paragraph_direction, &paragraph_script)) {
+            // Lines of right to left text have to be shaped separately
+            DestroyShapedText(shaped);
+            result = true;
+            goto done;
+        }
+
+        if (!CollectGlyphs(font, &text[start], (end - start), paragraph_direction, paragraph_script, &paragraph)) {
+            goto done;
+        }
+
+        int len = positions->len + paragraph.len;
+        if (len > positions->maxlen) {
+            int maxlen = SDL_max(len, positions->maxlen * 2);
+            GlyphPosition *pos = (GlyphPosition *)SDL_realloc(positions->pos, maxlen * sizeof(*pos));
+            if (!pos) {
+                goto done;
+            }
+            positions->pos = pos;
+            positions->maxlen = maxlen;
+        }
+
+        GlyphPosition *pos = &positions->pos[positions->len];
+        SDL_memcpy(pos, paragraph.pos, paragraph.len * sizeof(*pos));
+        for (int i = 0; i < paragraph.len; ++i) {
+            pos[i].x += x;
+            pos[i].offset += (int)start;
+        }
+        positions->len = len;
+        positions->num_clusters += paragraph.num_clusters;
+        x += paragraph.width26dot6;
+
+        start = end;
+    }
+    positions->width26dot6 = x;
+
+    // Build the table of break opportunities
+    int max_breaks = 0;
+    for (size_t i = 0; i < length; ++i) {
+        if (CharacterIsDelimiter((Uint8)text[i])) {
+            ++max_breaks;
+        }
+    }
+    if (max_breaks > 0) {
+        shaped->breaks = (TTF_BreakOpportunity *)SDL_malloc(max_breaks * sizeof(*shaped->breaks));
+        if (!shaped->breaks) {
+            goto done;
+        }
+        for (size_t i = 0; i < length; ++i) {
+            char c = text[i];
+            if (CharacterIsDelimiter((Uint8)c)) {
+                TTF_BreakOpportunity *brk = &shaped->breaks[shaped->num_breaks++];
+                brk->offset = (int)(i + 1);
+                brk->newline = CharacterIsNewLine((Uint8)c);
+                brk->hard = (c == '\n' || (c == '\r' && (i + 1 == length || text[i + 1] != '\n')));
+            }
+        }
+    }
+    shaped->rewrappable = true;
+    result = true;
+
+done:
+    if (result) {
+        shaped->font = font;
+        shaped->generation = font->generation;
+        shaped->direction = direction;
+        shaped->script = script;
+    } else {
+        DestroyShapedText(shaped);
+    }
+    SDL_free(paragraph.pos);
+    return result;
+}
+
+// Find the first glyph at or after a byte offset in the text
+static int FindShapedGlyph(const TTF_ShapedText *shaped, int offset)
+{
+    int lo = 0, hi = shaped->positions.len;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (shaped->positions.pos[mid].offset < offset) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// Find the first break opportunity after a byte offset in the text
+static int FindShapedBreak(const TTF_ShapedText *shaped, int offset)
+{
+    int lo = 0, hi = shaped->num_breaks;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (shaped->breaks[mid].offset <= offset) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static int GetShapedPen(const TTF_ShapedText *shaped, int index)
+{
+    if (index < shaped->positions.len) {
+        const GlyphPosition *pos = &shaped->positions.pos[index];
+        return pos->x - pos->x_offset;
+    }
+    return shaped->positions.width26dot6;
+}
+
+static void GetShapedSlice(const TTF_ShapedText *shaped, int start, int end, GlyphPositions *slice, int *base_x)
+{
+    int first = FindShapedGlyph(shaped, start);
+    int last = FindShapedGlyph(shaped, end);
+
+    SDL_zerop(slice);
+    slice->pos = &shaped->positions.pos[first];
+    slice->len = (last - first);
+    *base_x = GetShapedPen(shaped, first);
+    slice->width26dot6 = GetShapedPen(shaped, last) - *base_x;
+}
+
+// Equivalent to TTF_Size_Internal() on part of the shaped text
+static void GetShapedTextSize(TTF_Font *font, const TTF_ShapedText *shaped, int start, int end, int *w, int *h, int *xstart, int *ystart, bool measure_width, int max_width, int *measured_width, size_t *measured_length, bool include_spread)
+{
+    GlyphPositions slice;
+    int base_x;
+
+    if (w) {
+        *w = 0;
+    }
+    if (h) {
+        *h = 0;
+    }
+    if (measured_width) {
+        *measured_width = 0;
+    }
+
+    GetShapedSlice(shaped, start, end, &slice, &base_x);
+
+    // Characters without glyphs, like a byte order mark, may be skipped at the start
+    int base_offset = (slice.len > 0) ? slice.pos[0].offset : start;
+    if (measured_length) {
+        *measured_length = (size_t)(end - base_offset);
+    }
+    GetGlyphPositionsSize(font, &slice, base_x, base_offset, w, h, xstart, ystart, measure_width, max_width, measured_width, measured_length, include_spread);
+    if (measured_length) {
+        *measured_length += (size_t)(base_offset - start);
+    }
+}
+
+// Copy a line of the shaped text, with positions and offsets relative to the line
+static bool GetShapedLine(const TTF_ShapedText *shaped, int start, int end, GlyphPositions *line)
+{
+    GlyphPositions slice;
+    int base_x;
+
+    GetShapedSlice(shaped, start, end, &slice, &base_x);
+
+    if (slice.len > line->maxlen) {
+        GlyphPosition *pos = (GlyphPosition *)SDL_realloc(line->pos, slice.len * sizeof(*pos));
+        if (!pos) {
+            return false;
+        }
+        line->pos = pos;
+        line->maxlen = slice.len;
+    }
+    line->len = slice.len;
+    line->width26dot6 = slice.width26dot6;
+    line->height26dot6 = 0;
+    line->num_clusters = 0;
+
+    int last_offset = -1;
+    for (int i = 0; i < slice.len; ++i) {
+        GlyphPosition *pos = &line->pos[i];
+        SDL_copyp(pos, &slice.pos[i]);
+        pos->x -= base_x;
+        pos->offset -= start;
+        if (pos->offset != last_offset) {
+            ++line->num_clusters;
+            last_offset = pos->offset;
+        }
+    }
+    return true;
+}
+
+static bool GetWrappedLines(TTF_Font *font, const char *text, size_t length, TTF_Direction direction, Uint32 script, const TTF_ShapedText *shaped, int xoffset, int wrap_width, bool trim_whitespace, TTF_Line **lines, int *num_lines, int *w, int *h, bool include_spread)
 {
     int width, height;
     int i, numLines = 0, rowHeight;
@@ -4036,7 +7382,12 @@ static bool GetWrappedLines(TTF_Font *font, const char *text, size_t length, TTF
     }
 
     // Get the dimensions of the text surface
-    if (!TTF_Size_Internal(font, text, length, direction, script, &width, &height, NULL, NULL, NO_MEASUREMENT, include_spread) || !width) {
+    if (shaped) {
+        GetShapedTextSize(font, shaped, 0, (int)length, &width, &height, NULL, NULL, NO_MEASUREMENT, include_spread);
+        if (!width) {
+            return SDL_SetError("Text has zero width");
+        }
+    } else if (!TTF_Size_Internal(font, text, length, direction, script, &width, &height, NULL, NULL, NO_MEASUREMENT, include_spread) || !width) {
         return SDL_SetError("Text has zero width");
     }
 
@@ -4084,6 +7435,7 @@ static bool GetWrappedLines(TTF_Font *font, const char *text, size_t length, TTF
             }
             strLines[numLines].text = spot;
             strLines[numLines].length = left;
+            strLines[numLines].measured = false;
             ++numLines;
 
             int max_width = wrap_width;
@@ -4091,7 +7443,9 @@ static bool GetWrappedLines(TTF_Font *font, const char *text, size_t length, TTF
                 max_width = SDL_max(max_width - xoffset, 1);
             }
             size_t max_length = 0;
-            if (!TTF_Size_Internal(font, spot, left, direction, script, NULL, NULL, NULL, NULL, true, max_width, NULL, &max_length, include_spread)) {
+            if (shaped) {
+                GetShapedTextSize(font, shaped, (int)(spot - text), (int)length, NULL, NULL, NULL, NULL, true, max_width, NULL, &max_length, include_spread);
+            } else if (!TTF_Size_Internal(font, spot, left, direction, script, NULL, NULL, NULL, NULL, true, max_width, NULL, &max_length, include_spread)) {
                 SDL_SetError("Error measure text");
                 goto done;
             }
@@ -4106,24 +7460,55 @@ static bool GetWrappedLines(TTF_Font *font, const char *text, size_t length, TTF
             }
 
             const char *end = spot + max_length;
-            while (spot < end) {
-                int is_delim;
-                Uint32 c = SDL_StepUTF8(&spot, &left);
-
-                if (c == UNICODE_BOM_NATIVE || c == UNICODE_BOM_SWAPPED) {
-                    continue;
+            if (shaped) {
+                // Look up the delimiters in this line instead of scanning for them
+                bool hard_break = false;
+                for (int b = FindShapedBreak(shaped, (int)(spot - text)); b < shaped->num_breaks; ++b) {
+                    const TTF_BreakOpportunity *brk = &shaped->breaks[b];
+                    if (text + brk->offset - 1 >= end) {
+                        break;
+                    }
+                    if (wrap_width > 0 || brk->newline) {
+                        save_text = text + brk->offset;
+                        save_length = length - brk->offset;
+                        if (brk->hard) {
+                            hard_break = true;
+                            break;
+                        }
+                    }
+                }
+                if (hard_break) {
+                    spot = save_text;
+                    left = save_length;
+                } else {
+                    left -= (end - spot);
+                    spot = end;
+                    // Finish the last character, in case the line was cut inside of it
+                    while (left > 0 && (*spot & 0xC0) == 0x80) {
+                        ++spot;
+                        --left;
+                    }
                 }
+            } else {
+                while (spot < end) {
+                    int is_delim;
+                    Uint32 c = SDL_StepUTF8(&spot, &left);
+
+                    if (c == UNICODE_BOM_NATIVE || c == UNICODE_BOM_SWAPPED) {
+                        continue;
+                    }
 
-                // With wrap_width == 0, normal text rendering but newline aware
-                is_delim = (wrap_width > 0) ? CharacterIsDelimiter(c) : CharacterIsNewLine(c);
+                    // With wrap_width == 0, normal text rendering but newline aware
+                    is_delim = (wrap_width > 0) ? CharacterIsDelimiter(c) : CharacterIsNewLine(c);
 
-                // Record last delimiter position
-                if (is_delim) {
-                    save_text = spot;
-                    save_length = left;
-                    // Break, if new line
-                    if (c == '\n' || (c == '\r' && *spot != '\n')) {
-                        break;
+                    // Record last delimiter position
+                    if (is_delim) {
+                        save_text = spot;
+                        save_length = left;
+                        // Break, if new line
+                        if (c == '\n' || (c == '\r' && *spot != '\n')) {
+                            break;
+                        }
                     }
                 }
             }
@@ -4174,7 +7559,11 @@ static bool GetWrappedLines(TTF_Font *font, const char *text, size_t length, TTF
             for (i = 0; i < numLines; i++) {
                 int w_tmp, h_tmp;
 
-                if (TTF_Size_Internal(font, strLines[i].text, strLines[i].length, font->direction, font->script, &w_tmp, &h_tmp, NULL, NULL, NO_MEASUREMENT, include_spread)) {
+                if (shaped) {
+                    int start = (int)(strLines[i].text - text);
+                    GetShapedTextSize(font, shaped, start, start + (int)strLines[i].length, &w_tmp, &h_tmp, NULL, NULL, NO_MEASUREMENT, include_spread);
+                    width = SDL_max(w_tmp, width);
+                } else if (TTF_Size_Internal(font, strLines[i].text, strLines[i].length, font->direction, font->script, &w_tmp, &h_tmp, NULL, NULL, NO_MEASUREMENT, include_spread)) {
                     width = SDL_max(w_tmp, width);
                 }
             }
@@ -4217,7 +7606,7 @@ done:
 
 bool TTF_GetStringSizeWrapped(TTF_Font *font, const char *text, size_t length, int wrap_width, int *w, int *h)
 {
-    return GetWrappedLines(font, text, length, font->direction, font->script, 0, wrap_width, true, NULL, NULL, w, h, true);
+    return GetWrappedLines(font, text, length, font->direction, font->script, NULL, 0, wrap_width, true, NULL, NULL, w, h, true);
 }
 
 static SDL_Surface* TTF_Render_Wrapped_Internal(TTF_Font *font, const char *text, size_t length, SDL_Color fg, SDL_Color bg, int wrap_width, const render_mode_t render_mode)
@@ -4228,7 +7617,7 @@ static SDL_Surface* TTF_Render_Wrapped_Internal(TTF_Font *font, const char *text
     int i, numLines = 0;
     TTF_Line *strLines = NULL;
 
-    if (!GetWrappedLines(font, text, length, font->direction, font->script, 0, wrap_width, true, &strLines, &numLines, &width, &height, true)) {
+    if (!GetWrappedLines(font, text, length, font->direction, font->script, NULL, 0, wrap_width, true, &strLines, &numLines, &width, &height, true)) {
         return NULL;
     }
 
@@ -4327,16 +7716,6 @@ SDL_Surface* TTF_RenderText_LCD_Wrapped(TTF_Font *font, const char *text, size_t
     return TTF_Render_Wrapped_Internal(font, text, length, fg, bg, wrap_width, RENDER_LCD);
 }
 
-struct TTF_TextLayout
-{
-    TTF_Direction direction;
-    Uint32 script; // ISO 15924 script tag
-    int font_height;
-    int wrap_length;
-    bool wrap_whitespace_visible;
-    int *lines;
-};
-
 typedef struct TTF_InternalText
 {
     TTF_Text text;
@@ -4379,6 +7758,8 @@ TTF_Text *TTF_CreateText(TTF_TextEngine *engine, TTF_Font *font, const char *tex
         }
         SDL_memcpy(result->text, text, length);
         result->text[length] = '\0';
+        result->internal->layout->text_length = length;
+        result->internal->layout->text_capacity = length + 1;
     }
 
     if (font) {
@@ -4387,6 +7768,47 @@ TTF_Text *TTF_CreateText(TTF_TextEngine *engine, TTF_Font *font, const char *tex
     return result;
 }
 
+static void SetSharedLayout(TTF_Text *text, TTF_SharedLayout *shared);
+
+TTF_Text *TTF_CloneText(TTF_Text *text)
+{
+    TTF_CHECK_POINTER("text", text, NULL);
+
+    TTF_TextData *src = text->internal;
+    TTF_Text *result = TTF_CreateText(src->engine, src->font, text->text, src->layout->text_length);
+    if (!result) {
+        return NULL;
+    }
+
+    TTF_TextData *dst = result->internal;
+    if (src->props) {
+        dst->props = SDL_CreateProperties();
+        if (!dst->props || !SDL_CopyProperties(src->props, dst->props)) {
+            TTF_DestroyText(result);
+            return NULL;
+        }
+    }
+    SDL_copyp(&dst->color, &src->color);
+    dst->x = src->x;
+    dst->y = src->y;
+    dst->layout->direction = src->layout->direction;
+    dst->layout->script = src->layout->script;
+    dst->layout->wrap_length = src->layout->wrap_length;
+    dst->layout->wrap_whitespace_visible = src->layout->wrap_whitespace_visible;
+    dst->layout->incremental_glyphs = src->layout->incremental_glyphs;
+    dst->layout->has_viewport = src->layout->has_viewport;
+    SDL_copyp(&dst->layout->viewport, &src->layout->viewport);
+
+    if (!src->needs_layout_update && !src->layout->needs_viewport_update && src->layout->shared) {
+        // Share the layout instead of laying out the text again
+        SetSharedLayout(result, src->layout->shared);
+        dst->needs_layout_update = false;
+        dst->needs_engine_update = true;
+        dst->layout->num_ready_glyphs = -1;
+    }
+    return result;
+}
+
 static int SDLCALL SortClusters(const void *a, const void *b)
 {
     TTF_SubString *A = (TTF_SubString *)a;
@@ -4471,24 +7893,263 @@ static int CalculateClusterLengths(TTF_Text *text, TTF_SubString *clusters, int
             }
         }
 
-        if (i < (num_clusters - 1)) {
-            cluster->length = clusters[i + 1].offset - cluster->offset;
-        } else {
-            SDL_assert(cluster->flags & TTF_SUBSTRING_TEXT_END);
-            SDL_assert(cluster->offset == (int)length);
-        }
-        last = cluster;
+        if (i < (num_clusters - 1)) {
+            cluster->length = clusters[i + 1].offset - cluster->offset;
+        } else {
+            SDL_assert(cluster->flags & TTF_SUBSTRING_TEXT_END);
+            SDL_assert(cluster->offset == (int)length);
+        }
+        last = cluster;
+    }
+    return cluster_index;
+}
+
+static TTF_SubStringFlags GetPreviousClusterDirection(TTF_SubString *clusters, int num_clusters, TTF_Direction direction)
+{
+    if (num_clusters > 1) {
+        return (clusters[num_clusters - 1].flags & TTF_SUBSTRING_DIRECTION_MASK);
+    } else {
+        return (TTF_SubStringFlags)direction;
+    }
+}
+
+// Get the size of a line that isn't laid out, it's measured once per line index
+static bool MeasureWrappedLine(TTF_Text *text, const TTF_ShapedText *shaped, TTF_Line *line, TTF_Direction direction, Uint32 script)
+{
+    TTF_Font *font = text->internal->font;
+
+    if (line->measured) {
+        return true;
+    }
+
+    if (shaped) {
+        int start = (int)(line->text - text->text);
+        GetShapedTextSize(font, shaped, start, start + (int)line->length, &line->width, NULL, &line->xstart, &line->ystart, NO_MEASUREMENT, false);
+    } else if (!TTF_Size_Internal(font, line->text, line->length, direction, script, &line->width, NULL, &line->xstart, &line->ystart, NO_MEASUREMENT, false)) {
+        return false;
+    }
+    line->measured = true;
+    return true;
+}
+
+// Get the range of lines intersecting the viewport, extended by margin pixels above and below
+static void GetViewportLines(TTF_Text *text, int num_lines, int margin, int *first_line, int *last_line)
+{
+    const TTF_TextLayout *layout = text->internal->layout;
+    const int lineskip = SDL_max(text->internal->font->lineskip, 1);
+    const int top = layout->viewport.y - text->internal->y - margin;
+    const int bottom = layout->viewport.y + layout->viewport.h - text->internal->y + margin;
+
+    if (!layout->has_viewport) {
+        *first_line = 0;
+        *last_line = num_lines;
+        return;
+    }
+
+    *first_line = SDL_clamp((top < 0 ? 0 : top / lineskip), 0, num_lines);
+    *last_line = SDL_clamp((bottom <= 0 ? 0 : (bottom + lineskip - 1) / lineskip), *first_line, num_lines);
+}
+
+/* The results of laying out a text, shared by the text objects with the same content.
+ * They are never modified once shared, a text that changes gets a new layout instead. */
+struct TTF_SharedLayout
+{
+    // The content of the text, used as the key
+    TTF_Font *font;
+    Uint32 generation;
+    char *text;
+    size_t length;
+    int x;
+    int y;
+    int wrap_length;
+    bool wrap_whitespace_visible;
+    TTF_Direction direction;
+    Uint32 script;
+
+    // The layout of the text
+    int refcount;
+    int num_lines;
+    int w;
+    int h;
+    int num_ops;
+    TTF_DrawOperation *ops;
+    float *subpixel_offsets;
+    int num_clusters;
+    TTF_SubString *clusters;
+    int *lines;
+};
+
+static Uint32 SDLCALL HashSharedLayout(void *unused, const void *key)
+{
+    const TTF_SharedLayout *shared = (const TTF_SharedLayout *)key;
+    return SDL_murmur3_32(shared->text, shared->length, (Uint32)shared->wrap_length ^ (Uint32)shared->x ^ ((Uint32)shared->y << 16));
+}
+
+static bool SDLCALL KeyMatchSharedLayout(void *unused, const void *a, const void *b)
+{
+    const TTF_SharedLayout *A = (const TTF_SharedLayout *)a;
+    const TTF_SharedLayout *B = (const TTF_SharedLayout *)b;
+    return (A->generation == B->generation &&
+            A->x == B->x &&
+            A->y == B->y &&
+            A->wrap_length == B->wrap_length &&
+            A->wrap_whitespace_visible == B->wrap_whitespace_visible &&
+            A->direction == B->direction &&
+            A->script == B->script &&
+            A->length == B->length &&
+            SDL_memcmp(A->text, B->text, A->length) == 0);
+}
+
+static void GetSharedLayoutKey(TTF_Text *text, TTF_SharedLayout *key)
+{
+    SDL_zerop(key);
+    key->font = text->internal->font;
+    key->generation = key->font->generation;
+    key->text = text->text;
+    key->length = text->internal->layout->text_length;
+    key->x = text->internal->x;
+    key->y = text->internal->y;
+    key->wrap_length = text->internal->layout->wrap_length;
+    key->wrap_whitespace_visible = text->internal->layout->wrap_whitespace_visible;
+    key->direction = TTF_GetTextDirection(text);
+    key->script = TTF_GetTextScript(text);
+}
+
+static void SetSharedLayout(TTF_Text *text, TTF_SharedLayout *shared)
+{
+    ++shared->refcount;
+
+    text->internal->layout->shared = shared;
+    text->num_lines = shared->num_lines;
+    text->internal->w = shared->w;
+    text->internal->h = shared->h;
+    text->internal->num_ops = shared->num_ops;
+    text->internal->ops = shared->ops;
+    text->internal->subpixel_offsets = shared->subpixel_offsets;
+    text->internal->num_clusters = shared->num_clusters;
+    text->internal->clusters = shared->clusters;
+    text->internal->layout->lines = shared->lines;
+}
+
+static bool SDLCALL DetachSharedLayoutCallback(void *userdata, const SDL_HashTable *table, const void *key, const void *value)
+{
+    TTF_SharedLayout *shared = (TTF_SharedLayout *)value;
+    shared->font = NULL;
+    return true;
+}
+
+// Stop sharing the current layouts with new text, the text already using them keeps them
+static void DetachSharedLayouts(TTF_Font *font)
+{
+    if (font->shared_layouts) {
+        SDL_IterateHashTable(font->shared_layouts, DetachSharedLayoutCallback, NULL);
+        SDL_ClearHashTable(font->shared_layouts);
+    }
+}
+
+// Use the layout of another text object with the same content, if there is one
+static bool AcquireSharedLayout(TTF_Text *text)
+{
+    TTF_Font *font = text->internal->font;
+    TTF_SharedLayout key, *shared;
+
+    if (!font->shared_layouts || text->internal->layout->has_viewport) {
+        return false;
+    }
+
+    GetSharedLayoutKey(text, &key);
+    if (!SDL_FindInHashTable(font->shared_layouts, &key, (const void **)&shared)) {
+        return false;
+    }
+    SetSharedLayout(text, shared);
+    return true;
+}
+
+// Make the layout of a text object available to other text objects with the same content
+static void ShareTextLayout(TTF_Text *text)
+{
+    TTF_Font *font = text->internal->font;
+    TTF_SharedLayout *shared;
+
+    if (text->internal->layout->has_viewport) {
+        // The layout depends on the viewport
+        return;
+    }
+
+    if (!font->shared_layouts) {
+        font->shared_layouts = SDL_CreateHashTable(0, false, HashSharedLayout, KeyMatchSharedLayout, NULL, NULL);
+        if (!font->shared_layouts) {
+            return;
+        }
+    }
+
+    shared = (TTF_SharedLayout *)SDL_malloc(sizeof(*shared));
+    if (!shared) {
+        return;
+    }
+    GetSharedLayoutKey(text, shared);
+    shared->text = (char *)SDL_malloc(shared->length);
+    if (!shared->text) {
+        SDL_free(shared);
+        return;
+    }
+    SDL_memcpy(shared->text, text->text, shared->length);
+    shared->refcount = 0;
+    shared->num_lines = text->num_lines;
+    shared->w = text->internal->w;
+    shared->h = text->internal->h;
+    shared->num_ops = text->internal->num_ops;
+    shared->ops = text->internal->ops;
+    shared->subpixel_offsets = text->internal->subpixel_offsets;
+    shared->num_clusters = text->internal->num_clusters;
+    shared->clusters = text->internal->clusters;
+    shared->lines = text->internal->layout->lines;
+
+    if (!SDL_InsertIntoHashTable(font->shared_layouts, shared, shared, false)) {
+        SDL_free(shared->text);
+        SDL_free(shared);
+        return;
+    }
+    SetSharedLayout(text, shared);
+}
+
+static void ReleaseSharedLayout(TTF_SharedLayout *shared)
+{
+    if (--shared->refcount > 0) {
+        return;
     }
-    return cluster_index;
+
+    if (shared->font) {
+        SDL_RemoveFromHashTable(shared->font->shared_layouts, shared);
+    }
+    SDL_free(shared->ops);
+    SDL_free(shared->subpixel_offsets);
+    SDL_free(shared->clusters);
+    SDL_free(shared->lines);
+    SDL_free(shared->text);
+    SDL_free(shared);
 }
 
-static TTF_SubStringFlags GetPreviousClusterDirection(TTF_SubString *clusters, int num_clusters, TTF_Direction direction)
+// Free the results of laying out a text object
+static void DestroyTextLayout(TTF_Text *text)
 {
-    if (num_clusters > 1) {
-        return (clusters[num_clusters - 1].flags & TTF_SUBSTRING_DIRECTION_MASK);
+    TTF_TextData *data = text->internal;
+
+    if (data->layout->shared) {
+        ReleaseSharedLayout(data->layout->shared);
+        data->layout->shared = NULL;
     } else {
-        return (TTF_SubStringFlags)direction;
+        SDL_free(data->ops);
+        SDL_free(data->subpixel_offsets);
+        SDL_free(data->clusters);
+        SDL_free(data->layout->lines);
     }
+    data->ops = NULL;
+    data->num_ops = 0;
+    data->subpixel_offsets = NULL;
+    data->clusters = NULL;
+    data->num_clusters = 0;
+    data->layout->lines = NULL;
 }
 
 static bool LayoutText(TTF_Text *text)
@@ -4496,22 +8157,54 @@ static bool LayoutText(TTF_Text *text)
     TTF_Font *font = text->internal->font;
     int wrap_width = text->internal->layout->wrap_length;
     bool trim_whitespace = !text->internal->layout->wrap_whitespace_visible;
-    size_t length = SDL_strlen(text->text);
+    size_t length = text->internal->layout->text_length;
     int i, width = 0, height = 0, numLines = 0;
     TTF_Line *strLines = NULL;
     TTF_DrawOperation *ops = NULL, *new_ops;
+    float *subpixel_offsets = NULL, *new_subpixel_offsets;
     int num_ops = 0, max_ops = 0, extra_ops = 0, additional_ops;
     TTF_SubString *clusters = NULL, *new_clusters, *cluster;
     int num_clusters = 0, max_clusters = 0, cluster_offset;
     int *lines = NULL;
+    int first_line, last_line;
     bool result = false;
     TTF_Direction direction = TTF_GetTextDirection(text);
     Uint32 script = TTF_GetTextScript(text);
+    TTF_TextLayout *layout = text->internal->layout;
+    TTF_ShapedText *shaped = NULL;
+    GlyphPositions line_positions;
+    const GlyphPositions *positions = NULL;
 
-    if (!GetWrappedLines(font, text->text, length, direction, script, text->internal->x, wrap_width, trim_whitespace, &strLines, &numLines, &width, &height, false)) {
-        return false;
+    SDL_zero(line_positions);
+
+    // Shape the text once, so changing the wrap width only needs new line breaks
+    if (layout->needs_reshape ||
+        layout->shaped.font != font ||
+        layout->shaped.generation != font->generation ||
+        layout->shaped.direction != direction ||
+        layout->shaped.script != script) {
+        if (ShapeText(font, text->text, length, direction, script, &layout->shaped)) {
+            layout->needs_reshape = false;
+        }
+    }
+    if (layout->shaped.rewrappable) {
+        shaped = &layout->shaped;
+    }
+
+    // The line index is only rebuilt when the text changes, scrolling the viewport reuses it
+    if (!layout->has_wrapped_lines) {
+        if (!GetWrappedLines(font, text->text, length, direction, script, shaped, text->internal->x, wrap_width, trim_whitespace, &layout->wrapped_lines, &layout->num_wrapped_lines, &layout->wrapped_w, &layout->wrapped_h, false)) {
+            return false;
+        }
+        layout->has_wrapped_lines = true;
     }
-    height += text->internal->y;
+    strLines = layout->wrapped_lines;
+    numLines = layout->num_wrapped_lines;
+    width = layout->wrapped_w;
+    height = layout->wrapped_h + text->internal->y;
+
+    // Lay out the visible lines, and a viewport worth of lines above and below them
+    GetViewportLines(text, numLines, layout->viewport.h, &first_line, &last_line);
 
     if (TTF_HANDLE_STYLE_UNDERLINE(font)) {
         ++extra_ops;
@@ -4531,6 +8224,7 @@ static bool LayoutText(TTF_Text *text)
     }
 
     max_clusters = numLines + 1;
+    max_clusters += numLines - (last_line - first_line);
     clusters = (TTF_SubString *)SDL_calloc(max_clusters, sizeof(*clusters));
     if (!clusters) {
         goto done;
@@ -4549,8 +8243,26 @@ static bool LayoutText(TTF_Text *text)
         }
 
         // Initialize xstart, ystart and compute positions
-        if (!TTF_Size_Internal(font, strLines[i].text, strLines[i].length, direction, script, &line_width, NULL, &xstart, &ystart, NO_MEASUREMENT, false)) {
-            goto done;
+        if (i < first_line || i >= last_line) {
+            if (!MeasureWrappedLine(text, shaped, &strLines[i], direction, script)) {
+                goto done;
+            }
+            line_width = strLines[i].width;
+            xstart = strLines[i].xstart;
+            ystart = strLines[i].ystart;
+        } else if (shaped) {
+            int start = (int)(strLines[i].text - text->text);
+            int end = start + (int)strLines[i].length;
+            GetShapedTextSize(font, shaped, start, end, &line_width, NULL, &xstart, &ystart, NO_MEASUREMENT, false);
+            if (!GetShapedLine(shaped, start, end, &line_positions)) {
+                goto done;
+            }
+            positions = &line_positions;
+        } else {
+            if (!TTF_Size_Internal(font, strLines[i].text, strLines[i].length, direction, script, &line_width, NULL, &xstart, &ystart, NO_MEASUREMENT, false)) {
+                goto done;
+            }
+            positions = font->positions;
         }
 
         // Move to i-th line
@@ -4572,28 +8284,54 @@ static bool LayoutText(TTF_Text *text)
             xoffset += text->internal->x;
         }
 
+        if (i < first_line || i >= last_line) {
+            // Lines outside the viewport are a single substring, placed like the lines in it
+            cluster = &clusters[num_clusters++];
+            cluster->flags = (TTF_SubStringFlags)direction;
+            cluster->offset = (int)(uintptr_t)(strLines[i].text - text->text);
+            cluster->line_index = i;
+            cluster->rect.x = xstart + xoffset;
+            cluster->rect.y = ystart;
+            cluster->rect.w = line_width;
+            cluster->rect.h = font->height;
+
+            cluster = &clusters[num_clusters++];
+            cluster->flags = (TTF_SubStringFlags)direction | TTF_SUBSTRING_LINE_END;
+            cluster->offset = (int)(uintptr_t)(strLines[i].text - text->text + strLines[i].length);
+            cluster->line_index = i;
+            continue;
+        }
+
         // Allocate space for the operations on this line
-        additional_ops = (font->positions->len + extra_ops);
+        additional_ops = (positions->len + extra_ops);
         new_ops = (TTF_DrawOperation *)SDL_realloc(ops, (max_ops + additional_ops) * sizeof(*new_ops));
         if (!new_ops) {
             goto done;
         }
         SDL_memset(new_ops + max_ops, 0, additional_ops * sizeof(*new_ops));
         ops = new_ops;
+        if (font->render_subpixel) {
+            new_subpixel_offsets = (float *)SDL_realloc(subpixel_offsets, (max_ops + additional_ops) * sizeof(*new_subpixel_offsets));
+            if (!new_subpixel_offsets) {
+                goto done;
+            }
+            SDL_memset(new_subpixel_offsets + max_ops, 0, additional_ops * sizeof(*new_subpixel_offsets));
+            subpixel_offsets = new_subpixel_offsets;
+        }
         max_ops += additional_ops;
 
         // Allocate space for the clusters on this line
-        new_clusters = (TTF_SubString *)SDL_realloc(clusters, (max_clusters + font->positions->num_clusters) * sizeof(*new_clusters));
+        new_clusters = (TTF_SubString *)SDL_realloc(clusters, (max_clusters + positions->num_clusters) * sizeof(*new_clusters));
         if (!new_clusters) {
             goto done;
         }
-        SDL_memset(new_clusters + max_clusters, 0, font->positions->num_clusters * sizeof(*new_clusters));
+        SDL_memset(new_clusters + max_clusters, 0, positions->num_clusters * sizeof(*new_clusters));
         clusters = new_clusters;
-        max_clusters += font->positions->num_clusters;
+        max_clusters += positions->num_clusters;
         cluster_offset = (int)(uintptr_t)(strLines[i].text - text->text);
 
         // Create the text drawing operations
-        if (!Render_Line_TextEngine(font, direction, xstart + xoffset, ystart, width, height, ops, &num_ops, clusters, &num_clusters, cluster_offset, i)) {
+        if (!Render_Line_TextEngine(font, positions, direction, xstart + xoffset, ystart, width, height, ops, subpixel_offsets, &num_ops, clusters, &num_clusters, cluster_offset, i)) {
             goto done;
         }
         cluster = &clusters[num_clusters++];
@@ -4625,15 +8363,19 @@ done:
         text->internal->h = height;
         text->internal->num_ops = num_ops;
         text->internal->ops = ops;
+        text->internal->subpixel_offsets = subpixel_offsets;
         text->internal->num_clusters = num_clusters;
         text->internal->clusters = clusters;
         text->internal->layout->lines = lines;
+        text->internal->layout->first_line = first_line;
+        text->internal->layout->last_line = last_line;
     } else {
         SDL_free(ops);
+        SDL_free(subpixel_offsets);
         SDL_free(clusters);
         SDL_free(lines);
     }
-    SDL_free(strLines);
+    SDL_free(line_positions.pos);
     return result;
 }
 
@@ -4658,6 +8400,120 @@ static bool CreateEngineText(TTF_Text *text)
     return true;
 }
 
+/* Render up to max_glyphs missing glyph images of the text,
+ * and return the number of glyph operations that are ready to draw */
+static bool RenderTextGlyphs(TTF_Text *text, int max_glyphs, int *num_ready, bool *resolved)
+{
+    const TTF_TextData *data = text->internal;
+    int ready = 0;
+
+    *resolved = true;
+    for (int i = 0; i < data->num_ops; ++i) {
+        const TTF_CopyOperation *op = &data->ops[i].copy;
+        if (op->cmd != TTF_DRAW_COMMAND_COPY) {
+            continue;
+        }
+
+        const int translation = Get_OpTranslation(data, i);
+        if (!Has_GlyphImage(op->glyph_font, op->glyph_index, translation)) {
+            if (max_glyphs == 0) {
+                *resolved = false;
+                continue;
+            }
+
+            TTF_Image *image;
+            TTF_ImageType image_type;
+            if (!Find_GlyphImage(op->glyph_font, op->glyph_index, translation, &image, &image_type)) {
+                return false;
+            }
+            --max_glyphs;
+        }
+        ++ready;
+    }
+    *num_ready = ready;
+    return true;
+}
+
+// Create the engine text with only the glyphs that have been rendered so far
+static bool CreatePartialEngineText(TTF_Text *text)
+{
+    TTF_TextData *data = text->internal;
+    TTF_DrawOperation *all_ops = data->ops;
+    float *all_offsets = data->subpixel_offsets;
+    int num_all_ops = data->num_ops;
+    TTF_DrawOperation *ops;
+    float *offsets = NULL;
+    int num_ops = 0;
+    bool result;
+
+    ops = (TTF_DrawOperation *)SDL_malloc(num_all_ops * sizeof(*ops));
+    if (!ops) {
+        return false;
+    }
+    if (all_offsets) {
+        offsets = (float *)SDL_malloc(num_all_ops * sizeof(*offsets));
+        if (!offsets) {
+            SDL_free(ops);
+            return false;
+        }
+    }
+
+    for (int i = 0; i < num_all_ops; ++i) {
+        const TTF_CopyOperation *op = &all_ops[i].copy;
+        if (op->cmd == TTF_DRAW_COMMAND_COPY &&
+            !Has_GlyphImage(op->glyph_font, op->glyph_index, Get_OpTranslation(data, i))) {
+            continue;
+        }
+        SDL_copyp(&ops[num_ops], &all_ops[i]);
+        if (offsets) {
+            offsets[num_ops] = all_offsets[i];
+        }
+        ++num_ops;
+    }
+
+    // The engine sees the partial text while creating its representation
+    data->ops = ops;
+    data->num_ops = num_ops;
+    data->subpixel_offsets = offsets;
+    result = CreateEngineText(text);
+    data->ops = all_ops;
+    data->num_ops = num_all_ops;
+    data->subpixel_offsets = all_offsets;
+
+    SDL_free(ops);
+    SDL_free(offsets);
+    return result;
+}
+
+static bool UpdateEngineText(TTF_Text *text)
+{
+    TTF_TextLayout *layout = text->internal->layout;
+    int num_ready;
+
+    if (layout->incremental_glyphs <= 0 || !text->internal->engine) {
+        layout->resolved = true;
+        if (!text->internal->needs_engine_update) {
+            return true;
+        }
+        return CreateEngineText(text);
+    }
+
+    if (!RenderTextGlyphs(text, layout->incremental_glyphs, &num_ready, &layout->resolved)) {
+        return false;
+    }
+    if (!text->internal->needs_engine_update && num_ready == layout->num_ready_glyphs) {
+        // Nothing new to draw
+        return true;
+    }
+
+    DestroyEngineText(text);
+    layout->num_ready_glyphs = num_ready;
+    if (layout->resolved) {
+        return CreateEngineText(text);
+    }
+    return CreatePartialEngineText(text);
+}
+
 SDL_PropertiesID TTF_GetTextProperties(TTF_Text *text)
 {
     TTF_CHECK_POINTER("text", text, 0);
@@ -4932,6 +8788,58 @@ bool TTF_GetTextWrapWidth(TTF_Text *text, int *wrap_width)
     return true;
 }
 
+bool TTF_SetTextViewport(TTF_Text *text, const SDL_Rect *rect)
+{
+    TTF_CHECK_POINTER("text", text, false);
+
+    TTF_TextLayout *layout = text->internal->layout;
+    if (rect) {
+        if (rect->w < 0 || rect->h < 0) {
+            return SDL_InvalidParamError("rect");
+        }
+        layout->has_viewport = true;
+        SDL_copyp(&layout->viewport, rect);
+    } else if (layout->has_viewport) {
+        layout->has_viewport = false;
+        SDL_zero(layout->viewport);
+    } else {
+        return true;
+    }
+
+    if (text->internal->needs_layout_update) {
+        return true;
+    }
+
+    if (layout->shared || !layout->has_wrapped_lines) {
+        // The layout came from another text object, lay out this one on its own with the viewport
+        layout->needs_viewport_update = true;
+    } else {
+        int first_line, last_line;
+
+        // Only lay out the text again when the visible lines haven't been laid out yet
+        GetViewportLines(text, layout->num_wrapped_lines, 0, &first_line, &last_line);
+        if (first_line < layout->first_line || last_line > layout->last_line) {
+            layout->needs_viewport_update = true;
+        }
+    }
+    return true;
+}
+
+bool TTF_GetTextViewport(TTF_Text *text, SDL_Rect *rect)
+{
+    if (rect) {
+        SDL_zerop(rect);
+    }
+
+    TTF_CHECK_POINTER("text", text, false);
+    TTF_CHECK_POINTER("rect", rect, false);
+
+    if (text->internal->layout->has_viewport) {
+        SDL_copyp(rect, &text->internal->layout->viewport);
+    }
+    return true;
+}
+
 bool TTF_SetTextWrapWhitespaceVisible(TTF_Text *text, bool visible)
 {
     TTF_CHECK_POINTER("text", text, false);
@@ -4952,6 +8860,33 @@ bool TTF_TextWrapWhitespaceVisible(TTF_Text *text)
     return text->internal->layout->wrap_whitespace_visible;
 }
 
+/* Make sure the text can hold length bytes and a null terminator.
+ * The allocation grows geometrically so a series of edits is amortized O(edit) */
+static bool ReserveTextString(TTF_Text *text, size_t length)
+{
+    TTF_TextLayout *layout = text->internal->layout;
+
+    if (text->text && length < layout->text_capacity) {
+        return true;
+    }
+
+    size_t capacity = SDL_max(layout->text_capacity, 64);
+    while (capacity <= length) {
+        capacity *= 2;
+    }
+
+    char *new_string = (char *)SDL_realloc(text->text, capacity);
+    if (!new_string) {
+        return false;
+    }
+    if (!text->text) {
+        new_string[0] = '\0';
+    }
+    text->text = new_string;
+    layout->text_capacity = capacity;
+    return true;
+}
+
 bool TTF_SetTextString(TTF_Text *text, const char *string, size_t length)
 {
     TTF_CHECK_POINTER("text", text, false);
@@ -4963,12 +8898,14 @@ bool TTF_SetTextString(TTF_Text *text, const char *string, size_t length)
 
         SDL_free(text->text);
         text->text = NULL;
+        text->internal->layout->text_length = 0;
+        text->internal->layout->text_capacity = 0;
     } else {
         if (!length) {
             length = SDL_strlen(string);
         }
 
-        if (text->text && length == SDL_strlen(text->text) && SDL_memcmp(string, text->text, length) == 0) {
+        if (text->text && length == text->internal->layout->text_length && SDL_memcmp(string, text->text, length) == 0) {
             return true;
         }
 
@@ -4981,8 +8918,11 @@ bool TTF_SetTextString(TTF_Text *text, const char *string, size_t length)
 
         SDL_free(text->text);
         text->text = new_string;
+        text->internal->layout->text_length = length;
+        text->internal->layout->text_capacity = length + 1;
     }
 
+    text->internal->layout->needs_reshape = true;
     text->internal->needs_layout_update = true;
     return true;
 }
@@ -5003,12 +8943,12 @@ bool TTF_InsertTextString(TTF_Text *text, int offset, const char *string, size_t
         return TTF_SetTextString(text, string, length);
     }
 
-    int old_length = (int)SDL_strlen(text->text);
+    int old_length = (int)text->internal->layout->text_length;
     size_t new_length = old_length + length;
-    char *new_string = (char *)SDL_realloc(text->text, new_length + 1);
-    if (!new_string) {
+    if (!ReserveTextString(text, new_length)) {
         return false;
     }
+    char *new_string = text->text;
 
     if (offset < 0) {
         offset = old_length + 1 + offset;
@@ -5027,9 +8967,9 @@ bool TTF_InsertTextString(TTF_Text *text, int offset, const char *string, size_t
     }
     SDL_memcpy(new_string + offset, string, length);
     new_string[new_length] = '\0';
+    text->internal->layout->text_length = new_length;
 
-    text->text = new_string;
-
+    text->internal->layout->needs_reshape = true;
     text->internal->needs_layout_update = true;
     return true;
 }
@@ -5047,7 +8987,7 @@ bool TTF_DeleteTextString(TTF_Text *text, int offset, int length)
         return true;
     }
 
-    int old_length = (int)SDL_strlen(text->text);
+    int old_length = (int)text->internal->layout->text_length;
     if (offset < 0) {
         offset = old_length + 1 + offset;
         if (offset < 0) {
@@ -5064,12 +9004,15 @@ bool TTF_DeleteTextString(TTF_Text *text, int offset, int length)
             return TTF_SetTextString(text, NULL, 0);
         }
         text->text[offset] = '\0';
+        text->internal->layout->text_length = offset;
     } else {
         int shift = (old_length - length - offset);
         SDL_memmove(&text->text[offset], &text->text[offset + length], shift);
         text->text[offset + shift] = '\0';
+        text->internal->layout->text_length = offset + shift;
     }
 
+    text->internal->layout->needs_reshape = true;
     text->internal->needs_layout_update = true;
     return true;
 }
@@ -5126,7 +9069,7 @@ bool TTF_GetTextSubString(TTF_Text *text, int offset, TTF_SubString *substring)
         return true;
     }
 
-    int length = (int)SDL_strlen(text->text);
+    int length = (int)text->internal->layout->text_length;
     if (offset >= length) {
         SDL_copyp(substring, &clusters[num_clusters - 1]);
         return true;
@@ -5209,7 +9152,7 @@ bool TTF_GetTextSubStringForLine(TTF_Text *text, int line, TTF_SubString *substr
         SDL_copyp(substring, &clusters[lines[line - 1]]);
     }
     if (line == text->num_lines - 1) {
-        substring->length = (int)SDL_strlen(text->text) - substring->offset;
+        substring->length = (int)text->internal->layout->text_length - substring->offset;
     } else {
         substring->length = clusters[lines[line]].offset - substring->offset;
     }
@@ -5255,7 +9198,7 @@ TTF_SubString **TTF_GetTextSubStringsForRange(TTF_Text *text, int offset, int le
     }
 
     if (length < 0) {
-        length = (int)SDL_strlen(text->text);
+        length = (int)text->internal->layout->text_length;
     }
 
     TTF_SubString substring1, substring2;
@@ -5423,89 +9366,385 @@ bool TTF_GetPreviousTextSubString(TTF_Text *text, const TTF_SubString *substring
     if (substring->cluster_index < 0 || substring->cluster_index >= num_clusters) {
         return SDL_SetError("Cluster index out of range");
     }
-    if (substring->offset != clusters[substring->cluster_index].offset) {
-        return SDL_SetError("Stale substring");
+    if (substring->offset != clusters[substring->cluster_index].offset) {
+        return SDL_SetError("Stale substring");
+    }
+    if (substring->cluster_index == 0) {
+        SDL_copyp(previous, &clusters[0]);
+        previous->length = 0;
+        previous->rect.w = 0;
+    } else {
+        SDL_copyp(previous, &clusters[substring->cluster_index - 1]);
+    }
+    return true;
+}
+
+bool TTF_GetNextTextSubString(TTF_Text *text, const TTF_SubString *substring, TTF_SubString *next)
+{
+    if (next && next != substring) {
+        SDL_zerop(next);
+    }
+
+    TTF_CHECK_POINTER("text", text, false);
+    TTF_CHECK_POINTER("substring", substring, false);
+    TTF_CHECK_POINTER("next", next, false);
+
+    int num_clusters = text->internal->num_clusters;
+    const TTF_SubString *clusters = text->internal->clusters;
+    if (substring->cluster_index < 0 || substring->cluster_index >= num_clusters) {
+        return SDL_SetError("Cluster index out of range");
+    }
+    if (substring->offset != clusters[substring->cluster_index].offset) {
+        return SDL_SetError("Stale substring");
+    }
+    if (substring->cluster_index == (num_clusters - 1)) {
+        SDL_copyp(next, &clusters[num_clusters - 1]);
+    } else {
+        SDL_copyp(next, &clusters[substring->cluster_index + 1]);
+    }
+    return true;
+}
+
+static void DestroyWrappedLines(TTF_TextLayout *layout)
+{
+    if (layout->wrapped_lines) {
+        SDL_free(layout->wrapped_lines);
+        layout->wrapped_lines = NULL;
+    }
+    layout->num_wrapped_lines = 0;
+    layout->has_wrapped_lines = false;
+}
+
+static bool NeedsLayoutUpdate(TTF_Text *text)
+{
+    return (text->internal->needs_layout_update || text->internal->layout->needs_viewport_update);
+}
+
+// Clear the previous layout of the text, and return whether it needs to be laid out
+static bool PrepareLayoutText(TTF_Text *text)
+{
+    if (text->internal->needs_layout_update) {
+        DestroyWrappedLines(text->internal->layout);
+    }
+
+    DestroyEngineText(text);
+    text->internal->needs_engine_update = true;
+
+    DestroyTextLayout(text);
+    text->num_lines = 0;
+    text->internal->w = 0;
+    text->internal->h = 0;
+
+    return (text->internal->font && text->text && !AcquireSharedLayout(text));
+}
+
+static void FinishLayoutText(TTF_Text *text)
+{
+    text->internal->needs_layout_update = false;
+    text->internal->layout->needs_viewport_update = false;
+    text->internal->layout->num_ready_glyphs = -1;
+    text->internal->layout->resolved = false;
+}
+
+bool TTF_UpdateText(TTF_Text *text)
+{
+    if (NeedsLayoutUpdate(text)) {
+        if (PrepareLayoutText(text)) {
+            if (!LayoutText(text)) {
+                return false;
+            }
+            ShareTextLayout(text);
+        }
+        FinishLayoutText(text);
+    }
+
+    if (text->internal->needs_engine_update || !text->internal->layout->resolved) {
+        if (!UpdateEngineText(text)) {
+            return false;
+        }
+
+        text->internal->needs_engine_update = false;
+    }
+
+    return true;
+}
+
+// Minimum number of texts per worker before it's worth spinning up threads
+#define TTF_LAYOUT_TEXTS_PER_THREAD 32
+
+typedef struct TTF_LayoutWorker
+{
+    SDL_Thread *thread;
+    TTF_Font *font;
+    TTF_Text **texts;
+    bool *laid_out;
+    TTF_Font **layout_fonts;
+    int num_texts;
+    SDL_AtomicInt *next_text;
+} TTF_LayoutWorker;
+
+static int SDLCALL LayoutTextsThread(void *data)
+{
+    TTF_LayoutWorker *worker = (TTF_LayoutWorker *)data;
+
+    for ( ; ; ) {
+        int i = SDL_AddAtomicInt(worker->next_text, 1);
+        if (i >= worker->num_texts) {
+            break;
+        }
+
+        // Each text is only touched by one worker, laid out with the worker's copy of the font
+        TTF_Text *text = worker->texts[i];
+        TTF_Font *font = text->internal->font;
+        text->internal->font = worker->font;
+        worker->laid_out[i] = LayoutText(text);
+        worker->layout_fonts[i] = worker->font;
+        text->internal->font = font;
+    }
+    return 0;
+}
+
+// Point the layout of a text at its own font instead of the worker's copy
+static void ResolveLayoutFont(TTF_Text *text, TTF_Font *worker_font)
+{
+    TTF_TextData *data = text->internal;
+
+    for (int i = 0; i < data->num_ops; ++i) {
+        if (data->ops[i].cmd == TTF_DRAW_COMMAND_COPY && data->ops[i].copy.glyph_font == worker_font) {
+            data->ops[i].copy.glyph_font = data->font;
+        }
+    }
+
+    // The shaped text refers to glyphs cached by the worker's copy of the font
+    DestroyShapedText(&data->layout->shaped);
+    data->layout->needs_reshape = true;
+}
+
+/* Lay out texts using the same font on worker threads.
+ *
+ * Each worker gets a private copy of the font, like TTF_MeasureStrings(),
+ * so FreeType and HarfBuzz objects are never shared between threads.
+ */
+static void LayoutTextsThreaded(TTF_Font *font, TTF_Text **texts, bool *laid_out, int num_texts)
+{
+    int num_threads = SDL_min(SDL_GetNumLogicalCPUCores(), num_texts / TTF_LAYOUT_TEXTS_PER_THREAD);
+    if (num_threads < 2 || font->fallbacks || font->registry) {
+        return;
+    }
+
+    size_t datasize = 0;
+    void *data = LoadFontData(font, &datasize);
+    if (!data) {
+        return;
+    }
+
+    TTF_LayoutWorker *workers = (TTF_LayoutWorker *)SDL_calloc(num_threads, sizeof(*workers));
+    TTF_Font **layout_fonts = (TTF_Font **)SDL_calloc(num_texts, sizeof(*layout_fonts));
+    if (!workers || !layout_fonts) {
+        SDL_free(workers);
+        SDL_free(layout_fonts);
+        SDL_free(data);
+        return;
+    }
+
+    SDL_AtomicInt next_text;
+    SDL_SetAtomicInt(&next_text, 0);
+
+    // Fonts are created and destroyed on this thread, only layout runs on the workers
+    for (int i = 0; i < num_threads; ++i) {
+        TTF_LayoutWorker *worker = &workers[i];
+        worker->font = CreateMeasureFont(font, data, datasize);
+        if (!worker->font) {
+            break;
+        }
+        worker->font->horizontal_align = font->horizontal_align;
+        worker->font->lineskip = font->lineskip;
+        worker->texts = texts;
+        worker->laid_out = laid_out;
+        worker->layout_fonts = layout_fonts;
+        worker->num_texts = num_texts;
+        worker->next_text = &next_text;
+        worker->thread = SDL_CreateThread(LayoutTextsThread, "TTF_UpdateTexts", worker);
+        if (!worker->thread) {
+            break;
+        }
+    }
+
+    for (int i = 0; i < num_threads; ++i) {
+        TTF_LayoutWorker *worker = &workers[i];
+        if (worker->thread) {
+            SDL_WaitThread(worker->thread, NULL);
+        }
+    }
+
+    // Texts the workers didn't get to keep their layout state as it was
+    for (int i = 0; i < num_texts; ++i) {
+        if (layout_fonts[i]) {
+            ResolveLayoutFont(texts[i], layout_fonts[i]);
+        }
     }
-    if (substring->cluster_index == 0) {
-        SDL_copyp(previous, &clusters[0]);
-        previous->length = 0;
-        previous->rect.w = 0;
-    } else {
-        SDL_copyp(previous, &clusters[substring->cluster_index - 1]);
+
+    for (int i = 0; i < num_threads; ++i) {
+        if (workers[i].font) {
+            TTF_CloseFont(workers[i].font);
+        }
     }
-    return true;
+    SDL_free(workers);
+    SDL_free(layout_fonts);
+    SDL_free(data);
 }
 
-bool TTF_GetNextTextSubString(TTF_Text *text, const TTF_SubString *substring, TTF_SubString *next)
+// Group texts by font, with any text passed more than once next to itself
+static int SDLCALL SortLayoutTexts(const void *a, const void *b)
 {
-    if (next && next != substring) {
-        SDL_zerop(next);
-    }
-
-    TTF_CHECK_POINTER("text", text, false);
-    TTF_CHECK_POINTER("substring", substring, false);
-    TTF_CHECK_POINTER("next", next, false);
+    const TTF_Text *A = *(TTF_Text *const *)a;
+    const TTF_Text *B = *(TTF_Text *const *)b;
 
-    int num_clusters = text->internal->num_clusters;
-    const TTF_SubString *clusters = text->internal->clusters;
-    if (substring->cluster_index < 0 || substring->cluster_index >= num_clusters) {
-        return SDL_SetError("Cluster index out of range");
-    }
-    if (substring->offset != clusters[substring->cluster_index].offset) {
-        return SDL_SetError("Stale substring");
+    if (A->internal->font != B->internal->font) {
+        return ((uintptr_t)A->internal->font < (uintptr_t)B->internal->font) ? -1 : 1;
     }
-    if (substring->cluster_index == (num_clusters - 1)) {
-        SDL_copyp(next, &clusters[num_clusters - 1]);
-    } else {
-        SDL_copyp(next, &clusters[substring->cluster_index + 1]);
+    if (A == B) {
+        return 0;
     }
-    return true;
+    return ((uintptr_t)A < (uintptr_t)B) ? -1 : 1;
 }
 
-bool TTF_UpdateText(TTF_Text *text)
+bool TTF_UpdateTexts(TTF_Text **texts, int count)
 {
-    if (text->internal->needs_layout_update) {
-        DestroyEngineText(text);
-        text->internal->needs_engine_update = true;
+    TTF_Text **pending = NULL;
+    bool *laid_out = NULL;
+    int num_pending = 0;
+    bool result = false;
+
+    TTF_CHECK_POINTER("texts", texts, false);
+
+    for (int i = 0; i < count; ++i) {
+        TTF_CHECK_POINTER("texts", texts[i], false);
+    }
+
+    if (count <= 0) {
+        return true;
+    }
 
-        if (text->internal->ops) {
-            SDL_free(text->internal->ops);
-            text->internal->ops = NULL;
-            text->internal->num_ops = 0;
+    pending = (TTF_Text **)SDL_malloc(count * sizeof(*pending));
+    laid_out = (bool *)SDL_calloc(count, sizeof(*laid_out));
+    if (!pending || !laid_out) {
+        goto done;
+    }
+
+    // Collect the texts that need to be laid out, reusing shared layouts where possible
+    for (int i = 0; i < count; ++i) {
+        TTF_Text *text = texts[i];
+        if (NeedsLayoutUpdate(text)) {
+            if (PrepareLayoutText(text)) {
+                pending[num_pending++] = text;
+            } else {
+                FinishLayoutText(text);
+            }
         }
-        if (text->internal->clusters) {
-            SDL_free(text->internal->clusters);
-            text->internal->clusters = NULL;
-            text->internal->num_clusters = 0;
+    }
+
+    // Lay out each text only once, even if it was passed more than once
+    SDL_qsort(pending, num_pending, sizeof(*pending), SortLayoutTexts);
+    if (num_pending > 1) {
+        int num_unique = 1;
+        for (int i = 1; i < num_pending; ++i) {
+            if (pending[i] != pending[num_unique - 1]) {
+                pending[num_unique++] = pending[i];
+            }
         }
-        if (text->internal->layout->lines) {
-            SDL_free(text->internal->layout->lines);
-            text->internal->layout->lines = NULL;
+        num_pending = num_unique;
+    }
+
+    // Lay out each group of texts using the same font in parallel
+    for (int start = 0, end; start < num_pending; start = end) {
+        for (end = start + 1; end < num_pending; ++end) {
+            if (pending[end]->internal->font != pending[start]->internal->font) {
+                break;
+            }
         }
-        text->num_lines = 0;
-        text->internal->w = 0;
-        text->internal->h = 0;
+        LayoutTextsThreaded(pending[start]->internal->font, &pending[start], &laid_out[start], end - start);
+    }
 
-        if (text->internal->font && text->text) {
-            if (!LayoutText(text)) {
-                return false;
+    // Anything the workers didn't handle is laid out here
+    for (int i = 0; i < num_pending; ++i) {
+        TTF_Text *text = pending[i];
+        if (!laid_out[i]) {
+            if (!AcquireSharedLayout(text)) {
+                if (!LayoutText(text)) {
+                    goto done;
+                }
+                ShareTextLayout(text);
             }
+        } else {
+            ShareTextLayout(text);
         }
+        FinishLayoutText(text);
+    }
 
-        text->internal->needs_layout_update = false;
+    // Render all the glyphs once, before the text engines pack them
+    for (int i = 0; i < count; ++i) {
+        TTF_Text *text = texts[i];
+        if (text->internal->engine && text->internal->layout->incremental_glyphs <= 0 &&
+            (text->internal->needs_engine_update || !text->internal->layout->resolved)) {
+            int num_ready;
+            bool resolved;
+            if (!RenderTextGlyphs(text, SDL_MAX_SINT32, &num_ready, &resolved)) {
+                goto done;
+            }
+        }
     }
 
-    if (text->internal->needs_engine_update) {
-        if (!CreateEngineText(text)) {
-            return false;
+    // Text engines manage their own resources, so they are updated one at a time
+    for (int i = 0; i < count; ++i) {
+        if (!TTF_UpdateText(texts[i])) {
+            goto done;
         }
+    }
 
-        text->internal->needs_engine_update = false;
+    result = true;
+
+done:
+    SDL_free(pending);
+    SDL_free(laid_out);
+    return result;
+}
+
+bool TTF_SetTextIncrementalUpdate(TTF_Text *text, int max_glyphs)
+{
+    TTF_CHECK_POINTER("text", text, false);
+
+    if (max_glyphs < 0) {
+        return SDL_InvalidParamError("max_glyphs");
     }
 
+    if (text->internal->layout->incremental_glyphs != max_glyphs) {
+        text->internal->layout->incremental_glyphs = max_glyphs;
+        if (max_glyphs == 0 && !text->internal->layout->resolved) {
+            // Finish the text on the next update
+            DestroyEngineText(text);
+            text->internal->needs_engine_update = true;
+        }
+    }
     return true;
 }
 
+int TTF_GetTextIncrementalUpdate(TTF_Text *text)
+{
+    TTF_CHECK_POINTER("text", text, 0);
+
+    return text->internal->layout->incremental_glyphs;
+}
+
+bool TTF_IsTextResolved(TTF_Text *text)
+{
+    TTF_CHECK_POINTER("text", text, false);
+
+    return (!text->internal->needs_layout_update &&
+            !text->internal->needs_engine_update &&
+            text->internal->layout->resolved);
+}
+
 void TTF_DestroyText(TTF_Text *text)
 {
     if (!text) {
@@ -5513,16 +9752,9 @@ void TTF_DestroyText(TTF_Text *text)
     }
 
     DestroyEngineText(text);
-
-    if (text->internal->ops) {
-        SDL_free(text->internal->ops);
-    }
-    if (text->internal->clusters) {
-        SDL_free(text->internal->clusters);
-    }
-    if (text->internal->layout->lines) {
-        SDL_free(text->internal->layout->lines);
-    }
+    DestroyTextLayout(text);
+    DestroyWrappedLines(text->internal->layout);
+    DestroyShapedText(&text->internal->layout->shaped);
 
     TTF_SetTextFont(text, NULL);
     SDL_DestroyProperties(text->internal->props);
@@ -5535,6 +9767,71 @@ bool TTF_SetFontSize(TTF_Font *font, float ptsize)
     return TTF_SetFontSizeDPI(font, ptsize, 0, 0);
 }
 
+static FT_Pos GetBitmapStrikeSize(FT_Face face, int index)
+{
+    const FT_Bitmap_Size *size = &face->available_sizes[index];
+    if (size->y_ppem > 0) {
+        return size->y_ppem;
+    }
+    return (FT_Pos)size->height * 64;
+}
+
+/* Select the bitmap strike of a non-scalable font. Unless bitmap scaling is enabled,
+ * ptsize determines which family or series of fonts to grab from the non-scalable format.
+ * It is not the point size of the font. */
+static bool SelectBitmapStrike(TTF_Font *font, float ptsize, int vdpi, int *strike, float *scale)
+{
+    FT_Face face = font->face;
+    FT_Error error;
+    int index;
+
+    *strike = 0;
+    *scale = 0.0f;
+
+    if (face->num_fixed_sizes <= 0) {
+        return SDL_SetError("Couldn't select size : no num_fixed_sizes");
+    }
+
+    if (font->scale_bitmaps) {
+        const FT_Pos ppem = (FT_Pos)SDL_roundf(ptsize * vdpi * 64 / 72.0f); // FP 26.6
+
+        // Prefer the smallest strike that is at least as large, so glyphs are only scaled down
+        index = -1;
+        for (int i = 0; i < face->num_fixed_sizes; ++i) {
+            FT_Pos size = GetBitmapStrikeSize(face, i);
+            if (size >= ppem && (index < 0 || size < GetBitmapStrikeSize(face, index))) {
+                index = i;
+            }
+        }
+        if (index < 0) {
+            // Nothing is large enough, scale up the largest strike
+            index = 0;
+            for (int i = 1; i < face->num_fixed_sizes; ++i) {
+                if (GetBitmapStrikeSize(face, i) > GetBitmapStrikeSize(face, index)) {
+                    index = i;
+                }
+            }
+        }
+
+        FT_Pos size = GetBitmapStrikeSize(face, index);
+        if (size > 0 && size != ppem) {
+            *scale = (float)ppem / size;
+        }
+    } else {
+        // within [0; num_fixed_sizes - 1]
+        index = (int)ptsize;
+        index = SDL_max(index, 0);
+        index = SDL_min(index, face->num_fixed_sizes - 1);
+    }
+
+    error = FT_Select_Size(face, index);
+    if (error) {
+        return TTF_SetFTError("Couldn't select size", error);
+    }
+    *strike = index;
+    return true;
+}
+
 bool TTF_SetFontSizeDPI(TTF_Font *font, float ptsize, int hdpi, int vdpi)
 {
     TTF_CHECK_FONT(font, false);
@@ -5558,6 +9855,8 @@ bool TTF_SetFontSizeDPI(TTF_Font *font, float ptsize, int hdpi, int vdpi)
 
     FT_Face face = font->face;
     FT_Error error;
+    int bitmap_strike = 0;
+    float bitmap_scale = 0.0f;
 
     // Make sure that our font face is scalable (global metrics)
     if (FT_IS_SCALABLE(face)) {
@@ -5568,34 +9867,27 @@ bool TTF_SetFontSizeDPI(TTF_Font *font, float ptsize, int hdpi, int vdpi)
         if (error) {
             return TTF_SetFTError("Couldn't set font size", error);
         }
-    } else {
-        /* Non-scalable font case.  ptsize determines which family
-         * or series of fonts to grab from the non-scalable format.
-         * It is not the point size of the font.  */
-        if (face->num_fixed_sizes <= 0) {
-            return SDL_SetError("Couldn't select size : no num_fixed_sizes");
-        }
-
-        // within [0; num_fixed_sizes - 1]
-        int index = (int)ptsize;
-        index = SDL_max(index, 0);
-        index = SDL_min(index, face->num_fixed_sizes - 1);
-
-        error = FT_Select_Size(face, index);
-        if (error) {
-            return TTF_SetFTError("Couldn't select size", error);
-        }
+    } else if (!SelectBitmapStrike(font, ptsize, vdpi, &bitmap_strike, &bitmap_scale)) {
+        return false;
     }
 
+    GlyphCacheConfig prev_config;
+    Get_GlyphCacheConfig(font, &prev_config);
+    font->bitmap_strike = bitmap_strike;
+    font->bitmap_scale = bitmap_scale;
+
     TTF_InitFontMetrics(font);
 
     font->ptsize = ptsize;
     font->hdpi = hdpi;
     font->vdpi = vdpi;
 
-    Flush_Cache(font);
+    // Glyphs of recently used sizes are kept, and the SDF glyph images are independent of the font size
+    Switch_GlyphCache(font, &prev_config);
     UpdateFontText(font, NULL);
 
+    SyncRegistryFonts(font);
+
 #if TTF_USE_HARFBUZZ
     // Call when size or variations settings on underlying FT_Face change.
     hb_ft_font_changed(font->hb_font);
@@ -5633,12 +9925,12 @@ bool TTF_GetFontDPI(TTF_Font *font, int *hdpi, int *vdpi)
 
 void TTF_SetFontStyle(TTF_Font *font, TTF_FontStyleFlags style)
 {
-    TTF_FontStyleFlags prev_style;
+    GlyphCacheConfig prev_config;
     TTF_FontStyleFlags face_style;
 
     TTF_CHECK_FONT(font,);
 
-    prev_style = font->style;
+    Get_GlyphCacheConfig(font, &prev_config);
     face_style = (TTF_FontStyleFlags)font->face->style_flags;
 
     // Don't add a style if already in the font, SDL_ttf doesn't need to handle them
@@ -5657,11 +9949,10 @@ void TTF_SetFontStyle(TTF_Font *font, TTF_FontStyleFlags style)
 
     TTF_InitFontMetrics(font);
 
-    /* Flush the cache if styles that impact glyph drawing have changed */
-    if ((font->style | TTF_STYLE_NO_GLYPH_CHANGE) != (prev_style | TTF_STYLE_NO_GLYPH_CHANGE)) {
-        Flush_Cache(font);
-    }
+    // Switch glyphs if styles that impact glyph drawing have changed
+    Switch_GlyphCache(font, &prev_config);
     UpdateFontText(font, NULL);
+    SyncRegistryFonts(font);
 }
 
 TTF_FontStyleFlags TTF_GetFontStyle(const TTF_Font *font)
@@ -5687,6 +9978,8 @@ TTF_FontStyleFlags TTF_GetFontStyle(const TTF_Font *font)
 
 bool TTF_SetFontOutline(TTF_Font *font, int outline)
 {
+    GlyphCacheConfig prev_config;
+
     TTF_CHECK_FONT(font, false);
 
     outline = SDL_max(0, outline);
@@ -5719,11 +10012,13 @@ bool TTF_SetFontOutline(TTF_Font *font, int outline)
         }
     }
 
+    Get_GlyphCacheConfig(font, &prev_config);
     font->outline = outline;
 
     TTF_InitFontMetrics(font);
-    Flush_Cache(font);
+    Switch_GlyphCache(font, &prev_config);
     UpdateFontText(font, NULL);
+    SyncRegistryFonts(font);
 
     return true;
 }
@@ -5756,15 +10051,19 @@ void TTF_SetFontHinting(TTF_Font *font, TTF_HintingFlags hinting)
         return;
     }
 
+    GlyphCacheConfig prev_config;
+    Get_GlyphCacheConfig(font, &prev_config);
     font->ft_load_target = ft_load_target;
+    font->render_subpixel = render_subpixel;
 
 #if TTF_USE_HARFBUZZ
     // update flag for HB
     hb_ft_font_set_load_flags(font->hb_font, FT_LOAD_DEFAULT | font->ft_load_target);
 #endif
 
-    Flush_Cache(font);
+    Switch_GlyphCache(font, &prev_config);
     UpdateFontText(font, NULL);
+    SyncRegistryFonts(font);
 }
 
 TTF_HintingFlags TTF_GetFontHinting(const TTF_Font *font)
@@ -5789,10 +10088,14 @@ bool TTF_SetFontSDF(TTF_Font *font, bool enabled)
 {
     TTF_CHECK_FONT(font, false);
 #if TTF_USE_SDF
-    if (font->render_sdf != enabled) {
+    if (font->render_sdf != enabled || font->render_msdf) {
+        GlyphCacheConfig prev_config;
+        Get_GlyphCacheConfig(font, &prev_config);
         font->render_sdf = enabled;
-        Flush_Cache(font);
+        font->render_msdf = false;
+        Switch_GlyphCache(font, &prev_config);
         UpdateFontText(font, NULL);
+        SyncRegistryFonts(font);
     }
     return true;
 #else
@@ -5807,6 +10110,116 @@ bool TTF_GetFontSDF(const TTF_Font *font)
     return font->render_sdf;
 }
 
+bool TTF_SetFontMSDF(TTF_Font *font, bool enabled)
+{
+    TTF_CHECK_FONT(font, false);
+#if TTF_USE_SDF
+    if (font->render_msdf != enabled) {
+        GlyphCacheConfig prev_config;
+        Get_GlyphCacheConfig(font, &prev_config);
+        // MSDF glyphs are laid out like SDF glyphs
+        font->render_sdf = enabled;
+        font->render_msdf = enabled;
+        Switch_GlyphCache(font, &prev_config);
+        UpdateFontText(font, NULL);
+        SyncRegistryFonts(font);
+    }
+    return true;
+#else
+    return SDL_SetError("SDL_ttf compiled without SDF support");
+#endif
+}
+
+bool TTF_GetFontMSDF(const TTF_Font *font)
+{
+    TTF_CHECK_FONT(font, false);
+
+    return font->render_msdf;
+}
+
+bool TTF_SetFontSDFSpread(TTF_Font *font, int spread)
+{
+    TTF_CHECK_FONT(font, false);
+
+    if (spread < MIN_SDF_SPREAD || spread > MAX_SDF_SPREAD) {
+        return SDL_InvalidParamError("spread");
+    }
+
+    if (font->sdf_spread != spread) {
+        GlyphCacheConfig prev_config;
+        Get_GlyphCacheConfig(font, &prev_config);
+        font->sdf_spread = spread;
+        if (font->render_sdf) {
+            Switch_GlyphCache(font, &prev_config);
+            UpdateFontText(font, NULL);
+        }
+        SyncRegistryFonts(font);
+    }
+    return true;
+}
+
+int TTF_GetFontSDFSpread(const TTF_Font *font)
+{
+    TTF_CHECK_FONT(font, 0);
+
+    return font->sdf_spread;
+}
+
+bool TTF_SetFontSDFReferenceSize(TTF_Font *font, int size)
+{
+    TTF_CHECK_FONT(font, false);
+
+    if (size < 0) {
+        return SDL_InvalidParamError("size");
+    }
+
+    if (font->sdf_reference_size != size) {
+        if (font->sdf_size) {
+            FT_Done_Size(font->sdf_size);
+            font->sdf_size = NULL;
+        }
+        font->sdf_reference_size = size;
+        if (font->render_sdf) {
+            Flush_Cache(font);
+            UpdateFontText(font, NULL);
+        }
+        SyncRegistryFonts(font);
+    }
+    return true;
+}
+
+int TTF_GetFontSDFReferenceSize(const TTF_Font *font)
+{
+    TTF_CHECK_FONT(font, 0);
+
+    return font->sdf_reference_size;
+}
+
+bool TTF_GetFontSDFScale(TTF_Font *font, float *scale_x, float *scale_y)
+{
+    float x, y;
+
+    if (scale_x) {
+        *scale_x = 0.0f;
+    }
+    if (scale_y) {
+        *scale_y = 0.0f;
+    }
+
+    TTF_CHECK_FONT(font, false);
+
+    if (!Get_SDFScale(font, &x, &y)) {
+        return false;
+    }
+    if (scale_x) {
+        *scale_x = x;
+    }
+    if (scale_y) {
+        *scale_y = y;
+    }
+    return true;
+}
+
 int TTF_GetFontWeight(const TTF_Font *font)
 {
     TTF_CHECK_FONT(font, -1);
@@ -5906,6 +10319,31 @@ bool TTF_GetFontKerning(const TTF_Font *font)
     return font->enable_kerning;
 }
 
+void TTF_SetFontWordCache(TTF_Font *font, bool enabled)
+{
+    TTF_CHECK_FONT(font,);
+
+    if (enabled == font->enable_word_cache) {
+        return;
+    }
+
+    font->enable_word_cache = enabled;
+    if (!enabled && font->word_runs) {
+        SDL_DestroyHashTable(font->word_runs);
+        font->word_runs = NULL;
+        font->num_word_runs = 0;
+    }
+    Flush_CachedPositions(font);
+    UpdateFontText(font, NULL);
+}
+
+bool TTF_GetFontWordCache(const TTF_Font *font)
+{
+    TTF_CHECK_FONT(font, false);
+
+    return font->enable_word_cache;
+}
+
 int TTF_GetNumFontFaces(const TTF_Font *font)
 {
     TTF_CHECK_FONT(font, 0);
@@ -5927,6 +10365,51 @@ bool TTF_FontIsScalable(const TTF_Font *font)
     return FT_IS_SCALABLE(font->face);
 }
 
+bool TTF_SetFontBitmapScaling(TTF_Font *font, bool enabled)
+{
+    TTF_CHECK_FONT(font, false);
+
+    if (enabled == font->scale_bitmaps) {
+        return true;
+    }
+
+    font->scale_bitmaps = enabled;
+    if (FT_IS_SCALABLE(font->face)) {
+        return true;
+    }
+
+    // The point size has a different meaning now, so select the strike again
+    int bitmap_strike = 0;
+    float bitmap_scale = 0.0f;
+    if (!SelectBitmapStrike(font, font->ptsize, font->vdpi, &bitmap_strike, &bitmap_scale)) {
+        font->scale_bitmaps = !enabled;
+        return false;
+    }
+
+    GlyphCacheConfig prev_config;
+    Get_GlyphCacheConfig(font, &prev_config);
+    font->bitmap_strike = bitmap_strike;
+    font->bitmap_scale = bitmap_scale;
+
+    TTF_InitFontMetrics(font);
+
+    Switch_GlyphCache(font, &prev_config);
+    UpdateFontText(font, NULL);
+
+#if TTF_USE_HARFBUZZ
+    hb_ft_font_changed(font->hb_font);
+#endif
+
+    return true;
+}
+
+bool TTF_GetFontBitmapScaling(const TTF_Font *font)
+{
+    TTF_CHECK_FONT(font, false);
+
+    return font->scale_bitmaps;
+}
+
 const char *TTF_GetFontFamilyName(const TTF_Font *font)
 {
     TTF_CHECK_FONT(font, NULL);
@@ -5957,6 +10440,7 @@ bool TTF_SetFontDirection(TTF_Font *font, TTF_Direction direction)
 
     font->direction = direction;
     UpdateFontText(font, NULL);
+    SyncRegistryFonts(font);
     return true;
 }
 
@@ -6031,6 +10515,7 @@ bool TTF_SetFontScript(TTF_Font *font, Uint32 script)
 #if TTF_USE_HARFBUZZ
     font->script = script;
     UpdateFontText(font, NULL);
+    SyncRegistryFonts(font);
     return true;
 #else
     return SDL_Unsupported();
@@ -6129,6 +10614,7 @@ void TTF_CloseFont(TTF_Font *font)
     }
     Flush_Cache(font);
 
+    CloseRegistryFonts(font);
     TTF_ClearFallbackFonts(font);
     while (font->fallback_for) {
         TTF_RemoveFallbackFont(font->fallback_for->font, font);
@@ -6136,6 +10622,16 @@ void TTF_CloseFont(TTF_Font *font)
 
     SDL_DestroyHashTable(font->glyphs);
     SDL_DestroyHashTable(font->glyph_indices);
+    if (font->sdf_glyphs) {
+        SDL_DestroyHashTable(font->sdf_glyphs);
+    }
+    if (font->word_runs) {
+        SDL_DestroyHashTable(font->word_runs);
+    }
+    if (font->shared_layouts) {
+        DetachSharedLayouts(font);
+        SDL_DestroyHashTable(font->shared_layouts);
+    }
 
 #if TTF_USE_HARFBUZZ
     hb_font_destroy(font->hb_font);
@@ -0,0 +1,50 @@
+/*
+  SDL_ttf:  A companion library to SDL for working with TrueType (tm) fonts
+  Copyright (C) 2001-2026 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+// Internal interfaces shared between the font cache and the text engines
+
+/* A reference to a rasterized glyph in the font cache.
+ *
+ * The pixels stay valid while the reference is held, even if the font flushes
+ * its cache or is closed, in which case the reference takes over the buffer.
+ */
+typedef struct TTF_GlyphImage
+{
+    int refcount;
+    TTF_ImageType image_type;
+    bool is_color;
+    int width;
+    int rows;
+    int pitch;
+    const Uint8 *pixels;    // ARGB8888 if is_color is set, 8-bit values otherwise
+    void *buffer;           // The pixel buffer, once the font cache has let go of it
+    void *cached;           // The font cache entry, while it still owns the pixels
+} TTF_GlyphImage;
+
+/* Text engines cache glyphs by glyph index. Glyphs drawn at a subpixel offset
+ * are cached under a key that also holds the quantized offset, which replaces
+ * the glyph index in the engine's copy of the drawing operations.
+ */
+extern void TTF_SetGlyphKeys(const TTF_TextData *data, TTF_DrawOperation *ops);
+extern SDL_Surface *TTF_GetGlyphImageForKey(TTF_Font *font, Uint32 glyph_key, TTF_ImageType *image_type);
+
+extern TTF_GlyphImage *TTF_AcquireGlyphImage(TTF_Font *font, Uint32 glyph_key);
+extern void TTF_ReleaseGlyphImage(TTF_GlyphImage *image);